@@ -296,6 +296,9 @@ const int anochecerTargetWhite2 = 0;
 const int anochecerTargetBlue = 5; // azul sube levemente al anochecer
 
 void setup() {
+  // Serial.println copia a este búfer y vuelve; el driver de la UART lo vacía por
+  // interrupciones (sin él, cada línea espera a la FIFO de 128 bytes: ~1 ms por 11 caracteres)
+  Serial.setTxBufferSize(1024);
   Serial.begin(115200);
   
   // Deshabilitar watchdog para evitar resets durante operaciones largas
@@ -1178,22 +1181,35 @@ int nameToModo(const String &s) {
   return -1;
 }
 
+// Fragmentos fijos del payload de discovery (en flash); solo el topic es variable
+static const char DISC_P1[] = "{\"name\":\"Iluminacion\",\"unique_id\":\"iluminacion_";
+static const char DISC_P2[] = "\",\"command_topic\":\"";
+static const char DISC_P3[] = "/set\",\"state_topic\":\"";
+static const char DISC_P4[] = "\",\"options\":[\"Día\",\"Amanecer\",\"Noche\",\"Tormenta\",\"Anochecer\"]}";
+
 void publishDiscovery() {
   if (!mqttClient.connected()) return;
   // topic de discovery: homeassistant/select/<object_id>/config
-  String objectId = String(mqttTopic);
+  char objectId[sizeof(mqttTopic)];
+  strlcpy(objectId, mqttTopic, sizeof(objectId));
   // normalizar barras y caracteres no permitidos en object id
-  for (unsigned int i = 0; i < objectId.length(); ++i) if (objectId.charAt(i) == '/') objectId.setCharAt(i, '_');
-  String discTopic = String("homeassistant/select/") + objectId + String("/config");
-  // payload JSON
-  String payload = "{";
-  payload += "\"name\":\"Iluminacion\",";
-  payload += "\"unique_id\":\"iluminacion_" + objectId + "\",";
-  payload += "\"command_topic\":\"" + String(mqttTopic) + "/set\",";
-  payload += "\"state_topic\":\"" + String(mqttTopic) + "\",";
-  payload += "\"options\":[\"Día\",\"Amanecer\",\"Noche\",\"Tormenta\",\"Anochecer\"]";
-  payload += "}";
-  mqttClient.publish(discTopic.c_str(), payload.c_str(), true);
+  for (char *c = objectId; *c; ++c) if (*c == '/') *c = '_';
+  char discTopic[sizeof(mqttTopic) + 32];
+  snprintf(discTopic, sizeof(discTopic), "homeassistant/select/%s/config", objectId);
+  // payload JSON: se envía por fragmentos directamente al socket, sin String ni buffer intermedio
+  size_t topicLen = strlen(mqttTopic);
+  size_t objLen = strlen(objectId);
+  size_t total = (sizeof(DISC_P1) - 1) + objLen + (sizeof(DISC_P2) - 1) + topicLen +
+                 (sizeof(DISC_P3) - 1) + topicLen + (sizeof(DISC_P4) - 1);
+  mqttClient.beginPublish(discTopic, total, true);
+  mqttClient.write((const uint8_t*)DISC_P1, sizeof(DISC_P1) - 1);
+  mqttClient.write((const uint8_t*)objectId, objLen);
+  mqttClient.write((const uint8_t*)DISC_P2, sizeof(DISC_P2) - 1);
+  mqttClient.write((const uint8_t*)mqttTopic, topicLen);
+  mqttClient.write((const uint8_t*)DISC_P3, sizeof(DISC_P3) - 1);
+  mqttClient.write((const uint8_t*)mqttTopic, topicLen);
+  mqttClient.write((const uint8_t*)DISC_P4, sizeof(DISC_P4) - 1);
+  mqttClient.endPublish();
   Serial.print(F("[MQTT] Discovery publicado en: "));
   Serial.println(discTopic);
 }
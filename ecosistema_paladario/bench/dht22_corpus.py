@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""Genera tramas DHT22 sintéticas para dht22_corpus.txt (formato en su cabecera).
+
+Tiempos con la variación típica del sensor (respuesta 78-84us, LOW de bit 48-56us,
+HIGH 0 = 24-29us, HIGH 1 = 67-74us) a 1us, como las entrega el RMT. Semilla fija:
+la misma ejecución da siempre las mismas tramas.
+
+    python dht22_corpus.py -n 148 >> dht22_corpus.txt
+"""
+import argparse
+import random
+
+
+def trama(rng, humedad_x10, temperatura_x10):
+    h = humedad_x10
+    t = abs(temperatura_x10) | (0x8000 if temperatura_x10 < 0 else 0)
+    raw = [h >> 8, h & 0xFF, t >> 8, t & 0xFF]
+    raw.append(sum(raw) & 0xFF)
+
+    duraciones = [rng.randint(78, 84), rng.randint(78, 84)]
+    for byte in raw:
+        for i in range(7, -1, -1):
+            duraciones.append(rng.randint(48, 56))
+            duraciones.append(rng.randint(67, 74) if byte >> i & 1 else rng.randint(24, 29))
+    duraciones.append(rng.randint(48, 56))
+
+    flancos = [rng.randint(1000, 9000)]
+    for d in duraciones:
+        flancos.append(flancos[-1] + d)
+    return ''.join(f'{b:02X}' for b in raw), flancos
+
+
+def valores(rng, n):
+    """Sobre todo lecturas del paladario; también extremos del rango y bajo cero"""
+    extremos = [(0, 1), (1000, 800), (1000, -400), (1, 1), (999, -1), (500, 0), (0, -400), (1000, 1)]
+    for v in extremos[:n]:
+        yield v
+    for _ in range(n - len(extremos)):
+        if rng.random() < 0.8:
+            yield rng.randint(300, 999), rng.randint(50, 400)
+        else:
+            yield rng.randint(0, 1000), rng.randint(-400, 800)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('-n', type=int, default=148, help='Número de tramas')
+    parser.add_argument('--semilla', type=int, default=2212)
+    args = parser.parse_args()
+    rng = random.Random(args.semilla)
+    for h, t in valores(rng, args.n):
+        raw, flancos = trama(rng, h, t)
+        print(raw, 0, ' '.join(map(str, flancos)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,277 @@
+// Benchmark de host del códec del histórico (src/historia_codec.c).
+//
+// Codifica una serie de lecturas y cambios de actuadores, comprueba que se
+// decodifica sin pérdidas e informa bytes por muestra, ratio frente al registro
+// fijo de 12 bytes, días que caben en la partición "historia" (su tamaño se lee de
+// ../partitions.csv) y ns por registro.
+//
+// Datos: un CSV de GET /api/history?format=csv (capturas reales del paladario).
+// Sin archivo se usa una semana sintética: 10 s entre lecturas con fallos y
+// jitter de 1 s, calefacción por ventanas de 2 min, lluvias y cuantización a 0.1.
+//
+// También convierte una descarga binaria a CSV: --bin historia.bin
+//
+// Compilar y ejecutar (Linux):
+//   gcc -O2 -Wall -I../src -o historia_codec_bench historia_codec_bench.c ../src/historia_codec.c -lm
+//   curl -o historia.csv "http://192.168.1.88/api/history?format=csv"
+//   ./historia_codec_bench historia.csv [iteraciones]
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "historia_codec.h"
+
+#define REGISTRO_FIJO   12          // Bytes por registro del formato sin comprimir
+#define TABLA           "../partitions.csv"
+#define CABECERA_PAGINA 24
+
+static uint32_t rng_state = 0x2212u;
+
+static uint32_t rng(void) {
+    // xorshift32: determinista para que las ejecuciones sean comparables
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static int rng_range(int lo, int hi) {
+    return lo + (int)(rng() % (uint32_t)(hi - lo + 1));
+}
+
+static size_t agregar(historia_registro_t **regs, size_t *cap, size_t n, const historia_registro_t *r) {
+    if (n == *cap) {
+        *cap = *cap ? *cap * 2 : 4096;
+        *regs = realloc(*regs, *cap * sizeof(**regs));
+        if (*regs == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    (*regs)[n] = *r;
+    return n + 1;
+}
+
+static size_t cargar_csv(const char *path, historia_registro_t **regs) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        exit(1);
+    }
+    char linea[128];
+    size_t n = 0, cap = 0;
+    int16_t temp = 0;
+    uint16_t hum = 0;
+    while (fgets(linea, sizeof(linea), f)) {
+        unsigned long t;
+        char tipo;
+        unsigned act;
+        float tc, hc;
+        historia_registro_t r;
+        if (sscanf(linea, "%lu,m,%f,%f,%u", &t, &tc, &hc, &act) == 4) {
+            temp = (int16_t)lrintf(tc * 10.0f);
+            hum = (uint16_t)lrintf(hc * 10.0f);
+            tipo = 'm';
+        } else if (sscanf(linea, "%lu,a,,,%u", &t, &act) == 2) {
+            tipo = 'a';
+        } else {
+            continue;   // Cabecera o línea no reconocida
+        }
+        r = (historia_registro_t){ (uint32_t)t, (uint8_t)tipo, (uint8_t)act, temp, hum };
+        n = agregar(regs, &cap, n, &r);
+    }
+    fclose(f);
+    return n;
+}
+
+// Una semana a 10 s: ambiente con ciclo diario, calefacción PI por ventanas de 120 s
+// (como control_clima), ventilador por humedad y lluvias a horas fijas
+static size_t sintetico(historia_registro_t **regs) {
+    size_t n = 0, cap = 0;
+    uint32_t t0 = 1718000000;
+    double temp = 23.0, hum = 78.0, integral = 0.3;
+    uint8_t act = 0;
+    for (uint32_t s = 0; s < 7 * 86400; s += 10) {
+        double dia = 2 * M_PI * (s % 86400) / 86400.0;
+        double ambiente = 20.0 + 3.0 * sin(dia - 2.0);
+        double error = 24.0 - temp;
+        integral += 0.5 * error * 10 / 600;
+        integral = integral < 0 ? 0 : integral > 1 ? 1 : integral;
+        double pot = 0.5 * error + integral;
+        uint8_t nuevo = act & ~0x0Du;
+        if ((s % 120) < pot * 120) nuevo |= 0x08;                         // calefaccion
+        if (hum > 90.0 || (act & 0x04 && hum > 85.0)) nuevo |= 0x04;     // ventilador
+        if ((s % 86400) >= 8 * 3600 && (s % 86400) < 20 * 3600 && (s % 10800) < 20) nuevo |= 0x01;  // lluvia
+        if (nuevo != act) {
+            act = nuevo;
+            historia_registro_t r = { t0 + s + 1, 'a', act, 0, 0 };
+            n = agregar(regs, &cap, n, &r);
+        }
+        temp += ((ambiente - temp) / 1800.0 + (act & 0x08 ? 0.004 : 0.0)) * 10;
+        hum += ((70.0 - hum) / 2400.0 + (act & 0x01 ? 0.5 : 0.0) - (act & 0x04 ? 0.02 : 0.0)) * 10;
+        if (rng_range(1, 100) == 1) continue;   // Lectura fallida
+        historia_registro_t r = {
+            .t = t0 + s + (rng_range(1, 10) == 1),
+            .tipo = 'm',
+            .actuadores = act,
+            .temperatura = (int16_t)lrint(temp * 10.0 + rng_range(-1, 1) * (rng_range(1, 4) == 1)),
+            .humedad = (uint16_t)lrint(hum * 10.0 + rng_range(-1, 1)),
+        };
+        n = agregar(regs, &cap, n, &r);
+    }
+    return n;
+}
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Descarga binaria ("PHS2" + base + registros) a CSV
+static int binario_a_csv(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    static uint8_t buf[8 << 20];
+    size_t len = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    if (len < 4 || memcmp(buf, "PHS2", 4) != 0) {
+        fprintf(stderr, "%s: no es una descarga PHS2\n", path);
+        return 1;
+    }
+    printf("t,tipo,temperatura,humedad,actuadores\n");
+    if (len < 4 + sizeof(historia_base_t)) {
+        return 0;   // Rango vacío
+    }
+    historia_base_t base;
+    memcpy(&base, buf + 4, sizeof(base));
+    historia_codec_t c;
+    historia_codec_inicio(&c, &base);
+    historia_registro_t r;
+    size_t pos = 4 + sizeof(base);
+    int n;
+    while ((n = historia_decodificar(&c, buf + pos, len - pos, &r)) > 0) {
+        pos += n;
+        if (r.tipo == HISTORIA_MUESTRA) {
+            printf("%lu,m,%.1f,%.1f,%u\n", (unsigned long)r.t, r.temperatura / 10.0f, r.humedad / 10.0f, r.actuadores);
+        } else {
+            printf("%lu,a,,,%u\n", (unsigned long)r.t, r.actuadores);
+        }
+    }
+    if (pos != len) {
+        fprintf(stderr, "%s: datos no válidos en el byte %zu\n", path, pos);
+        return 2;
+    }
+    return 0;
+}
+
+// Tamaño de la partición "historia" en la tabla de particiones (0 si no está)
+static uint32_t tam_particion(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return 0;
+    }
+    char linea[256];
+    uint32_t tam = 0;
+    while (fgets(linea, sizeof(linea), f)) {
+        // Nombre, tipo, subtipo, offset, tamaño
+        char *campos[5];
+        int k = 0;
+        for (char *p = strtok(linea, ","); p && k < 5; p = strtok(NULL, ",")) {
+            campos[k++] = p + strspn(p, " \t");
+        }
+        if (k == 5 && strncmp(campos[0], "historia", 8) == 0) {
+            tam = (uint32_t)strtoul(campos[4], NULL, 0);
+            break;
+        }
+    }
+    fclose(f);
+    return tam;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 2 && strcmp(argv[1], "--bin") == 0) {
+        return binario_a_csv(argv[2]);
+    }
+    historia_registro_t *regs = NULL;
+    const char *fuente = argc > 1 ? argv[1] : "semana sintética";
+    size_t n = argc > 1 ? cargar_csv(argv[1], &regs) : sintetico(&regs);
+    int iteraciones = argc > 2 ? atoi(argv[2]) : 20;
+    if (n < 2) {
+        fprintf(stderr, "Sin registros: %s\n", fuente);
+        return 1;
+    }
+    uint32_t particion = tam_particion(TABLA);
+    if (particion == 0) {
+        fprintf(stderr, "Sin partición \"historia\" en %s (ejecutar desde bench/)\n", TABLA);
+        return 1;
+    }
+    size_t muestras = 0;
+    for (size_t i = 0; i < n; i++) {
+        muestras += regs[i].tipo == HISTORIA_MUESTRA;
+    }
+    double dias = (regs[n - 1].t - regs[0].t) / 86400.0;
+
+    uint8_t *cod = malloc(n * HISTORIA_CODEC_MAX);
+    historia_base_t base = { regs[0].t, regs[0].temperatura, regs[0].humedad, regs[0].actuadores };
+    historia_codec_t c;
+    size_t bytes = 0;
+    int64_t t_cod = 0, t_dec = 0;
+    int sin_perdidas = 1;
+    for (int it = 0; it < iteraciones; it++) {
+        historia_codec_inicio(&c, &base);
+        bytes = 0;
+        int64_t t = now_ns();
+        for (size_t i = 0; i < n; i++) {
+            bytes += historia_codificar(&c, &regs[i], cod + bytes);
+        }
+        t_cod += now_ns() - t;
+
+        historia_codec_inicio(&c, &base);
+        historia_registro_t r;
+        size_t pos = 0, i = 0;
+        int k;
+        t = now_ns();
+        while ((k = historia_decodificar(&c, cod + pos, bytes - pos, &r)) > 0) {
+            pos += k;
+            // En los cambios de actuadores temperatura/humedad son las últimas conocidas
+            if (i >= n || r.t != regs[i].t || r.tipo != regs[i].tipo || r.actuadores != regs[i].actuadores ||
+                (r.tipo == HISTORIA_MUESTRA &&
+                 (r.temperatura != regs[i].temperatura || r.humedad != regs[i].humedad))) {
+                sin_perdidas = 0;
+            }
+            i++;
+        }
+        t_dec += now_ns() - t;
+        if (i != n || pos != bytes) {
+            sin_perdidas = 0;
+        }
+    }
+
+    // Por página se pierde la cabecera y, de media, medio registro al final
+    double por_pagina = (4096.0 - CABECERA_PAGINA) / ((double)bytes / n);
+    double regs_dia = n / (dias > 0 ? dias : 1);
+    printf("Datos: %s, %zu registros (%zu lecturas, %zu cambios de actuadores), %.1f días\n\n",
+           fuente, n, muestras, n - muestras, dias);
+    char columna[32];
+    snprintf(columna, sizeof(columna), "días en %lu KB", (unsigned long)(particion / 1024));
+    printf("%-22s %14s %14s %14s\n", "formato", "bytes/registro", "bytes/lectura", columna);
+    printf("%-22s %14.2f %14.2f %14.1f\n", "registro fijo", (double)REGISTRO_FIJO,
+           (double)REGISTRO_FIJO * n / muestras, (particion / 4096) * ((4096.0 - 16) / REGISTRO_FIJO) / regs_dia);
+    printf("%-22s %14.2f %14.2f %14.1f\n", "códec", (double)bytes / n, (double)bytes / muestras,
+           (particion / 4096) * por_pagina / regs_dia);
+    printf("\nRatio: %.1fx   sin pérdidas: %s\n", (double)REGISTRO_FIJO * n / bytes, sin_perdidas ? "sí" : "NO");
+    printf("Codificar:   %6.1f ns/registro  (%.0f MB/s de registros fijos)\n",
+           (double)t_cod / ((double)n * iteraciones), (double)REGISTRO_FIJO * n * iteraciones / (t_cod / 1e3));
+    printf("Decodificar: %6.1f ns/registro  (%.0f MB/s de registros fijos)\n",
+           (double)t_dec / ((double)n * iteraciones), (double)REGISTRO_FIJO * n * iteraciones / (t_dec / 1e3));
+    free(cod);
+    free(regs);
+    return sin_perdidas ? 0 : 2;
+}
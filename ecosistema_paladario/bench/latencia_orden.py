@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Latencia de una orden a un relé con la gestión de energía activada y desactivada.
+
+Para cada modo (POST /api/energia) conmuta un actuador N veces con POST /api/actuator
+y mide el tiempo de ida y vuelta desde este equipo: incluye la espera en el router hasta
+la siguiente baliza cuando la WiFi del ESP32 duerme (modem sleep). Al final muestra
+también la latencia medida en el propio ESP32 (llegada de la orden -> GPIO), que da
+GET /api/energia. Entre órdenes espera un tiempo al azar para no ir sincronizado con
+las balizas.
+
+El actuador queda en manual durante CLIMA_OVERRIDE_S (1 h por defecto) y apagado al
+terminar; se restaura el modo de energía que había.
+
+    python bench/latencia_orden.py 192.168.1.88 [-n 40] [--actuador ventilador]
+"""
+import argparse
+import random
+import statistics
+import sys
+import time
+import requests
+
+
+def percentil(valores, p):
+    orden = sorted(valores)
+    return orden[min(len(orden) - 1, int(round(p / 100 * (len(orden) - 1))))]
+
+
+def medir(base, actuador, n):
+    tiempos = []
+    for i in range(n):
+        t0 = time.perf_counter()
+        r = requests.post(f"{base}/api/actuator", json={"id": actuador, "on": i % 2 == 0}, timeout=5)
+        tiempos.append((time.perf_counter() - t0) * 1000)
+        r.raise_for_status()
+        time.sleep(random.uniform(0.3, 1.2))
+    requests.post(f"{base}/api/actuator", json={"id": actuador, "on": False}, timeout=5)
+    return tiempos
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('ip')
+    parser.add_argument('-n', type=int, default=40, help="órdenes por modo")
+    parser.add_argument('--actuador', default="ventilador")
+    args = parser.parse_args()
+    base = f"http://{args.ip}"
+
+    inicial = requests.get(f"{base}/api/energia", timeout=5).json()
+    if not inicial["disponible"]:
+        print("✗ Firmware sin CONFIG_PM_ENABLE: solo hay modo fijo")
+        return 1
+
+    resultados = {}
+    dispositivo = {}
+    try:
+        for modo in ("fijo", "ahorro"):
+            requests.post(f"{base}/api/energia", json={"ahorro": modo == "ahorro"}, timeout=5).raise_for_status()
+            time.sleep(2)
+            print(f"Modo {modo}: {args.n} órdenes a {args.actuador}...")
+            resultados[modo] = medir(base, args.actuador, args.n)
+            # Antes de cambiar de modo: al volver a entrar en él se ponen a cero
+            dispositivo[modo] = requests.get(f"{base}/api/energia", timeout=5).json()["latencia"][modo]
+    finally:
+        requests.post(f"{base}/api/energia", json={"ahorro": inicial["modo"] == "ahorro"}, timeout=5)
+
+    print()
+    print(f"{'modo':<8}{'ida y vuelta (ms)':>40}{'en el ESP32 (us)':>30}")
+    print(f"{'':<8}{'min':>8}{'mediana':>10}{'p95':>8}{'max':>8}      {'n':>6}{'min':>7}{'media':>8}{'max':>8}")
+    for modo, t in resultados.items():
+        d = dispositivo[modo]
+        print(f"{modo:<8}{min(t):8.1f}{statistics.median(t):10.1f}{percentil(t, 95):8.1f}{max(t):8.1f}      "
+              f"{d['n']:6d}{d['min_us']:7d}{d['media_us']:8d}{d['max_us']:8d}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
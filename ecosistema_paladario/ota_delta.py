@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Genera parches delta de firmware para la OTA del Paladario (formato de src/ota_delta.h).
+
+El parche describe la imagen nueva como copias de la imagen base (la que está en
+ejecución en el ESP32), diferencias byte a byte respecto a ella y bytes nuevos.
+Al mover código cambian muchas direcciones: esas zonas salen como diferencias casi
+todo ceros, que luego comprimen muy bien con --deflate en upload_ota.py.
+"""
+import sys
+import struct
+import hashlib
+from collections import deque
+
+MAGIC = b'PDL1'
+BLOQUE = 16           # Longitud de la clave del índice
+PASO = 8              # Se indexa la base cada PASO bytes
+MIN_COINCIDENCIA = 24 # Menos no compensa la cabecera de 9 bytes
+VENTANA_APROX = 64    # Se sigue la coincidencia aproximada mientras acierte >= 50% aquí
+
+def sha256_imagen(datos):
+    """SHA-256 que devuelve esp_partition_get_sha256() para esta imagen: esptool añade
+    al final el hash del resto; si no lo hay, es el hash del archivo entero."""
+    if len(datos) > 32 and hashlib.sha256(datos[:-32]).digest() == datos[-32:]:
+        return datos[-32:].hex()
+    return hashlib.sha256(datos).hexdigest()
+
+def _registro(op, longitud, off=0):
+    return struct.pack('<BII', ord(op), longitud, off)
+
+def _indice(base):
+    idx = {}
+    for off in range(0, len(base) - BLOQUE + 1, PASO):
+        idx.setdefault(base[off:off + BLOQUE], off)
+    return idx
+
+def _extender_aprox(base, nuevo, p, d):
+    """Desde p, sigue el desplazamiento d (base = nuevo + d) mientras la mitad de los
+    últimos VENTANA_APROX bytes coincidan. Devuelve el final tras el último acierto."""
+    fin = p
+    aciertos = 0
+    hist = deque()
+    while p < len(nuevo) and p + d < len(base):
+        ok = nuevo[p] == base[p + d]
+        hist.append(ok)
+        aciertos += ok
+        if len(hist) > VENTANA_APROX:
+            aciertos -= hist.popleft()
+        if ok:
+            fin = p + 1
+        elif len(hist) == VENTANA_APROX and aciertos * 2 < VENTANA_APROX:
+            break
+        p += 1
+    return fin
+
+def crear_parche(base, nuevo):
+    idx = _indice(base)
+    partes = [MAGIC]
+    lit = 0   # Inicio de los bytes nuevos pendientes
+    i = 0
+    n = len(nuevo)
+
+    def literal(hasta):
+        if hasta > lit:
+            partes.append(_registro('A', hasta - lit))
+            partes.append(nuevo[lit:hasta])
+
+    while i + BLOQUE <= n:
+        b = idx.get(nuevo[i:i + BLOQUE])
+        if b is None:
+            i += 1
+            continue
+        ini, ini_b = i, b
+        while ini > lit and ini_b > 0 and nuevo[ini - 1] == base[ini_b - 1]:
+            ini -= 1
+            ini_b -= 1
+        fin, fin_b = i + BLOQUE, b + BLOQUE
+        while fin < n and fin_b < len(base) and nuevo[fin] == base[fin_b]:
+            fin += 1
+            fin_b += 1
+        if fin - ini < MIN_COINCIDENCIA:
+            i += 1
+            continue
+        fin = _extender_aprox(base, nuevo, fin, b - i)
+
+        literal(ini)
+        dif = bytes((nuevo[k] - base[k + b - i]) & 0xFF for k in range(ini, fin))
+        if dif.count(0) == len(dif):
+            partes.append(_registro('C', fin - ini, ini_b))
+        else:
+            partes.append(_registro('D', fin - ini, ini_b))
+            partes.append(dif)
+        lit = i = fin
+
+    literal(n)
+    partes.append(_registro('E', 0))
+    return b''.join(partes)
+
+def aplicar_parche(base, parche):
+    """Referencia en Python del aplicador del firmware (para comprobar el parche)."""
+    if parche[:4] != MAGIC:
+        raise ValueError("No es un parche PDL1")
+    salida = bytearray()
+    p = 4
+    while True:
+        op, longitud, off = struct.unpack_from('<BII', parche, p)
+        p += 9
+        op = chr(op)
+        if op == 'E':
+            if p != len(parche):
+                raise ValueError("Datos tras el final del parche")
+            return bytes(salida)
+        if op in 'CD' and off + longitud > len(base):
+            raise ValueError("Registro fuera de la base")
+        if op == 'C':
+            salida += base[off:off + longitud]
+        elif op == 'D':
+            salida += bytes((x + y) & 0xFF for x, y in zip(base[off:off + longitud], parche[p:p + longitud]))
+            p += longitud
+        elif op == 'A':
+            salida += parche[p:p + longitud]
+            p += longitud
+        else:
+            raise ValueError(f"Registro desconocido {op!r}")
+
+if __name__ == "__main__":
+    if len(sys.argv) < 4:
+        print("Uso: python ota_delta.py <base.bin> <nuevo.bin> <parche.pdl>")
+        print("  base.bin: la imagen que está en ejecución en el ESP32")
+        sys.exit(1)
+
+    base = open(sys.argv[1], 'rb').read()
+    nuevo = open(sys.argv[2], 'rb').read()
+    parche = crear_parche(base, nuevo)
+    if aplicar_parche(base, parche) != nuevo:
+        print("✗ Error interno: el parche no reproduce la imagen nueva")
+        sys.exit(1)
+    with open(sys.argv[3], 'wb') as f:
+        f.write(parche)
+    print(f"Base SHA-256: {sha256_imagen(base)}")
+    print(f"Parche: {len(parche)} bytes ({100 * len(parche) / len(nuevo):.1f}% de {len(nuevo)})")
@@ -0,0 +1,116 @@
+#include "actuadores.h"
+#include <stdatomic.h>
+#include <string.h>
+#include "esp_log.h"
+#include "energia.h"
+#include "estado_sistema.h"
+#include "traza.h"
+#include "wifi_config.h"
+
+static const char *TAG = "ACTUADORES";
+
+#define ACT_ENTRADA(e, id_, nombre_, uniq_, icono_, gpio_, titulo_, fem_, encl_) \
+    [e] = { .id = id_, .nombre = nombre_, .gpio = gpio_, .enclavamientos = encl_ },
+const actuador_t actuadores[ACT_NUM] = {
+    ACTUADORES(ACT_ENTRADA)
+};
+#undef ACT_ENTRADA
+
+// Escrito desde MQTT, httpd y las tareas de control: operaciones atómicas sobre la máscara
+static _Atomic uint32_t estado = 0;
+
+// Índice hash (FNV-1a, sondeo lineal) de los ids, construido una vez en el arranque
+#define INDICE_SIZE 16  // Potencia de 2, >= 2 * ACT_NUM
+_Static_assert(INDICE_SIZE >= 2 * ACT_NUM, "Ampliar INDICE_SIZE");
+static int8_t indice[INDICE_SIZE];
+
+static const char prefijo_set[] = MQTT_BASE_TOPIC "/switch/";
+#define PREFIJO_SET_LEN (sizeof(prefijo_set) - 1)
+#define SUFIJO_SET "/set"
+#define SUFIJO_SET_LEN 4
+
+static uint32_t fnv1a(const char *s, int len) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void actuadores_init(void) {
+    uint64_t mascara = 0;
+    for (int i = 0; i < ACT_NUM; i++) {
+        mascara |= 1ULL << actuadores[i].gpio;
+    }
+    gpio_config_t cfg = {
+        .pin_bit_mask = mascara,
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&cfg);
+    // Iniciar apagado (LOW=apagado, HIGH=encendido)
+    for (int i = 0; i < ACT_NUM; i++) {
+        gpio_set_level(actuadores[i].gpio, 0);
+    }
+    atomic_store(&estado, 0);
+
+    memset(indice, -1, sizeof(indice));
+    for (int i = 0; i < ACT_NUM; i++) {
+        uint32_t h = fnv1a(actuadores[i].id, strlen(actuadores[i].id));
+        while (indice[h & (INDICE_SIZE - 1)] >= 0) h++;
+        indice[h & (INDICE_SIZE - 1)] = i;
+    }
+    ESP_LOGI(TAG, "%d actuadores configurados (logica normal: HIGH=ON, LOW=OFF)", ACT_NUM);
+}
+
+void actuador_set(actuador_id_t id, bool activar) {
+    const actuador_t *a = &actuadores[id];
+    if (activar && a->enclavamientos) {
+        for (int i = 0; i < ACT_NUM; i++) {
+            if ((a->enclavamientos & ACT_BIT(i)) && actuador_activo(i)) {
+                ESP_LOGW(TAG, "Enclavamiento: %s apaga %s", a->id, actuadores[i].id);
+                actuador_set(i, false);
+            }
+        }
+    }
+    gpio_set_level(a->gpio, activar ? 1 : 0);
+    traza(TRAZA_GPIO, a->gpio, activar);
+    energia_gpio(id);
+    if (activar) {
+        atomic_fetch_or(&estado, ACT_BIT(id));
+    } else {
+        atomic_fetch_and(&estado, ~ACT_BIT(id));
+    }
+    estado_sistema_actuadores();
+    ESP_LOGI(TAG, "%s: %s (GPIO%d=%d)", a->nombre, activar ? "ON" : "OFF", a->gpio, activar ? 1 : 0);
+}
+
+bool actuador_activo(actuador_id_t id) {
+    return (atomic_load(&estado) & ACT_BIT(id)) != 0;
+}
+
+uint32_t actuadores_estado(void) {
+    return atomic_load(&estado);
+}
+
+int actuador_por_topic(const char *topic, int len) {
+    int id_len = len - (int)PREFIJO_SET_LEN - SUFIJO_SET_LEN;
+    if (id_len <= 0 ||
+        memcmp(topic, prefijo_set, PREFIJO_SET_LEN) != 0 ||
+        memcmp(topic + len - SUFIJO_SET_LEN, SUFIJO_SET, SUFIJO_SET_LEN) != 0) {
+        return -1;
+    }
+    const char *id = topic + PREFIJO_SET_LEN;
+    for (uint32_t h = fnv1a(id, id_len);; h++) {
+        int i = indice[h & (INDICE_SIZE - 1)];
+        if (i < 0) {
+            return -1;
+        }
+        if (strncmp(actuadores[i].id, id, id_len) == 0 && actuadores[i].id[id_len] == '\0') {
+            return i;
+        }
+    }
+}
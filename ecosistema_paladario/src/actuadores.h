@@ -0,0 +1,55 @@
+// Registro de actuadores (relés). Toda la configuración por relé vive en la tabla
+// ACTUADORES: GPIO, MQTT, Discovery, web y arranque se generan a partir de ella.
+// Añadir un relé = añadir una línea.
+#ifndef ACTUADORES_H
+#define ACTUADORES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driver/gpio.h"
+
+// X(enum, id, nombre HA, uniq_id, icono, GPIO, título web, femenino, enclavamientos)
+//  uniq_id/icono  -> solo Discovery (se genera en compilación, ver discovery_msgs en main.c)
+//  título web     -> solo interfaz web (se genera en compilación, ver api_actuadores_json)
+//  id             -> tópicos <base>/switch/<id>/set|state y clave en el JSON de estado
+//  femenino       -> "ENCENDIDA"/"APAGADA" en lugar de "ENCENDIDO"/"APAGADO"
+//  enclavamientos -> máscara ACT_BIT(...) de actuadores que se apagan al encender este
+#define ACTUADORES(X) \
+    X(ACT_BOMBA_LLUVIA,  "bomba_lluvia",  "Bomba Lluvia",  "paladario_lluvia",      "mdi:water",     25, "💧 Bomba Lluvia",  true,  0) \
+    X(ACT_BOMBA_CASCADA, "bomba_cascada", "Bomba Cascada", "paladario_cascada",     "mdi:waterfall", 26, "🌊 Bomba Cascada", true,  0) \
+    X(ACT_VENTILADOR,    "ventilador",    "Ventilador",    "paladario_ventilador",  "mdi:fan",       27, "🌬️ Ventilador",    false, 0) \
+    X(ACT_CALEFACCION,   "calefaccion",   "Calefaccion",   "paladario_calefaccion", "mdi:radiator",  33, "🔥 Calefacción",   true,  0)
+
+#define ACT_ENUM(e, ...) e,
+typedef enum {
+    ACTUADORES(ACT_ENUM)
+    ACT_NUM
+} actuador_id_t;
+#undef ACT_ENUM
+
+#define ACT_BIT(e) (1u << (e))
+
+typedef struct {
+    const char *id;
+    const char *nombre;
+    gpio_num_t gpio;
+    uint32_t enclavamientos;
+} actuador_t;
+
+extern const actuador_t actuadores[ACT_NUM];
+
+// Configurar los GPIO (todo apagado) y construir el índice de tópicos
+void actuadores_init(void);
+
+// Lógica NORMAL: HIGH=ON, LOW=OFF. Al encender aplica los enclavamientos.
+void actuador_set(actuador_id_t id, bool activar);
+
+bool actuador_activo(actuador_id_t id);
+
+// Máscara ACT_BIT(...) de actuadores encendidos
+uint32_t actuadores_estado(void);
+
+// Tópico <base>/switch/<id>/set -> actuador, o -1. Coincidencia exacta, O(1).
+int actuador_por_topic(const char *topic, int len);
+
+#endif // ACTUADORES_H
@@ -0,0 +1,269 @@
+#include "control_clima.h"
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "cJSON.h"
+#include "tareas.h"
+
+static const char *TAG = "CLIMA";
+
+#define US(s) ((int64_t)(s) * 1000000)
+
+// Relés que gestiona el control
+enum { RELE_CALEF, RELE_VENT, RELE_NUM };
+
+typedef struct {
+    actuador_id_t id;
+    int64_t ultimo_cambio_us;    // Para los tiempos mínimos encendido/apagado
+    int64_t override_hasta_us;   // 0 = automático
+} rele_t;
+
+// Compartido con task_sensor, httpd y MQTT: solo bajo lock
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static rele_t reles[RELE_NUM] = {
+    [RELE_CALEF] = { .id = ACT_CALEFACCION },
+    [RELE_VENT] = { .id = ACT_VENTILADOR },
+};
+static sensor_sample_t ultima;
+static bool hay_muestra = false;
+static bool automatico = true;
+static float temp_obj = CLIMA_TEMP_OBJETIVO;
+static float temp_max = CLIMA_TEMP_MAX;
+static float hum_max = CLIMA_HUM_MAX;
+static float potencia = 0.0f;    // Salida del PI (0..1), para el JSON
+
+// Solo la tarea de control
+static float integral = 0.0f;    // Término integral, ya en fracción de potencia
+static int64_t ventana_inicio_us = 0;
+static bool sensor_caducado = true;    // Hasta la primera lectura
+static TaskHandle_t tarea = NULL;
+static control_clima_cambio_t al_cambiar = NULL;
+
+static float limitar(float v, float min, float max) {
+    return v < min ? min : (v > max ? max : v);
+}
+
+// Cambiar un relé desde el control: respeta los overrides y, salvo que se fuerce
+// (sensor caído), los tiempos mínimos. true si cambió.
+static bool conmutar(int r, bool activar, int64_t ahora, bool forzar) {
+    actuador_id_t id = reles[r].id;
+    if (actuador_activo(id) == activar) {
+        return false;
+    }
+    int64_t minimo = US(activar ? CLIMA_MIN_OFF_S : CLIMA_MIN_ON_S);
+    portENTER_CRITICAL(&lock);
+    bool puede = reles[r].override_hasta_us == 0 && (forzar || ahora - reles[r].ultimo_cambio_us >= minimo);
+    if (puede) {
+        reles[r].ultimo_cambio_us = ahora;
+    }
+    portEXIT_CRITICAL(&lock);
+    if (puede) {
+        actuador_set(id, activar);
+    }
+    return puede;
+}
+
+// PI con anti-windup por integración condicional y ventana de tiempo proporcional:
+// la potencia es la fracción de cada ventana con el relé encendido.
+static bool regular_calefaccion(float t, float obj, float dt_s, bool manual, int64_t ahora) {
+    float error = obj - t;
+    float p = CLIMA_KP * error;
+    if (!manual) {
+        float salida = p + integral;
+        if ((salida < 1.0f || error < 0.0f) && (salida > 0.0f || error > 0.0f)) {
+            integral = limitar(integral + CLIMA_KP * error * dt_s / CLIMA_TI_S, 0.0f, 1.0f);
+        }
+    }
+    float pot = limitar(p + integral, 0.0f, 1.0f);
+    portENTER_CRITICAL(&lock);
+    potencia = pot;
+    portEXIT_CRITICAL(&lock);
+
+    while (ahora - ventana_inicio_us >= US(CLIMA_VENTANA_S)) {
+        ventana_inicio_us += US(CLIMA_VENTANA_S);
+    }
+    int64_t on_us = (int64_t)(pot * US(CLIMA_VENTANA_S));
+    if (on_us < US(CLIMA_MIN_ON_S)) {
+        on_us = 0;                        // Pulso más corto que el mínimo: no se enciende
+    } else if (US(CLIMA_VENTANA_S) - on_us < US(CLIMA_MIN_OFF_S)) {
+        on_us = US(CLIMA_VENTANA_S);      // Hueco más corto que el mínimo: toda la ventana
+    }
+    return conmutar(RELE_CALEF, ahora - ventana_inicio_us < on_us, ahora, false);
+}
+
+// Histéresis: enciende por encima de cualquiera de los límites y apaga cuando
+// ambos quedan por debajo de su banda
+static bool regular_ventilador(float t, float h, float t_max, float h_max, int64_t ahora) {
+    bool activar = actuador_activo(ACT_VENTILADOR);
+    if (t > t_max || h > h_max) {
+        activar = true;
+    } else if (t < t_max - CLIMA_HIST_TEMP && h < h_max - CLIMA_HIST_HUM) {
+        activar = false;
+    }
+    return conmutar(RELE_VENT, activar, ahora, false);
+}
+
+static void task_control_clima(void *arg) {
+    int64_t anterior = esp_timer_get_time();
+    ventana_inicio_us = anterior;
+    while (1) {
+        // Despierta con cada muestra o, como mucho, un periodo después de la anterior pasada
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CLIMA_PERIODO_MS));
+        int64_t ahora = esp_timer_get_time();
+        float dt_s = (ahora - anterior) / 1e6f;
+        anterior = ahora;
+
+        bool manual[RELE_NUM];
+        portENTER_CRITICAL(&lock);
+        sensor_sample_t m = ultima;
+        bool hay = hay_muestra;
+        bool autom = automatico;
+        float obj = temp_obj, t_max = temp_max, h_max = hum_max;
+        bool expirado[RELE_NUM];
+        for (int r = 0; r < RELE_NUM; r++) {
+            expirado[r] = reles[r].override_hasta_us != 0 && ahora >= reles[r].override_hasta_us;
+            if (expirado[r]) {
+                reles[r].override_hasta_us = 0;
+            }
+            manual[r] = reles[r].override_hasta_us != 0;
+        }
+        portEXIT_CRITICAL(&lock);
+
+        for (int r = 0; r < RELE_NUM; r++) {
+            if (expirado[r]) {
+                ESP_LOGI(TAG, "%s vuelve a automático", actuadores[reles[r].id].id);
+            }
+        }
+        if (!autom) {
+            continue;
+        }
+
+        bool cambio = false;
+        if (!hay || ahora - m.timestamp_us > US(CLIMA_MUESTRA_MAX_S)) {
+            // Sin lecturas fiables no se regula: todo apagado (los overrides se respetan)
+            if (!sensor_caducado) {
+                ESP_LOGW(TAG, "Sin lecturas del sensor en %d s: calefacción y ventilador apagados", CLIMA_MUESTRA_MAX_S);
+                sensor_caducado = true;
+            }
+            integral = 0.0f;
+            cambio |= conmutar(RELE_CALEF, false, ahora, true);
+            cambio |= conmutar(RELE_VENT, false, ahora, true);
+        } else {
+            sensor_caducado = false;
+            cambio |= regular_calefaccion(m.temperatura, obj, dt_s, manual[RELE_CALEF], ahora);
+            cambio |= regular_ventilador(m.temperatura, m.humedad, t_max, h_max, ahora);
+        }
+        if (cambio && al_cambiar) {
+            al_cambiar();
+        }
+    }
+}
+
+void control_clima_init(control_clima_cambio_t cb) {
+    al_cambiar = cb;
+    tarea = tarea_crear(TAREA_CLIMA, task_control_clima, NULL);
+    ESP_LOGI(TAG, "Control de clima: %.1f°C, ventilar > %.1f°C o > %.0f%%", temp_obj, temp_max, hum_max);
+}
+
+void control_clima_muestra(const sensor_sample_t *m) {
+    portENTER_CRITICAL(&lock);
+    ultima = *m;
+    hay_muestra = true;
+    portEXIT_CRITICAL(&lock);
+    if (tarea) {
+        xTaskNotifyGive(tarea);
+    }
+}
+
+void control_clima_manual(actuador_id_t id, bool activar) {
+    int64_t ahora = esp_timer_get_time();
+    bool gestionado = false;
+    portENTER_CRITICAL(&lock);
+    for (int r = 0; r < RELE_NUM; r++) {
+        if (reles[r].id == id) {
+            reles[r].override_hasta_us = ahora + US(CLIMA_OVERRIDE_S);
+            reles[r].ultimo_cambio_us = ahora;
+            gestionado = true;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+    if (gestionado) {
+        ESP_LOGI(TAG, "%s en manual durante %d s", actuadores[id].id, CLIMA_OVERRIDE_S);
+    }
+    actuador_set(id, activar);
+}
+
+// Número dentro de [min, max] o ausente (se deja *v igual)
+static bool leer_numero(const cJSON *json, const char *clave, float min, float max, float *v) {
+    const cJSON *n = cJSON_GetObjectItemCaseSensitive(json, clave);
+    if (n == NULL) {
+        return true;
+    }
+    if (!cJSON_IsNumber(n) || n->valuedouble < min || n->valuedouble > max) {
+        return false;
+    }
+    *v = (float)n->valuedouble;
+    return true;
+}
+
+bool control_clima_config_json(const char *json, size_t len) {
+    cJSON *raiz = cJSON_ParseWithLength(json, len);
+    portENTER_CRITICAL(&lock);
+    float obj = temp_obj, t_max = temp_max, h_max = hum_max;
+    portEXIT_CRITICAL(&lock);
+
+    const cJSON *autom = cJSON_GetObjectItemCaseSensitive(raiz, "auto");
+    bool ok = cJSON_IsObject(raiz) &&
+              (autom == NULL || cJSON_IsBool(autom)) &&
+              leer_numero(raiz, "temp_obj", 5.0f, 35.0f, &obj) &&
+              leer_numero(raiz, "temp_max", 5.0f, 45.0f, &t_max) &&
+              leer_numero(raiz, "hum_max", 20.0f, 100.0f, &h_max) &&
+              t_max > obj;
+    if (ok) {
+        portENTER_CRITICAL(&lock);
+        temp_obj = obj;
+        temp_max = t_max;
+        hum_max = h_max;
+        if (autom != NULL) {
+            automatico = cJSON_IsTrue(autom);
+            for (int r = 0; automatico && r < RELE_NUM; r++) {
+                reles[r].override_hasta_us = 0;
+            }
+        }
+        portEXIT_CRITICAL(&lock);
+        ESP_LOGI(TAG, "Consignas: %.1f°C, ventilar > %.1f°C o > %.0f%%, %s", obj, t_max, h_max,
+                 automatico ? "automático" : "manual");
+        if (tarea) {
+            xTaskNotifyGive(tarea);
+        }
+    }
+    cJSON_Delete(raiz);
+    return ok;
+}
+
+int control_clima_json(char *buf, size_t len) {
+    int64_t ahora = esp_timer_get_time();
+    int64_t override_s[RELE_NUM];
+    portENTER_CRITICAL(&lock);
+    bool autom = automatico;
+    float obj = temp_obj, t_max = temp_max, h_max = hum_max, pot = potencia;
+    for (int r = 0; r < RELE_NUM; r++) {
+        override_s[r] = reles[r].override_hasta_us ? (reles[r].override_hasta_us - ahora) / 1000000 : 0;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    int n = snprintf(buf, len, "{\"auto\":%s,\"temp_obj\":%.1f,\"temp_max\":%.1f,\"hum_max\":%.0f,"
+                     "\"potencia\":%d,\"sensor_ok\":%s",
+                     autom ? "true" : "false", obj, t_max, h_max, (int)(pot * 100.0f + 0.5f),
+                     sensor_caducado ? "false" : "true");
+    for (int r = 0; r < RELE_NUM && n > 0 && (size_t)n < len; r++) {
+        n += snprintf(buf + n, len - n, ",\"override_%s\":%lld", actuadores[reles[r].id].id,
+                      (long long)(override_s[r] > 0 ? override_s[r] : 0));
+    }
+    if (n > 0 && (size_t)n < len) {
+        n += snprintf(buf + n, len - n, "}");
+    }
+    return n;
+}
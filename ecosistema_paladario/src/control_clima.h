@@ -0,0 +1,75 @@
+// Control de clima en el propio ESP32: calefacción con PI y ventana de tiempo
+// proporcional, ventilador con histéresis sobre humedad y temperatura. Funciona
+// sin WiFi ni broker; Home Assistant y la web solo cambian consignas o fuerzan
+// un relé (override manual temporal).
+#ifndef CONTROL_CLIMA_H
+#define CONTROL_CLIMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "actuadores.h"
+#include "sample_ring.h"
+#include "wifi_config.h"
+
+// Valores por defecto; se pueden redefinir en wifi_config.h
+#ifndef CLIMA_TEMP_OBJETIVO
+#define CLIMA_TEMP_OBJETIVO 24.0f      // °C, consigna de la calefacción
+#endif
+#ifndef CLIMA_TEMP_MAX
+#define CLIMA_TEMP_MAX 28.0f           // °C, por encima se ventila
+#endif
+#ifndef CLIMA_HUM_MAX
+#define CLIMA_HUM_MAX 90.0f            // %, por encima se ventila
+#endif
+#ifndef CLIMA_HIST_TEMP
+#define CLIMA_HIST_TEMP 0.5f           // °C por debajo de TEMP_MAX para parar el ventilador
+#endif
+#ifndef CLIMA_HIST_HUM
+#define CLIMA_HIST_HUM 5.0f            // % por debajo de HUM_MAX para parar el ventilador
+#endif
+#ifndef CLIMA_KP
+#define CLIMA_KP 0.5f                  // Fracción de potencia por °C de error
+#endif
+#ifndef CLIMA_TI_S
+#define CLIMA_TI_S 600.0f              // Tiempo integral
+#endif
+#ifndef CLIMA_PERIODO_MS
+#define CLIMA_PERIODO_MS 1000          // Periodo del lazo (además despierta con cada muestra)
+#endif
+#ifndef CLIMA_VENTANA_S
+#define CLIMA_VENTANA_S 120            // Ventana de tiempo proporcional de la calefacción
+#endif
+#ifndef CLIMA_MIN_ON_S
+#define CLIMA_MIN_ON_S 20              // Tiempo mínimo encendido (protege los relés)
+#endif
+#ifndef CLIMA_MIN_OFF_S
+#define CLIMA_MIN_OFF_S 20             // Tiempo mínimo apagado
+#endif
+#ifndef CLIMA_MUESTRA_MAX_S
+#define CLIMA_MUESTRA_MAX_S 60         // Sin lecturas válidas más tiempo -> todo apagado
+#endif
+#ifndef CLIMA_OVERRIDE_S
+#define CLIMA_OVERRIDE_S 3600          // Duración de una orden manual antes de volver al automático
+#endif
+
+// Avisado cada vez que el control cambia un relé (para publicar el estado)
+typedef void (*control_clima_cambio_t)(void);
+
+// Arrancar la tarea de control
+void control_clima_init(control_clima_cambio_t al_cambiar);
+
+// Nueva lectura válida del sensor (desde task_sensor; no bloquea)
+void control_clima_muestra(const sensor_sample_t *m);
+
+// Orden manual de cualquier actuador (web, MQTT). Si lo gestiona el control,
+// queda en manual CLIMA_OVERRIDE_S segundos.
+void control_clima_manual(actuador_id_t id, bool activar);
+
+// Aplicar un JSON con cualquier subconjunto de {"auto":bool,"temp_obj":n,"temp_max":n,"hum_max":n}.
+// "auto":true cancela además los overrides. false si el JSON no es válido o está fuera de rango.
+bool control_clima_config_json(const char *json, size_t len);
+
+// Estado del control en JSON; devuelve la longitud (como snprintf)
+int control_clima_json(char *buf, size_t len);
+
+#endif // CONTROL_CLIMA_H
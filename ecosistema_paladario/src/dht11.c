@@ -1,128 +1,175 @@
 #include "dht11.h"
+#include "dht_decoder.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "rom/ets_sys.h"
+#include "freertos/queue.h"
+#include "driver/rmt_rx.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "energia.h"
+#include "esp_timer.h"
+#include "metricas.h"
+#include "traza.h"
 
-#define DHT11_TIMEOUT 8000
+// Captura por RMT: el periférico registra la duración de cada nivel en hardware,
+// así que las interrupciones siguen habilitadas durante toda la trama.
+#define DHT_RMT_RESOLUTION_HZ 1000000   // 1 tick = 1us
+#define DHT_RMT_MEM_SYMBOLS   64        // Un bloque RMT (ESP32): 128 niveles, trama DHT22 ~86
+#define DHT_RMT_FILTER_NS     1000      // Ignorar glitches < 1us
+#define DHT_RMT_IDLE_NS       200000    // 200us sin flancos = fin de trama
+#define DHT_START_LOW_MS      20        // Señal de inicio LOW (especificación DHT22: >= 1ms)
+#define DHT_FRAME_TIMEOUT_MS  50        // La trama completa dura ~5ms
 
 static const char *TAG = "DHT22";
 
-static int wait_for_state(gpio_num_t pin, int state, int timeout) {
-    int count = 0;
-    while (gpio_get_level(pin) != state) {
-        if (count++ > timeout) {
-            return -1;
+static rmt_channel_handle_t rx_chan = NULL;
+static QueueHandle_t rx_queue = NULL;
+static gpio_num_t rx_pin = GPIO_NUM_NC;
+static rmt_symbol_word_t rx_symbols[DHT_RMT_MEM_SYMBOLS];
+
+static bool IRAM_ATTR rmt_rx_done_cb(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *edata, void *user_data) {
+    BaseType_t despertar = pdFALSE;
+    xQueueSendFromISR((QueueHandle_t)user_data, edata, &despertar);
+    return despertar == pdTRUE;
+}
+
+// Crear (una sola vez por pin) el canal RMT de recepción. Queda deshabilitado entre
+// lecturas: habilitado, el driver mantiene el APB a tope y la CPU no podría bajar de
+// frecuencia ni dormir (energia.h).
+static esp_err_t rmt_setup(gpio_num_t pin) {
+    if (rx_chan != NULL && rx_pin == pin) {
+        return ESP_OK;
+    }
+    if (rx_chan != NULL) {
+        rmt_del_channel(rx_chan);
+        rx_chan = NULL;
+    }
+    if (rx_queue == NULL) {
+        rx_queue = xQueueCreate(1, sizeof(rmt_rx_done_event_data_t));
+        if (rx_queue == NULL) {
+            return ESP_ERR_NO_MEM;
         }
-        ets_delay_us(1);
     }
-    return count;
+
+    rmt_rx_channel_config_t rx_cfg = {
+        .gpio_num = pin,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = DHT_RMT_RESOLUTION_HZ,
+        .mem_block_symbols = DHT_RMT_MEM_SYMBOLS,
+    };
+    esp_err_t err = rmt_new_rx_channel(&rx_cfg, &rx_chan);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No se pudo crear canal RMT RX: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    rmt_rx_event_callbacks_t cbs = {
+        .on_recv_done = rmt_rx_done_cb,
+    };
+    ESP_ERROR_CHECK(rmt_rx_register_event_callbacks(rx_chan, &cbs, rx_queue));
+    rx_pin = pin;
+
+    // El mismo pin se usa como salida open-drain para la señal de inicio;
+    // la entrada sigue conectada al RMT a través de la matriz GPIO.
+    gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
+    gpio_set_level(pin, 1);
+    return ESP_OK;
 }
 
-esp_err_t dht11_read(gpio_num_t pin, float *humidity, float *temperature) {
-    uint8_t data[5] = {0};
-    
-    // Señal de inicio: configurar como salida
-    gpio_set_direction(pin, GPIO_MODE_OUTPUT);
+static esp_err_t leer(gpio_num_t pin, float *humidity, float *temperature) {
+
+    // Línea en reposo (HIGH) antes del start
     gpio_set_level(pin, 1);
     vTaskDelay(pdMS_TO_TICKS(100));  // Estabilización previa al start
-    
-    // Deshabilitar interrupciones
-    taskDISABLE_INTERRUPTS();
-    
-    // Señal de inicio: LOW por ~20ms (especificación DHT22)
+    xQueueReset(rx_queue);
+
+    // Señal de inicio: LOW por ~20ms (sin bloquear interrupciones)
     gpio_set_level(pin, 0);
-    ets_delay_us(20000);
-    
-    // HIGH por ~40us
+    vTaskDelay(pdMS_TO_TICKS(DHT_START_LOW_MS));
+
+    // Armar el receptor antes de soltar la línea: la captura empieza en el primer flanco
+    rmt_receive_config_t rx_cfg = {
+        .signal_range_min_ns = DHT_RMT_FILTER_NS,
+        .signal_range_max_ns = DHT_RMT_IDLE_NS,
+    };
+    esp_err_t err = rmt_receive(rx_chan, rx_symbols, sizeof(rx_symbols), &rx_cfg);
     gpio_set_level(pin, 1);
-    ets_delay_us(40);
-    
-    // Cambiar a entrada y asegurar pull-up interno
-    gpio_set_direction(pin, GPIO_MODE_INPUT);
-    gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
-    
-    // Esperar respuesta del sensor: LOW de 80us
-    if (wait_for_state(pin, 0, DHT11_TIMEOUT) < 0) {
-        taskENABLE_INTERRUPTS();
-        ESP_LOGE(TAG, "Timeout: Sensor no responde (esperando LOW)");
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "rmt_receive falló: %s", esp_err_to_name(err));
+        metricas_dht_fallo(DHT_FALLO_RECEPCION);
         return ESP_FAIL;
     }
-    
-    // Esperar HIGH de 80us
-    if (wait_for_state(pin, 1, DHT11_TIMEOUT) < 0) {
-        taskENABLE_INTERRUPTS();
-        ESP_LOGE(TAG, "Timeout: Sensor no envía HIGH de confirmación");
+
+    rmt_rx_done_event_data_t rx_data;
+    if (xQueueReceive(rx_queue, &rx_data, pdMS_TO_TICKS(DHT_FRAME_TIMEOUT_MS)) != pdTRUE) {
+        // La recepción pendiente se cancela al deshabilitar el canal (dht11_read)
+        ESP_LOGE(TAG, "Timeout: Sensor no responde (sin trama RMT)");
+        metricas_dht_fallo(DHT_FALLO_TIMEOUT);
         return ESP_FAIL;
     }
-    
-    // Esperar que vuelva a LOW para comenzar transmisión
-    if (wait_for_state(pin, 0, DHT11_TIMEOUT) < 0) {
-        taskENABLE_INTERRUPTS();
-        ESP_LOGE(TAG, "Timeout: Inicio de transmisión");
-        return ESP_FAIL;
+
+    // Recoger las duraciones de los pulsos HIGH; el decodificador usa los últimos 40
+    uint16_t highs[2 * DHT_RMT_MEM_SYMBOLS];
+    size_t n_highs = 0;
+    for (size_t i = 0; i < rx_data.num_symbols; i++) {
+        const rmt_symbol_word_t *s = &rx_data.received_symbols[i];
+        // Duración 0 marca el nivel en reposo que cerró la captura
+        if (s->level0 && s->duration0) highs[n_highs++] = s->duration0;
+        if (s->level1 && s->duration1) highs[n_highs++] = s->duration1;
     }
-    
-    // Leer 40 bits de datos
-    for (int i = 0; i < 40; i++) {
-        // Esperar HIGH (inicio de bit)
-        if (wait_for_state(pin, 1, DHT11_TIMEOUT) < 0) {
-            taskENABLE_INTERRUPTS();
-            ESP_LOGE(TAG, "Timeout en bit %d (esperando HIGH)", i);
+
+    dht_reading_t lectura = {0};
+    dht_decode_status_t st = dht_decode_pulses(highs, n_highs, 0, &lectura);
+    const uint8_t *data = lectura.raw;
+    switch (st) {
+        case DHT_DECODE_OK:
+            break;
+        case DHT_DECODE_ERR_SHORT:
+            ESP_LOGE(TAG, "Trama incompleta: %d pulsos HIGH (%d símbolos)", (int)n_highs, (int)rx_data.num_symbols);
+            metricas_dht_fallo(DHT_FALLO_TRAMA_CORTA);
             return ESP_FAIL;
-        }
-        
-        // Medir duración del pulso HIGH
-        int high_time = wait_for_state(pin, 0, DHT11_TIMEOUT);
-        if (high_time < 0) {
-            taskENABLE_INTERRUPTS();
-            ESP_LOGE(TAG, "Timeout en bit %d (esperando LOW)", i);
+        case DHT_DECODE_ERR_RANGE:
+            ESP_LOGW(TAG, "Valores fuera de rango: H=%.1f%% T=%.1f°C",
+                     lectura.humidity_x10 / 10.0f, lectura.temperature_x10 / 10.0f);
+            metricas_dht_fallo(DHT_FALLO_RANGO);
+            return ESP_FAIL;
+        default:
+            ESP_LOGE(TAG, "Trama inválida (%s, umbral %dus)", dht_decode_status_str(st), lectura.threshold_us);
+            ESP_LOGE(TAG, "Raw: %02X %02X %02X %02X %02X", data[0], data[1], data[2], data[3], data[4]);
+            metricas_dht_fallo(st == DHT_DECODE_ERR_CHECKSUM ? DHT_FALLO_CHECKSUM :
+                               st == DHT_DECODE_ERR_NULL ? DHT_FALLO_CEROS : DHT_FALLO_TIEMPOS);
             return ESP_FAIL;
-        }
-        
-        // Determinar si es 0 o 1 (>50us = 1, <50us = 0)
-        data[i / 8] <<= 1;
-        if (high_time > 50) {
-            data[i / 8] |= 1;
-        }
-    }
-    
-    taskENABLE_INTERRUPTS();
-    
-    // Verificar checksum
-    uint8_t checksum = (data[0] + data[1] + data[2] + data[3]) & 0xFF;
-    if (data[4] != checksum) {
-        ESP_LOGE(TAG, "Checksum error: calc=0x%02X recv=0x%02X", checksum, data[4]);
-        ESP_LOGE(TAG, "Raw: %02X %02X %02X %02X %02X", data[0], data[1], data[2], data[3], data[4]);
-        return ESP_FAIL;
-    }
-    // Lectura nula (todos ceros) no es válida
-    if (data[0] == 0 && data[1] == 0 && data[2] == 0 && data[3] == 0 && data[4] == 0) {
-        ESP_LOGE(TAG, "Lectura nula: Raw 00 00 00 00 00");
-        return ESP_FAIL;
-    }
-    
-    // Extraer valores (DHT22: 16 bits por valor, con decimales)
-    int16_t hum = (data[0] << 8) | data[1];
-    int16_t temp = (data[2] << 8) | data[3];
-    
-    // DHT22 puede tener temperatura negativa (bit más alto indica signo)
-    if (temp & 0x8000) {
-        temp = -(temp & 0x7FFF);
-    }
-    
-    *humidity = (float)hum / 10.0f;
-    *temperature = (float)temp / 10.0f;
-    
-    // Validar rangos DHT22: Humedad 0-100%, Temperatura -40 a 80°C
-    if (*humidity < 0.0f || *humidity > 100.0f || *temperature < -40.0f || *temperature > 80.0f) {
-        ESP_LOGW(TAG, "Valores fuera de rango: H=%.1f%% T=%.1f°C", *humidity, *temperature);
-        return ESP_FAIL;
     }
-    
+
+    *humidity = lectura.humidity_x10 / 10.0f;
+    *temperature = lectura.temperature_x10 / 10.0f;
+
     ESP_LOGI(TAG, "✓ DHT22: H=%.1f%% T=%.1f°C (Raw %02X %02X %02X %02X %02X)", *humidity, *temperature,
              data[0], data[1], data[2], data[3], data[4]);
-    
+
     return ESP_OK;
 }
-// DHT22 (AM2302) reader implemented here
+
+// CPU a tope y RMT habilitado solo durante la lectura (~130 ms)
+esp_err_t dht11_read(gpio_num_t pin, float *humidity, float *temperature) {
+    traza(TRAZA_DHT_INICIO, pin, 0);
+    if (rmt_setup(pin) != ESP_OK) {
+        traza(TRAZA_DHT_FIN, pin, ESP_FAIL);
+        metricas_dht_fallo(DHT_FALLO_RMT);
+        return ESP_FAIL;
+    }
+    int64_t t0 = esp_timer_get_time();
+    energia_bloquear();
+    esp_err_t err = rmt_enable(rx_chan);
+    if (err == ESP_OK) {
+        err = leer(pin, humidity, temperature);
+        rmt_disable(rx_chan);
+    } else {
+        metricas_dht_fallo(DHT_FALLO_RMT);
+    }
+    energia_liberar();
+    metricas_dht_lectura((uint32_t)(esp_timer_get_time() - t0));
+    traza(TRAZA_DHT_FIN, pin, (uint32_t)err);
+    return err;
+}
@@ -0,0 +1,49 @@
+#include "dht22_arduino.h"
+#include "dht_decoder.h"
+
+// Respuesta (3 flancos) + 40 bits (80) + subida final; margen para glitches
+static const int MAX_EDGES = 100;
+static const uint32_t EDGE_TIMEOUT_US = 200; // Sin flancos -> fin de trama
+
+bool dht22Read(int pin, float &humidity, float &temperature) {
+  uint32_t edges[MAX_EDGES];
+  int nEdges = 0;
+
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, HIGH);
+  delay(100);
+
+  // Start: LOW 20ms (con interrupciones habilitadas)
+  digitalWrite(pin, LOW);
+  delay(20);
+
+  // Solo la trama (~5ms) se captura con interrupciones deshabilitadas
+  noInterrupts();
+  digitalWrite(pin, HIGH);
+  pinMode(pin, INPUT_PULLUP);
+
+  int level = HIGH;
+  uint32_t last = micros();
+  uint32_t timeout = 1000; // El sensor responde en 20-40us; margen para el primer flanco
+  while (nEdges < MAX_EDGES) {
+    uint32_t now = micros();
+    int l = digitalRead(pin);
+    if (l != level) {
+      edges[nEdges++] = now;
+      level = l;
+      last = now;
+      timeout = EDGE_TIMEOUT_US;
+    } else if (now - last > timeout) {
+      break;
+    }
+  }
+  interrupts();
+
+  // edges[0] es la bajada de respuesta del sensor
+  dht_reading_t r;
+  if (dht_decode_edges(edges, nEdges, LOW, 0, &r) != DHT_DECODE_OK) return false;
+
+  humidity = r.humidity_x10 / 10.0f;
+  temperature = r.temperature_x10 / 10.0f;
+  return true;
+}
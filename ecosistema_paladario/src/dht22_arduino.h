@@ -0,0 +1,5 @@
+#pragma once
+// Lectura DHT22 para los sketches Arduino: captura de flancos + decodificador compartido
+#include <Arduino.h>
+
+bool dht22Read(int pin, float &humidity, float &temperature);
@@ -1,5 +1,5 @@
 #include <Arduino.h>
-#include <DHT.h>
+#include "dht22_arduino.h"
 #include <WiFi.h>
 #include <WebServer.h>
 #include <PubSubClient.h>
@@ -20,7 +20,6 @@ const char* mqtt_base_topic = "paladario";
 
 // Configuración del sensor DHT22
 #define DHTPIN 15     // Pin D15 (GPIO 15)
-#define DHTTYPE DHT22 // Tipo de sensor DHT22
 
 // Definición de pines de relés
 #define BOMBA_LLUVIA_PIN 25
@@ -28,7 +27,6 @@ const char* mqtt_base_topic = "paladario";
 #define VENTILADOR_PIN 27
 #define CALEFACCION_PIN 33
 
-DHT dht(DHTPIN, DHTTYPE);
 WebServer server(80);
 WiFiClient espClient;
 PubSubClient mqtt(espClient);
@@ -355,8 +353,8 @@ void setup() {
   digitalWrite(VENTILADOR_PIN, LOW);
   digitalWrite(CALEFACCION_PIN, LOW);
   
-  // Iniciar DHT22
-  dht.begin();
+  // Iniciar DHT22 (línea en reposo con pull-up)
+  pinMode(DHTPIN, INPUT_PULLUP);
   Serial.println("Sensor DHT22 iniciado");
   
   // Configurar IP estática
@@ -416,10 +414,9 @@ void loop() {
   if (millis() - ultimaLectura >= 2000) {
     ultimaLectura = millis();
     
-    float h = dht.readHumidity();
-    float t = dht.readTemperature();
+    float h = NAN, t = NAN;
     
-    if (!isnan(h) && !isnan(t)) {
+    if (dht22Read(DHTPIN, h, t)) {
       temperatura = t;
       humedad = h;
       
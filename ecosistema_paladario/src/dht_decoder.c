@@ -0,0 +1,152 @@
+#include "dht_decoder.h"
+
+// Tiempos nominales DHT22: bit 0 = HIGH 26-28us, bit 1 = HIGH 70us
+#define DHT_FIXED_THRESHOLD_US   50   // Corte fijo de las versiones anteriores
+#define DHT_MIN_SEPARATION_US    20   // Por debajo, todos los bits son de la misma clase
+#define DHT_MIN_GAP_US           12   // Hueco mínimo en el corte de Otsu para fiarse de él
+#define DHT_MAX_SHIFT_US         6    // Desvío del punto medio de las clases que justifica adaptar
+#define DHT_MIN_THRESHOLD_US     35   // Ventana del umbral adaptativo
+#define DHT_MAX_THRESHOLD_US     60
+#define DHT_MAX_HIGH_US          120  // Ningún bit válido dura más
+
+// Umbral adaptativo (Otsu): sobre los 40 anchos ordenados, el corte que maximiza la
+// varianza entre clases. Solo sustituye al corte fijo cuando las dos clases están
+// claramente separadas y su punto medio se ha desplazado (sensor lento/rápido, retardo
+// sistemático de la captura). Si no, un bit deformado por ruido o una trama con pocos
+// unos lo moverían a peor (bench/dht_decode_bench.c). Siempre dentro de
+// [DHT_MIN_THRESHOLD_US, DHT_MAX_THRESHOLD_US].
+static uint16_t adaptive_threshold(const uint16_t *p) {
+    uint16_t s[DHT_FRAME_BITS];
+    uint32_t total = 0;
+    for (int i = 0; i < DHT_FRAME_BITS; i++) {
+        // Ordenación por inserción: 40 elementos
+        uint16_t v = p[i];
+        int j = i;
+        while (j > 0 && s[j - 1] > v) {
+            s[j] = s[j - 1];
+            j--;
+        }
+        s[j] = v;
+        total += v;
+    }
+    if (s[DHT_FRAME_BITS - 1] - s[0] < DHT_MIN_SEPARATION_US) {
+        return DHT_FIXED_THRESHOLD_US;
+    }
+
+    // n0*n1*(m1-m0)^2 == (n0*sum1 - n1*sum0)^2 / (n0*n1); se compara en enteros
+    // multiplicando en cruz (anchos <= DHT_MAX_HIGH_US, cabe holgado en 64 bits)
+    uint32_t sum0 = 0;
+    uint64_t best_num = 0, best_den = 1;
+    uint32_t best_sum0 = 0;
+    int at = 0;
+    for (int n0 = 1; n0 < DHT_FRAME_BITS; n0++) {
+        sum0 += s[n0 - 1];
+        if (s[n0] == s[n0 - 1]) continue;
+        int n1 = DHT_FRAME_BITS - n0;
+        int64_t diff = (int64_t)n0 * (total - sum0) - (int64_t)n1 * sum0;
+        uint64_t num = (uint64_t)(diff * diff);
+        uint64_t den = (uint64_t)n0 * n1;
+        if (at == 0 || num * best_den > best_num * den) {
+            best_num = num;
+            best_den = den;
+            best_sum0 = sum0;
+            at = n0;
+        }
+    }
+    if (s[at] - s[at - 1] < DHT_MIN_GAP_US) {
+        return DHT_FIXED_THRESHOLD_US;   // No es claramente bimodal
+    }
+    int medio = (int)(best_sum0 / at + (total - best_sum0) / (DHT_FRAME_BITS - at)) / 2;
+    if (medio >= DHT_FIXED_THRESHOLD_US - DHT_MAX_SHIFT_US && medio <= DHT_FIXED_THRESHOLD_US + DHT_MAX_SHIFT_US) {
+        return DHT_FIXED_THRESHOLD_US;   // Tiempos nominales: el corte fijo acierta más
+    }
+    uint16_t corte = (uint16_t)((s[at - 1] + s[at]) / 2);
+    if (corte < DHT_MIN_THRESHOLD_US) {
+        return DHT_MIN_THRESHOLD_US;
+    }
+    if (corte > DHT_MAX_THRESHOLD_US) {
+        return DHT_MAX_THRESHOLD_US;
+    }
+    return corte;
+}
+
+dht_decode_status_t dht_decode_pulses(const uint16_t *high_us, size_t n, uint16_t threshold_us,
+                                      dht_reading_t *out) {
+    if (n < DHT_FRAME_BITS) {
+        return DHT_DECODE_ERR_SHORT;
+    }
+    const uint16_t *bits = &high_us[n - DHT_FRAME_BITS];
+    for (int i = 0; i < DHT_FRAME_BITS; i++) {
+        if (bits[i] == 0 || bits[i] > DHT_MAX_HIGH_US) {
+            return DHT_DECODE_ERR_TIMING;
+        }
+    }
+
+    uint16_t t = threshold_us ? threshold_us : adaptive_threshold(bits);
+    uint8_t *data = out->raw;
+    for (int i = 0; i < 5; i++) data[i] = 0;
+    for (int i = 0; i < DHT_FRAME_BITS; i++) {
+        data[i / 8] <<= 1;
+        if (bits[i] > t) {
+            data[i / 8] |= 1;
+        }
+    }
+    out->threshold_us = t;
+
+    uint8_t checksum = (data[0] + data[1] + data[2] + data[3]) & 0xFF;
+    if (data[4] != checksum) {
+        return DHT_DECODE_ERR_CHECKSUM;
+    }
+    if (data[0] == 0 && data[1] == 0 && data[2] == 0 && data[3] == 0 && data[4] == 0) {
+        return DHT_DECODE_ERR_NULL;
+    }
+
+    // DHT22: 16 bits por valor en décimas; el bit más alto de la temperatura es el signo
+    int16_t hum = (int16_t)((data[0] << 8) | data[1]);
+    int16_t temp = (int16_t)(((data[2] & 0x7F) << 8) | data[3]);
+    if (data[2] & 0x80) {
+        temp = -temp;
+    }
+    out->humidity_x10 = hum;
+    out->temperature_x10 = temp;
+
+    if (hum < 0 || hum > 1000 || temp < -400 || temp > 800) {
+        return DHT_DECODE_ERR_RANGE;
+    }
+    return DHT_DECODE_OK;
+}
+
+dht_decode_status_t dht_decode_edges(const uint32_t *edges_us, size_t n_edges, int first_level,
+                                     uint16_t threshold_us, dht_reading_t *out) {
+    // Ventana circular con los últimos 40 pulsos HIGH
+    uint16_t ring[DHT_FRAME_BITS];
+    size_t n_highs = 0;
+    for (size_t i = 0; i + 1 < n_edges; i++) {
+        int level = first_level ^ (int)(i & 1);
+        if (!level) continue;
+        uint32_t width = edges_us[i + 1] - edges_us[i];
+        ring[n_highs % DHT_FRAME_BITS] = width > 0xFFFF ? 0xFFFF : (uint16_t)width;
+        n_highs++;
+    }
+    if (n_highs < DHT_FRAME_BITS) {
+        return DHT_DECODE_ERR_SHORT;
+    }
+
+    uint16_t highs[DHT_FRAME_BITS];
+    for (int i = 0; i < DHT_FRAME_BITS; i++) {
+        highs[i] = ring[(n_highs + i) % DHT_FRAME_BITS];
+    }
+    return dht_decode_pulses(highs, DHT_FRAME_BITS, threshold_us, out);
+}
+
+const char *dht_decode_status_str(dht_decode_status_t status) {
+    switch (status) {
+        case DHT_DECODE_OK:           return "OK";
+        case DHT_DECODE_ERR_SHORT:    return "trama incompleta";
+        case DHT_DECODE_ERR_TIMING:   return "pulso fuera de tiempo";
+        case DHT_DECODE_ERR_CHECKSUM: return "checksum";
+        case DHT_DECODE_ERR_NULL:     return "lectura nula";
+        case DHT_DECODE_ERR_RANGE:    return "fuera de rango";
+        default:                      return "desconocido";
+    }
+}
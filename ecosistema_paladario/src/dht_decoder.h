@@ -0,0 +1,48 @@
+// Decodificador de tramas DHT22 (AM2302) independiente del hardware.
+// Compartido por el firmware ESP-IDF, los sketches Arduino y el benchmark de host.
+#ifndef DHT_DECODER_H
+#define DHT_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DHT_FRAME_BITS 40
+
+typedef enum {
+    DHT_DECODE_OK = 0,
+    DHT_DECODE_ERR_SHORT,      // Menos de 40 pulsos HIGH en la captura
+    DHT_DECODE_ERR_TIMING,     // Pulso HIGH imposible (glitch o captura corrupta)
+    DHT_DECODE_ERR_CHECKSUM,
+    DHT_DECODE_ERR_NULL,       // Trama todo ceros
+    DHT_DECODE_ERR_RANGE,      // Fuera de rango DHT22: H 0-100%, T -40 a 80°C
+} dht_decode_status_t;
+
+typedef struct {
+    int16_t humidity_x10;      // Humedad en décimas de %
+    int16_t temperature_x10;   // Temperatura en décimas de °C (con signo)
+    uint8_t raw[5];
+    uint16_t threshold_us;     // Umbral 0/1 usado para clasificar los bits
+} dht_reading_t;
+
+// Decodifica a partir de las duraciones de los pulsos HIGH, en orden de llegada.
+// Se usan los últimos 40 (los anteriores son la respuesta de 80us del sensor).
+// threshold_us = 0 -> umbral adaptativo; otro valor -> umbral fijo.
+dht_decode_status_t dht_decode_pulses(const uint16_t *high_us, size_t n, uint16_t threshold_us,
+                                      dht_reading_t *out);
+
+// Decodifica a partir de marcas de tiempo (us) de cada flanco. first_level es el
+// nivel de la línea justo después de edges_us[0].
+dht_decode_status_t dht_decode_edges(const uint32_t *edges_us, size_t n_edges, int first_level,
+                                     uint16_t threshold_us, dht_reading_t *out);
+
+const char *dht_decode_status_str(dht_decode_status_t status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DHT_DECODER_H
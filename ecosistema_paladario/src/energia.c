@@ -0,0 +1,291 @@
+#include "energia.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "metricas.h"
+#include "traza.h"
+#include "nvs.h"
+
+static const char *TAG = "ENERGIA";
+
+#define FREQ_MAX_MHZ CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#define ORDENES      4       // Órdenes manuales en curso a la vez (una por tarea: MQTT, httpd)
+#define RECV_TIMEOUTS 3      // Esperas de recv seguidas antes de dar el cuerpo por cortado
+
+typedef struct {
+    uint32_t n;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t suma_us;
+} latencia_t;
+
+static esp_pm_lock_handle_t bloqueo = NULL;
+static bool disponible = false;          // CONFIG_PM_ENABLE
+static _Atomic bool ahorro = false;
+
+// Orden manual pendiente de llegar al GPIO (tarea NULL = hueco libre)
+typedef struct {
+    TaskHandle_t tarea;
+    int actuador;
+    int64_t recibida_us;
+} orden_t;
+
+static orden_t ordenes[ORDENES];
+static latencia_t latencias[2];          // [0] modo fijo, [1] ahorro
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Manejadores originales de las URIs registradas con energia_registrar_uri
+typedef struct {
+    esp_err_t (*handler)(httpd_req_t *req);
+    void *user_ctx;
+    int metrica;             // metricas_http_alta
+    uint16_t traza;          // traza_uri_alta
+} envoltura_t;
+static envoltura_t envolturas[ENERGIA_URIS_MAX];
+static int num_envolturas = 0;
+
+static esp_err_t aplicar(bool modo) {
+    esp_pm_config_t cfg = {
+        .max_freq_mhz = FREQ_MAX_MHZ,
+        .min_freq_mhz = modo ? ENERGIA_FREQ_MIN_MHZ : FREQ_MAX_MHZ,
+        .light_sleep_enable = modo,
+    };
+    esp_err_t err = esp_pm_configure(&cfg);
+    if (err != ESP_OK) {
+        return err;
+    }
+    // El light sleep con WiFi exige modem sleep; en modo fijo la radio no duerme
+    esp_wifi_set_ps(modo ? WIFI_PS_MIN_MODEM : WIFI_PS_NONE);
+    ahorro = modo;
+    ESP_LOGI(TAG, "Modo %s: %d-%d MHz, light sleep %s", modo ? "ahorro" : "fijo",
+             cfg.min_freq_mhz, cfg.max_freq_mhz, modo ? "sí" : "no");
+    return ESP_OK;
+}
+
+void energia_init(void) {
+    disponible = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "energia", &bloqueo) == ESP_OK;
+    if (!disponible) {
+        ESP_LOGW(TAG, "CONFIG_PM_ENABLE desactivado: CPU fija a %d MHz", FREQ_MAX_MHZ);
+        esp_wifi_set_ps(WIFI_PS_NONE);
+        return;
+    }
+    uint8_t modo = ENERGIA_AHORRO;
+    nvs_handle_t h;
+    if (nvs_open("energia", NVS_READONLY, &h) == ESP_OK) {
+        nvs_get_u8(h, "ahorro", &modo);
+        nvs_close(h);
+    }
+    if (aplicar(modo != 0) != ESP_OK) {
+        ESP_LOGE(TAG, "esp_pm_configure rechazó el modo %s", modo ? "ahorro" : "fijo");
+    }
+}
+
+bool energia_ahorro(void) {
+    return ahorro;
+}
+
+esp_err_t energia_configurar(bool modo) {
+    if (!disponible) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    bool cambia = modo != ahorro;
+    esp_err_t err = aplicar(modo);
+    if (err == ESP_OK && cambia) {
+        // Medidas nuevas para el modo al que se entra; repetir el modo actual no las borra
+        portENTER_CRITICAL(&lock);
+        latencias[modo ? 1 : 0] = (latencia_t){0};
+        portEXIT_CRITICAL(&lock);
+    }
+    nvs_handle_t h;
+    if (err == ESP_OK && nvs_open("energia", NVS_READWRITE, &h) == ESP_OK) {
+        nvs_set_u8(h, "ahorro", modo);
+        nvs_commit(h);
+        nvs_close(h);
+    }
+    return err;
+}
+
+void energia_bloquear(void) {
+    if (bloqueo) {
+        esp_pm_lock_acquire(bloqueo);
+        traza_sincronizar();     // Puede haber subido la frecuencia
+    }
+}
+
+void energia_liberar(void) {
+    if (bloqueo) {
+        esp_pm_lock_release(bloqueo);
+    }
+}
+
+static esp_err_t con_bloqueo(httpd_req_t *req) {
+    const envoltura_t *e = req->user_ctx;
+    req->user_ctx = e->user_ctx;
+    traza(TRAZA_HTTP_INICIO, e->traza, 0);
+    int64_t t0 = esp_timer_get_time();
+    energia_bloquear();
+    esp_err_t err = e->handler(req);
+    energia_liberar();
+    metricas_http(e->metrica, (uint32_t)(esp_timer_get_time() - t0));
+    traza(TRAZA_HTTP_FIN, e->traza, (uint32_t)err);
+    return err;
+}
+
+esp_err_t energia_registrar_uri(httpd_handle_t server, const httpd_uri_t *uri) {
+    if (num_envolturas == ENERGIA_URIS_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    envoltura_t *e = &envolturas[num_envolturas++];
+    e->handler = uri->handler;
+    e->user_ctx = uri->user_ctx;
+    e->metrica = metricas_http_alta(uri->uri, uri->method);
+    e->traza = traza_uri_alta(uri->uri, uri->method);
+    httpd_uri_t envuelta = *uri;
+    envuelta.handler = con_bloqueo;
+    envuelta.user_ctx = e;
+    return httpd_register_uri_handler(server, &envuelta);
+}
+
+int energia_recibir(httpd_req_t *req, char *buf, size_t len) {
+    if (req->content_len >= len) {
+        return -1;
+    }
+    size_t recibido = 0;
+    int timeouts = 0;
+    while (recibido < req->content_len) {
+        int r = httpd_req_recv(req, buf + recibido, req->content_len - recibido);
+        if (r == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < RECV_TIMEOUTS) {
+            continue;
+        }
+        if (r <= 0) {
+            return -1;
+        }
+        timeouts = 0;
+        recibido += r;
+    }
+    buf[recibido] = '\0';
+    return (int)recibido;
+}
+
+// Hueco de la tarea actual (o uno libre si libre = true); NULL si no hay. Con lock.
+static orden_t *orden_de(TaskHandle_t tarea, bool libre) {
+    orden_t *hueco = NULL;
+    for (int i = 0; i < ORDENES; i++) {
+        if (ordenes[i].tarea == tarea) {
+            return &ordenes[i];
+        }
+        if (libre && hueco == NULL && ordenes[i].tarea == NULL) {
+            hueco = &ordenes[i];
+        }
+    }
+    return hueco;
+}
+
+void energia_orden(int actuador, int64_t recibida_us) {
+    TaskHandle_t tarea = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&lock);
+    orden_t *o = orden_de(tarea, recibida_us != 0);
+    if (o != NULL) {
+        o->tarea = recibida_us != 0 ? tarea : NULL;
+        o->actuador = actuador;
+        o->recibida_us = recibida_us;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void energia_gpio(int actuador) {
+    int64_t ahora = esp_timer_get_time();
+    TaskHandle_t tarea = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&lock);
+    orden_t *o = orden_de(tarea, false);
+    if (o == NULL || o->actuador != actuador) {
+        portEXIT_CRITICAL(&lock);
+        return;   // Conmutación automática (clima, riego) o enclavamiento de otro relé
+    }
+    uint32_t us = (uint32_t)(ahora - o->recibida_us);
+    o->tarea = NULL;
+    latencia_t *l = &latencias[ahorro ? 1 : 0];
+    if (l->n == 0 || us < l->min_us) {
+        l->min_us = us;
+    }
+    if (us > l->max_us) {
+        l->max_us = us;
+    }
+    l->suma_us += us;
+    l->n++;
+    portEXIT_CRITICAL(&lock);
+}
+
+int energia_json(char *buf, size_t len) {
+    latencia_t l[2];
+    portENTER_CRITICAL(&lock);
+    l[0] = latencias[0];
+    l[1] = latencias[1];
+    portEXIT_CRITICAL(&lock);
+    int n = snprintf(buf, len, "{\"modo\":\"%s\",\"disponible\":%s,\"freq_min\":%d,\"freq_max\":%d,\"latencia\":{",
+                     ahorro ? "ahorro" : "fijo", disponible ? "true" : "false",
+                     ahorro ? ENERGIA_FREQ_MIN_MHZ : FREQ_MAX_MHZ, FREQ_MAX_MHZ);
+    for (int i = 0; i < 2 && n < (int)len; i++) {
+        n += snprintf(buf + n, len - n, "%s\"%s\":{\"n\":%lu,\"min_us\":%lu,\"media_us\":%lu,\"max_us\":%lu}",
+                      i ? "," : "", i ? "ahorro" : "fijo", (unsigned long)l[i].n, (unsigned long)l[i].min_us,
+                      (unsigned long)(l[i].n ? l[i].suma_us / l[i].n : 0), (unsigned long)l[i].max_us);
+    }
+    if (n < (int)len) {
+        n += snprintf(buf + n, len - n, "}}");
+    }
+    return n < (int)len ? n : (int)len - 1;
+}
+
+// GET /api/energia
+static esp_err_t energia_get_handler(httpd_req_t *req) {
+    char payload[320];
+    int n = energia_json(payload, sizeof(payload));
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, payload, n);
+}
+
+// POST /api/energia {"ahorro":true|false} -> responde con el estado nuevo
+static esp_err_t energia_post_handler(httpd_req_t *req) {
+    char content[64];
+    if (req->content_len >= sizeof(content)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Cuerpo demasiado largo");
+        return ESP_FAIL;
+    }
+    int ret = energia_recibir(req, content, sizeof(content));
+    cJSON *json = ret > 0 ? cJSON_ParseWithLength(content, ret) : NULL;
+    const cJSON *modo = cJSON_GetObjectItemCaseSensitive(json, "ahorro");
+    if (!cJSON_IsBool(modo)) {
+        cJSON_Delete(json);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Se espera {\"ahorro\":true|false}");
+        return ESP_FAIL;
+    }
+    esp_err_t err = energia_configurar(cJSON_IsTrue(modo));
+    cJSON_Delete(json);
+    if (err != ESP_OK) {
+        httpd_resp_set_status(req, "409 Conflict");
+    }
+    return energia_get_handler(req);
+}
+
+esp_err_t energia_registrar(httpd_handle_t server) {
+    httpd_uri_t get = {
+        .uri = "/api/energia",
+        .method = HTTP_GET,
+        .handler = energia_get_handler,
+    };
+    httpd_uri_t post = {
+        .uri = "/api/energia",
+        .method = HTTP_POST,
+        .handler = energia_post_handler,
+    };
+    esp_err_t err = energia_registrar_uri(server, &get);
+    return err == ESP_OK ? energia_registrar_uri(server, &post) : err;
+}
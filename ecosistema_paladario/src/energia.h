@@ -0,0 +1,71 @@
+// Gestión de energía: el controlador pasa más del 99 % del tiempo esperando (10 s entre
+// lecturas, temporizadores del clima y del riego), así que en modo ahorro:
+//  - la CPU baja a ENERGIA_FREQ_MIN_MHZ cuando no hay trabajo (DFS),
+//  - FreeRTOS entra en light sleep mientras no haya tareas listas (tickless idle),
+//  - la WiFi duerme entre balizas del router (modem sleep).
+// Solo la captura del DHT, las peticiones HTTP y la OTA mantienen la CPU a tope (y sin
+// dormir) con energia_bloquear(). En modo fijo la CPU va siempre a la frecuencia máxima y
+// la WiFi no duerme: más consumo, menos latencia.
+//
+// El modo se cambia en marcha (POST /api/energia {"ahorro":true|false}, se guarda en
+// NVS) y GET /api/energia da la latencia orden→GPIO medida en cada modo desde que se
+// entró en él: de la llegada de la orden al firmware (petición HTTP o mensaje MQTT) a
+// la conmutación del relé. En ahorro la orden además puede esperar en el router hasta
+// la siguiente baliza (DTIM, ~100-300 ms): bench/latencia_orden.py mide el total desde fuera.
+// Requiere CONFIG_PM_ENABLE; sin ella todo funciona en modo fijo.
+#ifndef ENERGIA_H
+#define ENERGIA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "wifi_config.h"
+
+// Valores por defecto; se pueden redefinir en wifi_config.h
+#ifndef ENERGIA_AHORRO
+#define ENERGIA_AHORRO 1              // Modo al arrancar si no hay otro guardado en NVS
+#endif
+#ifndef ENERGIA_FREQ_MIN_MHZ
+#define ENERGIA_FREQ_MIN_MHZ 80       // Frecuencia en reposo (40 = cristal; 80 deja la WiFi más ágil)
+#endif
+
+// URIs del servidor web (config.max_uri_handlers): todas se registran con
+// energia_registrar_uri, y metricas.c y traza.c guardan lo suyo de cada una
+#define ENERGIA_URIS_MAX 20
+
+// Aplicar el modo guardado (después de wifi_init: NVS y WiFi ya inicializadas)
+void energia_init(void);
+
+bool energia_ahorro(void);
+
+// Cambiar de modo y guardarlo; ESP_ERR_NOT_SUPPORTED sin CONFIG_PM_ENABLE
+esp_err_t energia_configurar(bool ahorro);
+
+// CPU a tope y sin light sleep mientras dure (anidable, desde cualquier tarea)
+void energia_bloquear(void);
+void energia_liberar(void);
+
+// httpd_register_uri_handler con el manejador entre energia_bloquear/energia_liberar;
+// cada petición se anota además en metricas.h con su duración
+esp_err_t energia_registrar_uri(httpd_handle_t server, const httpd_uri_t *uri);
+
+// Cuerpo entero de la petición en buf, terminado en '\0': httpd_req_recv puede devolver
+// menos de content_len si llega en varios segmentos TCP. Devuelve la longitud, o -1 si
+// no cabe en len o la conexión se corta.
+int energia_recibir(httpd_req_t *req, char *buf, size_t len);
+
+// Medida de latencia: hora (esp_timer_get_time) en que llegó una orden manual para el
+// actuador (0 = anularla), y la conmutación de un GPIO (actuadores.c). Solo cuenta la
+// del mismo actuador desde la misma tarea: lo que conmuten a la vez el clima o el riego
+// desde sus tareas no se confunde con la orden.
+void energia_orden(int actuador, int64_t recibida_us);
+void energia_gpio(int actuador);
+
+// Estado y latencias en JSON; devuelve la longitud
+int energia_json(char *buf, size_t len);
+
+// GET y POST /api/energia
+esp_err_t energia_registrar(httpd_handle_t server);
+
+#endif // ENERGIA_H
@@ -0,0 +1,55 @@
+#include "estado_sistema.h"
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "actuadores.h"
+
+static estado_sistema_t foto;
+static _Atomic uint32_t seq = 0;     // Impar = escritura en curso
+static portMUX_TYPE escritores = portMUX_INITIALIZER_UNLOCKED;
+
+static void empezar(void) {
+    portENTER_CRITICAL(&escritores);
+    atomic_store_explicit(&seq, atomic_load_explicit(&seq, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+// La máscara de actuadores se relee siempre dentro de la escritura: la última foto
+// publicada lleva el valor más reciente aunque dos relés cambien a la vez
+static void terminar(void) {
+    uint32_t s = atomic_load_explicit(&seq, memory_order_relaxed) + 1;
+    foto.actuadores = actuadores_estado();
+    foto.version = s / 2;
+    atomic_store_explicit(&seq, s, memory_order_release);
+    portEXIT_CRITICAL(&escritores);
+}
+
+void estado_sistema_leer(estado_sistema_t *e) {
+    uint32_t s1, s2;
+    do {
+        s1 = atomic_load_explicit(&seq, memory_order_acquire);
+        memcpy(e, &foto, sizeof(*e));
+        atomic_thread_fence(memory_order_acquire);
+        s2 = atomic_load_explicit(&seq, memory_order_relaxed);
+    } while ((s1 & 1) || s1 != s2);
+}
+
+void estado_sistema_sensor(float temperatura, float humedad, int64_t muestra_us) {
+    empezar();
+    foto.dht_valido = true;
+    foto.temperatura = temperatura;
+    foto.humedad = humedad;
+    foto.muestra_us = muestra_us;
+    terminar();
+}
+
+void estado_sistema_wifi(bool conectado) {
+    empezar();
+    foto.wifi_conectado = conectado;
+    terminar();
+}
+
+void estado_sistema_actuadores(void) {
+    empezar();
+    terminar();
+}
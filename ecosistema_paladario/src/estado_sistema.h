@@ -0,0 +1,35 @@
+// Foto del estado del sistema (sensor, WiFi, actuadores) compartida entre tareas con un
+// seqlock: los escritores (task_sensor, eventos WiFi, actuadores) publican siempre una
+// foto entera y coherente; los lectores (web, MQTT, registro) copian sin mutex y
+// reintentan si les pilla a mitad de una escritura. Así una lectura nunca mezcla la
+// temperatura de una muestra con la humedad de otra.
+// Los escritores se serializan con un spinlock muy corto (unas decenas de bytes), que
+// además impide que se les interrumpa a mitad en su núcleo.
+#ifndef ESTADO_SISTEMA_H
+#define ESTADO_SISTEMA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t version;        // +1 por cada publicación
+    bool dht_valido;         // Ha habido al menos una lectura válida
+    float temperatura;       // Última lectura válida (°C)
+    float humedad;           // %
+    int64_t muestra_us;      // esp_timer_get_time() de esa lectura
+    bool wifi_conectado;     // Con IP
+    uint32_t actuadores;     // Máscara ACT_BIT(...) de actuadores encendidos
+} estado_sistema_t;
+
+// Copia coherente de la foto actual (cualquier tarea o núcleo; no bloquea a nadie)
+void estado_sistema_leer(estado_sistema_t *e);
+
+// Lectura válida del sensor (temperatura y humedad juntas)
+void estado_sistema_sensor(float temperatura, float humedad, int64_t muestra_us);
+
+void estado_sistema_wifi(bool conectado);
+
+// Volver a leer la máscara de actuadores.h (tras cada cambio de un relé)
+void estado_sistema_actuadores(void);
+
+#endif // ESTADO_SISTEMA_H
@@ -0,0 +1,542 @@
+#include "historia.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "energia.h"
+#include "resumen.h"
+#include "tareas.h"
+
+static const char *TAG = "HISTORIA";
+
+#define MAGIC       0x32545348u   // "HST2"
+#define CAB         ((uint32_t)sizeof(pagina_cab_t))
+#define MAX_PAGINAS 256
+#define SALIDA      1024          // Búfer de cada chunk HTTP
+#define AVISO_CADA  100           // Descartes por cola llena entre dos avisos
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;            // +1 por cada página abierta: las páginas en uso son consecutivas
+    historia_base_t base;    // Estado del códec al empezar la página (base.t = primer registro)
+    uint8_t reservado[3];
+    uint32_t crc;            // CRC-32 de los campos anteriores
+} pagina_cab_t;
+
+// Registro en cola: la hora Unix se pone al escribirlo
+typedef struct {
+    int64_t timestamp_us;
+    historia_registro_t r;
+} pendiente_t;
+
+static const esp_partition_t *part = NULL;
+static QueueHandle_t cola = NULL;
+static uint32_t num_paginas = 0;
+static _Atomic uint32_t descartados = 0;
+
+// Índice: lo cambia la tarea de escritura y lo consulta /api/history, bajo lock
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t t0[MAX_PAGINAS];
+static uint32_t antigua = 0;         // Página en uso más antigua
+static uint32_t validas = 0;         // Páginas en uso, consecutivas desde antigua
+static uint32_t seq_actual = 0;      // Secuencia de la última página (la que se escribe)
+
+// Solo la tarea de escritura
+static uint32_t libre = HISTORIA_PAGINA;   // Siguiente byte libre en la última página
+static historia_codec_t codec;             // Estado tras el último registro escrito
+
+// Solo el publicador (historia_actuadores)
+static uint32_t ultima_mascara = UINT32_MAX;
+
+static uint32_t crc_cab(const pagina_cab_t *c) {
+    return esp_rom_crc32_le(0, (const uint8_t *)c, offsetof(pagina_cab_t, crc));
+}
+
+static bool cab_valida(const pagina_cab_t *c) {
+    return c->magic == MAGIC && c->crc == crc_cab(c);
+}
+
+static bool vacio(const uint8_t *b, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (b[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Recorrer la página actual para recuperar el estado del códec y el primer byte libre.
+// Si tras el último registro completo hay bytes escritos (escritura cortada), la página
+// se da por llena: escribir encima los corrompería y los lectores se pararían allí.
+static void recuperar_actual(uint32_t p) {
+    uint8_t *buf = malloc(HISTORIA_PAGINA);
+    if (buf == NULL || esp_partition_read(part, p * HISTORIA_PAGINA, buf, HISTORIA_PAGINA) != ESP_OK) {
+        free(buf);
+        return;
+    }
+    const pagina_cab_t *c = (const pagina_cab_t *)buf;
+    historia_codec_inicio(&codec, &c->base);
+    historia_registro_t r;
+    uint32_t pos = CAB;
+    int n;
+    while ((n = historia_decodificar(&codec, buf + pos, HISTORIA_PAGINA - pos, &r)) > 0) {
+        pos += n;
+    }
+    libre = vacio(buf + pos, HISTORIA_PAGINA - pos) ? pos : HISTORIA_PAGINA;
+    if (libre != pos) {
+        ESP_LOGW(TAG, "Página %lu cortada en el byte %lu: se continúa en la siguiente",
+                 (unsigned long)p, (unsigned long)pos);
+    }
+    free(buf);
+}
+
+// Reconstruir el índice: la página con la secuencia más alta es la actual y las
+// anteriores con secuencias consecutivas son el histórico
+static void reconstruir(void) {
+    pagina_cab_t c;
+    bool valida[MAX_PAGINAS];
+    uint32_t seq[MAX_PAGINAS];
+    int actual = -1;
+    for (uint32_t p = 0; p < num_paginas; p++) {
+        valida[p] = esp_partition_read(part, p * HISTORIA_PAGINA, &c, CAB) == ESP_OK && cab_valida(&c);
+        seq[p] = c.seq;
+        t0[p] = c.base.t;
+        if (valida[p] && (actual < 0 || seq[p] > seq[actual])) {
+            actual = p;
+        }
+    }
+    if (actual < 0) {
+        return;
+    }
+    antigua = actual;
+    validas = 1;
+    seq_actual = seq[actual];
+    while (validas < num_paginas) {
+        uint32_t q = (antigua + num_paginas - 1) % num_paginas;
+        if (!valida[q] || seq[q] != seq[antigua] - 1) {
+            break;
+        }
+        antigua = q;
+        validas++;
+    }
+    recuperar_actual(actual);
+}
+
+// Abrir la página siguiente a la actual, borrando la más antigua si el registro está lleno
+static bool abrir_pagina(const historia_base_t *base) {
+    uint32_t p = validas ? (antigua + validas) % num_paginas : antigua;
+    portENTER_CRITICAL(&lock);
+    if (validas == num_paginas) {
+        antigua = (antigua + 1) % num_paginas;   // Sale del índice antes de borrarla
+        validas--;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    pagina_cab_t c = { .magic = MAGIC, .seq = seq_actual + 1, .base = *base };
+    c.crc = crc_cab(&c);
+    esp_err_t err = esp_partition_erase_range(part, p * HISTORIA_PAGINA, HISTORIA_PAGINA);
+    if (err == ESP_OK) {
+        err = esp_partition_write(part, p * HISTORIA_PAGINA, &c, CAB);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No se pudo preparar la página %lu: %s", (unsigned long)p, esp_err_to_name(err));
+        return false;
+    }
+    portENTER_CRITICAL(&lock);
+    t0[p] = base->t;
+    seq_actual = c.seq;
+    validas++;
+    portEXIT_CRITICAL(&lock);
+    historia_codec_inicio(&codec, base);
+    libre = CAB;
+    return true;
+}
+
+static void escribir(const historia_registro_t *r) {
+    uint8_t buf[HISTORIA_CODEC_MAX];
+    historia_codec_t c = codec;
+    size_t n = historia_codificar(&c, r, buf);
+    if (validas == 0 || libre + n > HISTORIA_PAGINA) {
+        // La página nueva parte de los últimos valores conocidos (o de esta muestra)
+        historia_base_t base = historia_codec_base(&codec, r->t);
+        if (r->tipo == HISTORIA_MUESTRA) {
+            base.temperatura = r->temperatura;
+            base.humedad = r->humedad;
+            base.actuadores = r->actuadores;
+        }
+        if (!abrir_pagina(&base)) {
+            return;
+        }
+        c = codec;
+        n = historia_codificar(&c, r, buf);
+    }
+    uint32_t p = (antigua + validas - 1) % num_paginas;
+    esp_err_t err = esp_partition_write(part, p * HISTORIA_PAGINA + libre, buf, n);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error escribiendo el histórico: %s", esp_err_to_name(err));
+        libre = HISTORIA_PAGINA;   // Puede haber quedado a medias: seguir en otra página
+        return;
+    }
+    libre += n;
+    codec = c;
+}
+
+// Fechar con la hora ya sincronizada (hacia atrás con su timestamp_us) y escribir
+static void guardar(pendiente_t *p) {
+    p->r.t = time(NULL) - (uint32_t)((esp_timer_get_time() - p->timestamp_us) / 1000000);
+    escribir(&p->r);
+    if (p->r.tipo == HISTORIA_MUESTRA) {
+        resumen_muestra(p->r.t, p->r.temperatura, p->r.humedad);
+    }
+}
+
+// Hasta la sincronización SNTP la cola se sigue vaciando: los últimos HISTORIA_SIN_HORA
+// registros esperan en RAM (lo anterior se pierde sin avisar uno a uno) y se escriben en
+// orden en cuanto hay hora. Sin NTP no se guarda nada en la flash.
+static void task_historia(void *arg) {
+    pendiente_t *sin_hora = malloc(HISTORIA_SIN_HORA * sizeof(pendiente_t));
+    uint32_t recibidos = 0;   // Sin hora, incluidos los que ya no caben
+    bool con_hora = false;
+    pendiente_t p;
+    while (1) {
+        bool hay = xQueueReceive(cola, &p, con_hora ? portMAX_DELAY : pdMS_TO_TICKS(1000)) == pdTRUE;
+        if (!con_hora && time(NULL) >= HISTORIA_T_MIN) {
+            uint32_t guardados = sin_hora == NULL ? 0
+                               : recibidos < HISTORIA_SIN_HORA ? recibidos : HISTORIA_SIN_HORA;
+            for (uint32_t i = recibidos - guardados; i < recibidos; i++) {
+                guardar(&sin_hora[i % HISTORIA_SIN_HORA]);
+            }
+            if (recibidos > guardados) {
+                ESP_LOGW(TAG, "Hora sincronizada: %lu registros anteriores perdidos",
+                         (unsigned long)(recibidos - guardados));
+            }
+            free(sin_hora);
+            sin_hora = NULL;
+            con_hora = true;
+        }
+        if (!hay) {
+            continue;
+        }
+        if (con_hora) {
+            guardar(&p);
+        } else {
+            if (sin_hora) {
+                sin_hora[recibidos % HISTORIA_SIN_HORA] = p;
+            }
+            recibidos++;
+        }
+    }
+}
+
+static void encolar(pendiente_t *p) {
+    if (cola == NULL) {
+        return;
+    }
+    if (xQueueSend(cola, p, 0) != pdTRUE) {
+        uint32_t n = ++descartados;
+        if (n % AVISO_CADA == 1) {
+            ESP_LOGW(TAG, "Cola del histórico llena (%lu descartados)", (unsigned long)n);
+        }
+    }
+}
+
+esp_err_t historia_init(void) {
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, HISTORIA_PARTICION);
+    if (part == NULL) {
+        ESP_LOGW(TAG, "Sin partición \"%s\": histórico desactivado", HISTORIA_PARTICION);
+        return ESP_ERR_NOT_FOUND;
+    }
+    num_paginas = part->size / HISTORIA_PAGINA;
+    if (num_paginas > MAX_PAGINAS) {
+        num_paginas = MAX_PAGINAS;
+    }
+    reconstruir();
+    resumen_init();
+    ESP_LOGI(TAG, "Histórico: %lu de %lu páginas en uso, %lu bytes libres en la actual",
+             (unsigned long)validas, (unsigned long)num_paginas, (unsigned long)(HISTORIA_PAGINA - libre));
+
+    cola = xQueueCreate(HISTORIA_COLA, sizeof(pendiente_t));
+    if (cola == NULL || tarea_crear(TAREA_HISTORIA, task_historia, NULL) == NULL) {
+        ESP_LOGE(TAG, "No se pudo arrancar la tarea del histórico");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void historia_muestra(const sensor_sample_t *m) {
+    pendiente_t p = {
+        .timestamp_us = m->timestamp_us,
+        .r = {
+            .tipo = HISTORIA_MUESTRA,
+            .actuadores = ultima_mascara == UINT32_MAX ? 0 : ultima_mascara,
+            .temperatura = (int16_t)(m->temperatura * 10.0f + (m->temperatura < 0 ? -0.5f : 0.5f)),
+            .humedad = (uint16_t)(m->humedad * 10.0f + 0.5f),
+        },
+    };
+    encolar(&p);
+}
+
+void historia_actuadores(uint32_t mascara) {
+    if (mascara == ultima_mascara) {
+        return;
+    }
+    ultima_mascara = mascara;
+    pendiente_t p = {
+        .timestamp_us = esp_timer_get_time(),
+        .r = { .tipo = HISTORIA_ACTUADORES, .actuadores = mascara },
+    };
+    encolar(&p);
+}
+
+// Chunk HTTP en construcción. En binario los registros se vuelven a codificar con un
+// flujo propio que empieza en el primero enviado.
+typedef struct {
+    httpd_req_t *req;
+    char *buf;
+    size_t n;
+    bool csv;
+    bool con_base;
+    historia_codec_t codec;
+} salida_t;
+
+static esp_err_t vaciar(salida_t *s) {
+    esp_err_t err = s->n ? httpd_resp_send_chunk(s->req, s->buf, s->n) : ESP_OK;
+    s->n = 0;
+    return err;
+}
+
+static esp_err_t emitir(const historia_registro_t *r, void *arg) {
+    salida_t *s = arg;
+    if (s->n + 64 > SALIDA && vaciar(s) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (s->csv) {
+        if (r->tipo == HISTORIA_MUESTRA) {
+            s->n += snprintf(s->buf + s->n, SALIDA - s->n, "%lu,m,%.1f,%.1f,%u\n", (unsigned long)r->t,
+                             r->temperatura / 10.0f, r->humedad / 10.0f, r->actuadores);
+        } else {
+            s->n += snprintf(s->buf + s->n, SALIDA - s->n, "%lu,a,,,%u\n", (unsigned long)r->t, r->actuadores);
+        }
+        return ESP_OK;
+    }
+    if (!s->con_base) {
+        historia_base_t base = {
+            .t = r->t,
+            .temperatura = r->temperatura,
+            .humedad = r->humedad,
+            .actuadores = r->tipo == HISTORIA_MUESTRA ? r->actuadores : 0,
+        };
+        historia_codec_inicio(&s->codec, &base);
+        memcpy(s->buf + s->n, &base, sizeof(base));
+        s->n += sizeof(base);
+        s->con_base = true;
+    }
+    s->n += historia_codificar(&s->codec, r, (uint8_t *)s->buf + s->n);
+    return ESP_OK;
+}
+
+// Empieza por la última página cuyo primer registro no es posterior a desde. Cada página
+// se lee entera de una vez; si el escritor la ha reciclado (cambia su secuencia), se
+// abandona: lo que quedaba ya no existe.
+esp_err_t historia_recorrer(uint32_t desde, uint32_t hasta, void *pagina_buf, historia_cb_t cb, void *arg) {
+    if (part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    portENTER_CRITICAL(&lock);
+    uint32_t lo = 0, hi = validas;   // Primera página lógica con t0 > desde
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (t0[(antigua + mid) % num_paginas] <= desde) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    uint32_t inicio = lo ? lo - 1 : 0;
+    uint32_t pagina = (antigua + inicio) % num_paginas;
+    uint32_t seq = seq_actual - (validas - 1 - inicio);
+    uint32_t quedan = validas - inicio;
+    portEXIT_CRITICAL(&lock);
+
+    const uint8_t *buf = pagina_buf;
+    const pagina_cab_t *c = pagina_buf;
+    for (; quedan > 0; quedan--, seq++, pagina = (pagina + 1) % num_paginas) {
+        if (esp_partition_read(part, pagina * HISTORIA_PAGINA, pagina_buf, HISTORIA_PAGINA) != ESP_OK ||
+            !cab_valida(c) || c->seq != seq) {
+            return ESP_OK;
+        }
+        historia_codec_t codec_pag;
+        historia_codec_inicio(&codec_pag, &c->base);
+        historia_registro_t r;
+        int n;
+        for (uint32_t pos = CAB;
+             (n = historia_decodificar(&codec_pag, buf + pos, HISTORIA_PAGINA - pos, &r)) > 0;
+             pos += n) {
+            if (r.t < desde) {
+                continue;
+            }
+            if (r.t > hasta) {
+                return ESP_OK;
+            }
+            esp_err_t err = cb(&r, arg);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+static bool leer_param(const char *query, const char *clave, uint32_t *v) {
+    char buf[16];
+    if (httpd_query_key_value(query, clave, buf, sizeof(buf)) != ESP_OK) {
+        return true;
+    }
+    char *fin;
+    unsigned long n = strtoul(buf, &fin, 10);
+    if (fin == buf || *fin != '\0') {
+        return false;
+    }
+    *v = n;
+    return true;
+}
+
+static esp_err_t emitir_resumen(const resumen_t *r, void *arg) {
+    salida_t *s = arg;
+    if (s->n + 64 > SALIDA && vaciar(s) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (s->csv) {
+        s->n += snprintf(s->buf + s->n, SALIDA - s->n, "%lu,%u,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n", (unsigned long)r->t,
+                         r->n, r->t_min / 10.0f, r->t_media / 10.0f, r->t_max / 10.0f, r->h_min / 10.0f,
+                         r->h_media / 10.0f, r->h_max / 10.0f);
+    } else {
+        memcpy(s->buf + s->n, r, sizeof(*r));
+        s->n += sizeof(*r);
+    }
+    return ESP_OK;
+}
+
+static uint32_t crudo_desde(void) {
+    portENTER_CRITICAL(&lock);
+    uint32_t t = validas ? t0[antigua] : UINT32_MAX;
+    portEXIT_CRITICAL(&lock);
+    return t;
+}
+
+// Nivel que sirve una consulta con res segundos entre puntos: el resumen más grueso
+// que no pasa de res y llega hasta desde. Si ninguno llega, la fuente con datos más
+// antiguos (las lecturas sin resumir incluidas). -1 = lecturas sin resumir.
+static int elegir_nivel(uint32_t res, uint32_t desde) {
+    uint32_t mas_antiguo = crudo_desde();
+    int mejor = -1;
+    for (int k = RESUMEN_NIVELES - 1; k >= 0; k--) {
+        if (resumen_periodo(k) > res) {
+            continue;
+        }
+        uint32_t t = resumen_desde(k);
+        if (t <= desde) {
+            return k;
+        }
+        if (t < mas_antiguo) {
+            mas_antiguo = t;
+            mejor = k;
+        }
+    }
+    return crudo_desde() <= desde ? -1 : mejor;
+}
+
+// GET /api/history?from=&to=&format=csv&res=|points=
+static esp_err_t history_handler(httpd_req_t *req) {
+    uint32_t desde = 0, hasta = UINT32_MAX, res = 0, puntos = 0;
+    bool csv = false;
+    char query[112], formato[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (!leer_param(query, "from", &desde) || !leer_param(query, "to", &hasta) ||
+            !leer_param(query, "res", &res) || !leer_param(query, "points", &puntos)) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "from, to, res y points son enteros (horas Unix en segundos)");
+            return ESP_FAIL;
+        }
+        csv = httpd_query_key_value(query, "format", formato, sizeof(formato)) == ESP_OK &&
+              strcmp(formato, "csv") == 0;
+    }
+    if (part == NULL) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Sin partición de histórico");
+        return ESP_FAIL;
+    }
+    if (puntos > 0 && res == 0) {
+        // Sin from, el rango empieza en lo más antiguo que haya
+        uint32_t inicio = desde, ahora = time(NULL), fin = hasta < ahora ? hasta : ahora;
+        if (inicio == 0) {
+            inicio = crudo_desde();
+            for (int k = 0; k < RESUMEN_NIVELES; k++) {
+                uint32_t t = resumen_desde(k);
+                inicio = t < inicio ? t : inicio;
+            }
+        }
+        if (inicio < fin) {
+            // Como mucho esos puntos: el nivel más fino con el paso necesario o más
+            uint32_t paso = (fin - inicio) / puntos + 1;
+            res = resumen_periodo(RESUMEN_NIVELES - 1);
+            for (int k = RESUMEN_NIVELES - 1; k >= 0; k--) {
+                res = resumen_periodo(k) >= paso ? resumen_periodo(k) : res;
+            }
+        }
+    }
+    int nivel = res > 0 ? elegir_nivel(res, desde) : -1;
+
+    char *buf = malloc(SALIDA + HISTORIA_PAGINA);
+    if (buf == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Sin memoria");
+        return ESP_FAIL;
+    }
+    salida_t s = { .req = req, .buf = buf, .csv = csv };
+    char periodo[12];
+    snprintf(periodo, sizeof(periodo), "%lu", (unsigned long)(nivel < 0 ? 0 : resumen_periodo(nivel)));
+    httpd_resp_set_type(req, csv ? "text/csv" : "application/octet-stream");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_set_hdr(req, "X-History-Resolution", periodo);
+    if (nivel >= 0 && csv) {
+        s.n = snprintf(buf, SALIDA, "t,n,t_min,t_media,t_max,h_min,h_media,h_max\n");
+    } else if (nivel >= 0) {
+        uint32_t p = resumen_periodo(nivel);
+        memcpy(buf, "PHR1", 4);
+        memcpy(buf + 4, &p, sizeof(p));
+        s.n = 8;
+    } else if (csv) {
+        s.n = snprintf(buf, SALIDA, "t,tipo,temperatura,humedad,actuadores\n");
+    } else {
+        memcpy(buf, "PHS2", 4);
+        s.n = 4;
+    }
+
+    esp_err_t err = nivel >= 0 ? resumen_recorrer(nivel, desde, hasta, buf + SALIDA, emitir_resumen, &s)
+                               : historia_recorrer(desde, hasta, buf + SALIDA, emitir, &s);
+    if (err == ESP_OK) {
+        err = vaciar(&s);
+    }
+    if (err == ESP_OK) {
+        err = httpd_resp_send_chunk(req, NULL, 0);
+    }
+    free(buf);
+    return err;
+}
+
+esp_err_t historia_registrar(httpd_handle_t server) {
+    httpd_uri_t history = {
+        .uri = "/api/history",
+        .method = HTTP_GET,
+        .handler = history_handler,
+    };
+    return energia_registrar_uri(server, &history);
+}
@@ -0,0 +1,54 @@
+// Histórico de muestras y cambios de actuadores en la partición "historia" de la flash.
+// Registro circular de páginas (un sector cada una): se borra siempre la página más
+// antigua, así el desgaste se reparte por igual. Cada página empieza con su número de
+// secuencia y el estado inicial del códec (historia_codec.h), que incluye la hora de
+// su primer registro; ese índice vive en RAM y permite buscar el inicio de un rango
+// con una búsqueda binaria sobre las páginas. Los registros van comprimidos (una
+// lectura típica ocupa un byte) y se añaden a la flash uno a uno.
+// Escribe una tarea propia: task_sensor y el publicador solo encolan, sin bloquear.
+// Los registros llevan hora Unix. Antes de la sincronización SNTP se guardan en RAM los
+// últimos HISTORIA_SIN_HORA y se fechan hacia atrás con su timestamp_us al tener hora;
+// sin NTP no llega nada a la flash.
+//
+// GET /api/history?from=<unix>&to=<unix>[&format=csv]  (por defecto binario, en chunks)
+//   Binario: "PHS2", historia_base_t y los registros del rango con historia_codec.h.
+//   CSV: t,tipo,temperatura,humedad,actuadores (tipo m = muestra, a = actuadores).
+// Con &res=<s> (separación máxima entre puntos) o &points=<n> (como mucho n puntos)
+// responde con el resumen más grueso que cumple (resumen.h); X-History-Resolution
+// lleva su periodo en segundos (0 = sin resumir).
+//   Binario: "PHR1", periodo (uint32) y los resumen_t del rango.
+//   CSV: t,n,t_min,t_media,t_max,h_min,h_media,h_max.
+#ifndef HISTORIA_H
+#define HISTORIA_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "historia_codec.h"
+#include "sample_ring.h"
+
+#define HISTORIA_PARTICION "historia"
+#define HISTORIA_PAGINA    4096        // Un sector
+#define HISTORIA_COLA      64          // Registros pendientes de escribir en la flash
+#define HISTORIA_SIN_HORA  360         // Registros retenidos hasta tener hora (~1 h de muestras)
+#define HISTORIA_T_MIN     1700000000  // Hora Unix por debajo de la cual el reloj no está en hora
+
+// Buscar la partición, reconstruir el índice y arrancar la tarea de escritura
+esp_err_t historia_init(void);
+
+// Encolar una muestra válida (desde task_sensor; no bloquea)
+void historia_muestra(const sensor_sample_t *m);
+
+// Estado actual de los actuadores; solo se registra si ha cambiado (no bloquea)
+void historia_actuadores(uint32_t mascara);
+
+typedef esp_err_t (*historia_cb_t)(const historia_registro_t *r, void *arg);
+
+// Llamar a cb con los registros de [desde, hasta] en orden hasta que devuelva algo
+// distinto de ESP_OK (que se devuelve). pagina_buf: HISTORIA_PAGINA bytes.
+esp_err_t historia_recorrer(uint32_t desde, uint32_t hasta, void *pagina_buf, historia_cb_t cb, void *arg);
+
+// Registrar GET /api/history
+esp_err_t historia_registrar(httpd_handle_t server);
+
+#endif // HISTORIA_H
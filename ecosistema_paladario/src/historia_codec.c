@@ -0,0 +1,193 @@
+#include "historia_codec.h"
+
+#define FIN          0xFF
+#define EVENTO       0x80
+#define MASCARA_LARGA 0x3F
+#define V_EXPLICITO  25
+#define V_MASCARA    26
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static size_t poner_varint(uint8_t *out, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+// Devuelve los bytes leídos o 0 si el varint no cabe en len
+static size_t leer_varint(const uint8_t *in, size_t len, uint32_t *v) {
+    *v = 0;
+    for (size_t i = 0; i < len && i < 5; i++) {
+        *v |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+        if (!(in[i] & 0x80)) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+void historia_codec_inicio(historia_codec_t *c, const historia_base_t *base) {
+    c->t = base->t;
+    c->t_muestra = base->t;
+    c->intervalo = 0;
+    c->temperatura = base->temperatura;
+    c->humedad = base->humedad;
+    c->actuadores = base->actuadores;
+}
+
+historia_base_t historia_codec_base(const historia_codec_t *c, uint32_t t) {
+    historia_base_t b = {
+        .t = t,
+        .temperatura = c->temperatura,
+        .humedad = c->humedad,
+        .actuadores = c->actuadores,
+    };
+    return b;
+}
+
+size_t historia_codificar(historia_codec_t *c, const historia_registro_t *r, uint8_t *out) {
+    size_t n = 1;
+    if (r->tipo == HISTORIA_ACTUADORES) {
+        if (r->actuadores < MASCARA_LARGA) {
+            out[0] = EVENTO | r->actuadores;
+        } else {
+            out[0] = EVENTO | MASCARA_LARGA;
+            out[n++] = r->actuadores;
+        }
+        n += poner_varint(out + n, zigzag((int32_t)(r->t - c->t)));
+        c->t = r->t;
+        c->actuadores = r->actuadores;
+        return n;
+    }
+
+    int32_t intervalo = (int32_t)(r->t - c->t_muestra);
+    int32_t dod = (int32_t)((uint32_t)intervalo - (uint32_t)c->intervalo);
+    uint8_t tt = dod == 0 ? 0 : dod == 1 ? 1 : dod == -1 ? 2 : 3;
+    if (tt == 3) {
+        n += poner_varint(out + n, zigzag(dod));
+    }
+
+    int32_t dt = r->temperatura - c->temperatura;
+    int32_t dh = (int32_t)r->humedad - c->humedad;
+    uint8_t v;
+    if (r->actuadores != c->actuadores) {
+        v = V_MASCARA;
+    } else if (dt >= -2 && dt <= 2 && dh >= -2 && dh <= 2) {
+        v = (uint8_t)((dt + 2) * 5 + dh + 2);
+    } else {
+        v = V_EXPLICITO;
+    }
+    if (v >= V_EXPLICITO) {
+        n += poner_varint(out + n, zigzag(dt));
+        n += poner_varint(out + n, zigzag(dh));
+    }
+    if (v == V_MASCARA) {
+        out[n++] = r->actuadores;
+    }
+    out[0] = (uint8_t)(tt << 5 | v);
+
+    c->t = r->t;
+    c->t_muestra = r->t;
+    c->intervalo = intervalo;
+    c->temperatura = r->temperatura;
+    c->humedad = r->humedad;
+    c->actuadores = r->actuadores;
+    return n;
+}
+
+int historia_decodificar(historia_codec_t *c, const uint8_t *in, size_t len, historia_registro_t *r) {
+    if (len == 0 || in[0] == FIN) {
+        return 0;
+    }
+    uint8_t ctl = in[0];
+    size_t n = 1, k;
+    uint32_t u;
+
+    if (ctl & EVENTO) {
+        if (ctl & 0x40) {
+            return -1;
+        }
+        uint8_t mascara = ctl & MASCARA_LARGA;
+        if (mascara == MASCARA_LARGA) {
+            if (n >= len) {
+                return 0;
+            }
+            mascara = in[n++];
+        }
+        if ((k = leer_varint(in + n, len - n, &u)) == 0) {
+            return 0;
+        }
+        n += k;
+        c->t += (uint32_t)unzigzag(u);
+        c->actuadores = mascara;
+        *r = (historia_registro_t){
+            .t = c->t,
+            .tipo = HISTORIA_ACTUADORES,
+            .actuadores = mascara,
+            .temperatura = c->temperatura,
+            .humedad = c->humedad,
+        };
+        return (int)n;
+    }
+
+    uint8_t tt = ctl >> 5, v = ctl & 0x1F;
+    if (v > V_MASCARA) {
+        return -1;
+    }
+    int32_t dod = tt == 0 ? 0 : tt == 1 ? 1 : -1;
+    if (tt == 3) {
+        if ((k = leer_varint(in + n, len - n, &u)) == 0) {
+            return 0;
+        }
+        n += k;
+        dod = unzigzag(u);
+    }
+    int32_t dt, dh;
+    uint8_t mascara = c->actuadores;
+    if (v < V_EXPLICITO) {
+        dt = v / 5 - 2;
+        dh = v % 5 - 2;
+    } else {
+        if ((k = leer_varint(in + n, len - n, &u)) == 0) {
+            return 0;
+        }
+        n += k;
+        dt = unzigzag(u);
+        if ((k = leer_varint(in + n, len - n, &u)) == 0) {
+            return 0;
+        }
+        n += k;
+        dh = unzigzag(u);
+        if (v == V_MASCARA) {
+            if (n >= len) {
+                return 0;
+            }
+            mascara = in[n++];
+        }
+    }
+
+    c->intervalo = (int32_t)((uint32_t)c->intervalo + (uint32_t)dod);   // Sin desbordamiento con datos corruptos
+    c->t_muestra += (uint32_t)c->intervalo;
+    c->t = c->t_muestra;
+    c->temperatura = (int16_t)(c->temperatura + dt);
+    c->humedad = (uint16_t)(c->humedad + dh);
+    c->actuadores = mascara;
+    *r = (historia_registro_t){
+        .t = c->t,
+        .tipo = HISTORIA_MUESTRA,
+        .actuadores = mascara,
+        .temperatura = c->temperatura,
+        .humedad = c->humedad,
+    };
+    return (int)n;
+}
@@ -0,0 +1,67 @@
+// Codificación compacta del histórico (la comparten la flash y GET /api/history).
+// Estilo Gorilla, pero alineada a byte para poder añadir cada registro a la flash
+// por separado: una lectura típica ocupa un solo byte.
+//
+// Un flujo empieza con una base (historia_base_t, 9 bytes) que fija el estado inicial
+// y sigue con registros; cada uno empieza por un byte de control:
+//   0b0ttvvvvv  muestra
+//     tt: diferencia del intervalo respecto al de la muestra anterior (delta-of-delta)
+//         00 = 0, 01 = +1, 10 = -1, 11 = varint zigzag a continuación
+//     vvvvv 0..24: (dT, dH) en décimas dentro de [-2, 2] x [-2, 2] = (v / 5 - 2, v % 5 - 2)
+//           25: dT y dH como varint zigzag; 26: igual y además un byte con los actuadores
+//   0b10mmmmmm  cambio de actuadores: máscara mmmmmm (0x3F = la máscara va en el byte
+//               siguiente) y después el tiempo desde el registro anterior, varint zigzag
+//   0xFF        fin de los datos (flash borrada)
+// Sin pérdidas a la resolución del DHT22 (0.1 °C / 0.1 %).
+#ifndef HISTORIA_CODEC_H
+#define HISTORIA_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HISTORIA_CODEC_MAX 16        // Bytes máximos de un registro codificado
+
+typedef enum {
+    HISTORIA_MUESTRA = 'm',
+    HISTORIA_ACTUADORES = 'a',
+} historia_tipo_t;
+
+typedef struct {
+    uint32_t t;              // Hora Unix (s)
+    uint8_t tipo;            // historia_tipo_t
+    uint8_t actuadores;      // Máscara ACT_BIT(...) en ese momento
+    int16_t temperatura;     // Décimas de °C (en los cambios de actuadores, la última conocida)
+    uint16_t humedad;        // Décimas de %
+} historia_registro_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t t;
+    int16_t temperatura;
+    uint16_t humedad;
+    uint8_t actuadores;
+} historia_base_t;
+
+typedef struct {
+    uint32_t t;              // Último registro
+    uint32_t t_muestra;      // Última muestra
+    int32_t intervalo;       // Entre las dos últimas muestras
+    int16_t temperatura;
+    uint16_t humedad;
+    uint8_t actuadores;
+} historia_codec_t;
+
+// Estado inicial de un flujo
+void historia_codec_inicio(historia_codec_t *c, const historia_base_t *base);
+
+// Base que deja el estado actual (para empezar un flujo nuevo a la hora t sin perder
+// los últimos valores conocidos)
+historia_base_t historia_codec_base(const historia_codec_t *c, uint32_t t);
+
+// Codificar r en out (HISTORIA_CODEC_MAX bytes como mínimo); devuelve los bytes
+size_t historia_codificar(historia_codec_t *c, const historia_registro_t *r, uint8_t *out);
+
+// Decodificar el registro que empieza en in. Devuelve los bytes consumidos, 0 si se
+// acaban los datos (0xFF o registro incompleto) o -1 si el byte de control no es válido.
+int historia_decodificar(historia_codec_t *c, const uint8_t *in, size_t len, historia_registro_t *r);
+
+#endif // HISTORIA_CODEC_H
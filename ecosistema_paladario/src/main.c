@@ -1,7 +1,10 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_system.h"
@@ -9,119 +12,185 @@
 #include "esp_event.h"
 #include "nvs_flash.h"
 #include "esp_netif.h"
+#include "esp_netif_sntp.h"
 #include "esp_http_server.h"
 #include "mqtt_client.h"
-#include "esp_ota_ops.h"
-#include "esp_https_ota.h"
+#include "cJSON.h"
 #include "dht11.h"
+#include "actuadores.h"
+#include "sample_ring.h"
+#include "estado_sistema.h"
+#include "telemetria.h"
+#include "web_ui.h"
+#include "web_push.h"
+#include "ota_update.h"
+#include "control_clima.h"
+#include "riego.h"
+#include "historia.h"
+#include "reenvio.h"
+#include "wifi_conexion.h"
+#include "energia.h"
+#include "tareas.h"
+#include "metricas.h"
+#include "traza.h"
+#include "registro.h"
 #include "wifi_config.h"
 
-#define MIN(a,b) ((a) < (b) ? (a) : (b))
+// Documento JSON único con todo el estado
+#define MQTT_STATE_TOPIC MQTT_BASE_TOPIC"/state"
+// Control de clima: consignas (JSON, ver control_clima.h) y estado retenido
+#define MQTT_CLIMA_SET_TOPIC MQTT_BASE_TOPIC"/clima/set"
+#define MQTT_CLIMA_STATE_TOPIC MQTT_BASE_TOPIC"/clima/state"
+// Riego: límites y ventanas (JSON, ver riego.h) y estado retenido
+#define MQTT_RIEGO_SET_TOPIC MQTT_BASE_TOPIC"/riego/set"
+#define MQTT_RIEGO_STATE_TOPIC MQTT_BASE_TOPIC"/riego/state"
+// Muestras perdidas durante un corte, con su hora (ver reenvio.h)
+#define MQTT_REPLAY_TOPIC MQTT_BASE_TOPIC"/telemetria/replay"
+// Nivel del registro por etiqueta (JSON, ver registro.h)
+#define MQTT_REGISTRO_SET_TOPIC MQTT_BASE_TOPIC"/registro/set"
 
 static const char *TAG = "PALADARIO";
 
-// Definición de pines
+// Definición de pines (los relés están en la tabla de actuadores.h)
 #define DHT_GPIO 15  // D15 -> GPIO15 en ESP-32D
-#define BOMBA_LLUVIA_GPIO 25
-#define BOMBA_CASCADA_GPIO 26
-#define VENTILADOR_GPIO 27
-#define CALEFACCION_GPIO 33
-
-// Variables globales
-float temperatura = 0.0f;
-float humedad = 0.0f;
-bool bomba_lluvia_activa = false;
-bool bomba_cascada_activa = false;
-bool ventilador_activo = false;
-bool calefaccion_activa = false;
-bool wifi_conectado = false;
-bool dht_valido = false; // Publicar sensores solo tras primera lectura válida
+
+// Tras una OTA, segundos en marcha sin reiniciarse que bastan para dar la imagen por buena
+// aunque el servidor web no haya arrancado (sin red no es culpa de la imagen)
+#ifndef OTA_AUTOCOMPROBACION_S
+#define OTA_AUTOCOMPROBACION_S 300
+#endif
 
 httpd_handle_t server = NULL;
 static esp_mqtt_client_handle_t mqtt_client = NULL;
 
+// Muestras del sensor hacia el publicador MQTT (task_sensor nunca espera a la red)
+static sample_ring_t muestras;
+static TaskHandle_t publicador_handle = NULL;
+static volatile bool mqtt_conectado = false;
+static volatile bool publicar_forzado = false;  // Tras (re)conectar: publicar aunque no haya cambios
+static volatile bool publicar_clima = false;    // Consignas cambiadas o (re)conexión
+static volatile bool publicar_riego = false;    // Programa cambiado o (re)conexión
+static volatile bool web_listo = false;         // Servidor web arrancado y URIs registradas
+static volatile bool ota_registrada = false;    // Entre ellas POST /update
+
+// Eventos de red: el manejador de WiFi los marca y task_red arranca (o reactiva) los
+// servicios de red sin que nada más tenga que esperar a la WiFi
+static EventGroupHandle_t eventos_red;
+#define RED_CON_IP   BIT0   // Con IP ahora mismo
+#define RED_IP_NUEVA BIT1   // IP (re)obtenida y aún no atendida por task_red
+
+// Regularidad del periodo de task_sensor (ver tareas.h)
+#define SENSOR_PERIODO_MS 10000
+static tarea_periodo_t periodo_sensor;
+
+// Perfil de arranque: ms de cada fase de app_main desde la anterior
+static int64_t fase_us = 0;
+
 // Declaraciones
 void mqtt_publish_state();
 void mqtt_send_discovery();
 
-// GPIO
-void config_gpio(void) {
-    gpio_set_direction(BOMBA_LLUVIA_GPIO, GPIO_MODE_OUTPUT);
-    gpio_set_direction(BOMBA_CASCADA_GPIO, GPIO_MODE_OUTPUT);
-    gpio_set_direction(VENTILADOR_GPIO, GPIO_MODE_OUTPUT);
-    gpio_set_direction(CALEFACCION_GPIO, GPIO_MODE_OUTPUT);
-    // Iniciar apagado (LOW=apagado, HIGH=encendido)
-    gpio_set_level(BOMBA_LLUVIA_GPIO, 0);
-    gpio_set_level(BOMBA_CASCADA_GPIO, 0);
-    gpio_set_level(VENTILADOR_GPIO, 0);
-    gpio_set_level(CALEFACCION_GPIO, 0);
-    ESP_LOGI(TAG, "GPIOs configurados (logica normal: HIGH=ON, LOW=OFF)");
+// Estado actual de sensores y actuadores (de una sola foto coherente)
+static telemetria_estado_t estado_actual(void) {
+    estado_sistema_t s;
+    estado_sistema_leer(&s);
+    telemetria_estado_t e = {
+        .dht_valido = s.dht_valido,
+        .temperatura = s.temperatura,
+        .humedad = s.humedad,
+        .actuadores = s.actuadores,
+    };
+    return e;
 }
 
-// Control bombas - Lógica NORMAL: HIGH=ON, LOW=OFF
-void control_bomba_lluvia(bool activar) {
-    gpio_set_level(BOMBA_LLUVIA_GPIO, activar ? 1 : 0);
-    bomba_lluvia_activa = activar;
-    ESP_LOGI(TAG, "Bomba lluvia: %s (GPIO=%d)", activar ? "ON" : "OFF", activar ? 1 : 0);
+// esp_mqtt_client_publish contando el resultado en /metrics y en la traza
+static int mqtt_publicar(const char *topic, const char *data, int len, int qos, int retain) {
+    int id = esp_mqtt_client_publish(mqtt_client, topic, data, len, qos, retain);
+    metricas_mqtt_publicacion(id >= 0);
+    traza(TRAZA_MQTT_PUBLICA, qos, (uint32_t)id);
+    return id;
 }
 
-void control_bomba_cascada(bool activar) {
-    gpio_set_level(BOMBA_CASCADA_GPIO, activar ? 1 : 0);
-    bomba_cascada_activa = activar;
-    ESP_LOGI(TAG, "Bomba cascada: %s (GPIO=%d)", activar ? "ON" : "OFF", activar ? 1 : 0);
+// Bytes en la cola de salida de MQTT (para /metrics)
+static int mqtt_outbox(void) {
+    return mqtt_client ? esp_mqtt_client_get_outbox_size(mqtt_client) : 0;
 }
 
-void control_ventilador(bool activar) {
-    gpio_set_level(VENTILADOR_GPIO, activar ? 1 : 0);
-    ventilador_activo = activar;
-    ESP_LOGI(TAG, "Ventilador: %s (GPIO=%d)", activar ? "ON" : "OFF", activar ? 1 : 0);
-}
+#if MQTT_TELEMETRIA_LEGACY
+// Modo compatibilidad: un tópico retenido por entidad
+static void mqtt_publish_legacy(const telemetria_estado_t *e) {
+    // Sensores (solo si hay lectura válida; sin valores por defecto)
+    if (e->dht_valido) {
+        char payload[32];
+        snprintf(payload, sizeof(payload), "%.1f", e->temperatura);
+        mqtt_publicar(MQTT_BASE_TOPIC"/sensor/temperatura/state", payload, 0, 1, 1);
+        snprintf(payload, sizeof(payload), "%.1f", e->humedad);
+        mqtt_publicar(MQTT_BASE_TOPIC"/sensor/humedad/state", payload, 0, 1, 1);
+    }
 
-void control_calefaccion(bool activar) {
-    gpio_set_level(CALEFACCION_GPIO, activar ? 1 : 0);
-    calefaccion_activa = activar;
-    ESP_LOGI(TAG, "Calefaccion: %s (GPIO=%d)", activar ? "ON" : "OFF", activar ? 1 : 0);
+    char topic[96];
+    for (int i = 0; i < ACT_NUM; i++) {
+        snprintf(topic, sizeof(topic), MQTT_BASE_TOPIC"/switch/%s/state", actuadores[i].id);
+        mqtt_publicar(topic, (e->actuadores & ACT_BIT(i)) ? "ON" : "OFF", 0, 1, 1);
+    }
+}
+#endif
+
+// Publicar el documento de estado si hay cambios (o si se fuerza). Solo desde task_publicador.
+static void publicar_estado(const telemetria_estado_t *e, bool forzar) {
+    int64_t ahora = esp_timer_get_time();
+    if (!mqtt_conectado || mqtt_client == NULL) return;
+    if (!forzar && !telemetria_debe_publicar(e, ahora)) return;
+
+    char payload[192];
+    telemetria_json(e, payload, sizeof(payload));
+    mqtt_publicar(MQTT_STATE_TOPIC, payload, 0, 1, 1);
+#if MQTT_TELEMETRIA_LEGACY
+    mqtt_publish_legacy(e);
+#endif
+    telemetria_marcar_publicado(e, ahora);
 }
 
-// Publicar estado MQTT
+// Solicitar publicación del estado: no bloquea, la hace task_publicador
 void mqtt_publish_state() {
-    if (mqtt_client == NULL) return;
-
-    // Sensores (solo si hay lectura válida; sin valores por defecto)
-    if (dht_valido) {
-        char payload[32];
-        snprintf(payload, sizeof(payload), "%.1f", temperatura);
-        esp_mqtt_client_publish(mqtt_client, MQTT_BASE_TOPIC"/sensor/temperatura/state", payload, 0, 1, 1);
-        snprintf(payload, sizeof(payload), "%.1f", humedad);
-        esp_mqtt_client_publish(mqtt_client, MQTT_BASE_TOPIC"/sensor/humedad/state", payload, 0, 1, 1);
+    if (publicador_handle) {
+        xTaskNotifyGive(publicador_handle);
     }
+}
 
-    esp_mqtt_client_publish(mqtt_client, MQTT_BASE_TOPIC"/switch/bomba_lluvia/state", 
-                           bomba_lluvia_activa ? "ON" : "OFF", 0, 1, 1);
-    
-    esp_mqtt_client_publish(mqtt_client, MQTT_BASE_TOPIC"/switch/bomba_cascada/state", 
-                           bomba_cascada_activa ? "ON" : "OFF", 0, 1, 1);
-    
-    esp_mqtt_client_publish(mqtt_client, MQTT_BASE_TOPIC"/switch/ventilador/state", 
-                           ventilador_activo ? "ON" : "OFF", 0, 1, 1);
-    
-    esp_mqtt_client_publish(mqtt_client, MQTT_BASE_TOPIC"/switch/calefaccion/state", 
-                           calefaccion_activa ? "ON" : "OFF", 0, 1, 1);
+// Orden manual de un actuador (web, MQTT): las bombas pasan por los límites del
+// riego, el resto por el control de clima. false si el riego la rechaza.
+// recibida_us: cuándo llegó la orden, para medir la latencia hasta el GPIO (energia.h).
+static bool orden_manual(actuador_id_t id, bool activar, int64_t recibida_us) {
+    bool aceptada = true;
+    energia_orden(id, recibida_us);
+    if (riego_es_bomba(id)) {
+        publicar_riego = true;
+        aceptada = riego_manual(id, activar);
+    } else {
+        control_clima_manual(id, activar);
+    }
+    energia_orden(id, 0);   // Sin conmutación (rechazada o ya estaba así): no se mide
+    return aceptada;
 }
 
-// WiFi handler
+// WiFi handler (los reintentos y su espera los decide wifi_conexion.c)
 static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
+        wifi_conexion_iniciada();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        wifi_conexion_asociada(event_data);
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        wifi_conectado = false;
-        ESP_LOGI(TAG, "Desconectado, reintentando...");
-        esp_wifi_connect();
+        estado_sistema_wifi(false);
+        xEventGroupClearBits(eventos_red, RED_CON_IP);
+        wifi_conexion_perdida(event_data);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        wifi_conexion_ip();
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "IP: " IPSTR, IP2STR(&event->ip_info.ip));
         ESP_LOGI(TAG, "Accede via: http://" IPSTR "/ o http://ecosistema.local/", IP2STR(&event->ip_info.ip));
-        wifi_conectado = true;
+        estado_sistema_wifi(true);
+        xEventGroupSetBits(eventos_red, RED_CON_IP | RED_IP_NUEVA);
     }
 }
 
@@ -151,6 +220,11 @@ void wifi_init() {
     IP4_ADDR(&ip_info.netmask, 255, 255, 255, 0);     // Máscara de subred
     
     esp_netif_set_ip_info(sta_netif, &ip_info);
+
+    // DNS del router (sin DHCP no hay ninguno y SNTP no resolvería el servidor)
+    esp_netif_dns_info_t dns = { .ip.type = ESP_IPADDR_TYPE_V4 };
+    dns.ip.u_addr.ip4 = ip_info.gw;
+    esp_netif_set_dns_info(sta_netif, ESP_NETIF_DNS_MAIN, &dns);
     
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -164,6 +238,8 @@ void wifi_init() {
             .password = WIFI_PASSWORD,
         },
     };
+    // Directo al punto de acceso y canal de la última vez, si los hay
+    wifi_conexion_init(&wifi_config);
     
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
@@ -175,383 +251,307 @@ void wifi_init() {
 // MQTT handler
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data) {
     esp_mqtt_event_handle_t event = event_data;
+    traza(TRAZA_MQTT, event->event_id, (uint32_t)event->msg_id);
     
     switch (event->event_id) {
         case MQTT_EVENT_CONNECTED:
             ESP_LOGI(TAG, "MQTT conectado");
-            esp_mqtt_client_subscribe(mqtt_client, MQTT_BASE_TOPIC"/switch/bomba_lluvia/set", 0);
-            esp_mqtt_client_subscribe(mqtt_client, MQTT_BASE_TOPIC"/switch/bomba_cascada/set", 0);
-            esp_mqtt_client_subscribe(mqtt_client, MQTT_BASE_TOPIC"/switch/ventilador/set", 0);
-            esp_mqtt_client_subscribe(mqtt_client, MQTT_BASE_TOPIC"/switch/calefaccion/set", 0);
+            // Una sola suscripción para todos los actuadores; el despacho usa el índice de tópicos
+            esp_mqtt_client_subscribe(mqtt_client, MQTT_BASE_TOPIC"/switch/+/set", 0);
+            esp_mqtt_client_subscribe(mqtt_client, MQTT_CLIMA_SET_TOPIC, 0);
+            esp_mqtt_client_subscribe(mqtt_client, MQTT_RIEGO_SET_TOPIC, 0);
+            esp_mqtt_client_subscribe(mqtt_client, MQTT_REGISTRO_SET_TOPIC, 0);
+            mqtt_conectado = true;
             mqtt_send_discovery();
+            publicar_forzado = true;
+            publicar_clima = true;
+            publicar_riego = true;
             mqtt_publish_state();
             break;
+
+        case MQTT_EVENT_DISCONNECTED:
+            mqtt_conectado = false;
+            reenvio_corte();
+            ESP_LOGW(TAG, "MQTT desconectado");
+            break;
             
-        case MQTT_EVENT_DATA:
-            if (strncmp(event->topic, MQTT_BASE_TOPIC"/switch/bomba_lluvia/set", event->topic_len) == 0) {
-                control_bomba_lluvia(strncmp(event->data, "ON", event->data_len) == 0);
-                mqtt_publish_state();
+        case MQTT_EVENT_DATA: {
+            int64_t recibida_us = esp_timer_get_time();
+            if (event->data_len < event->total_data_len) {
+                // Mensaje mayor que el búfer del cliente: llega troceado y un trozo no es
+                // un JSON válido. Se avisa con el primero y se ignoran todos.
+                if (event->current_data_offset == 0) {
+                    ESP_LOGW(TAG, "Mensaje en %.*s demasiado largo (%d bytes): ignorado",
+                             event->topic_len, event->topic, event->total_data_len);
+                }
+                break;
             }
-            if (strncmp(event->topic, MQTT_BASE_TOPIC"/switch/bomba_cascada/set", event->topic_len) == 0) {
-                control_bomba_cascada(strncmp(event->data, "ON", event->data_len) == 0);
+            int id = actuador_por_topic(event->topic, event->topic_len);
+            if (id >= 0) {
+                if (!orden_manual(id, event->data_len == 2 && memcmp(event->data, "ON", 2) == 0, recibida_us)) {
+                    ESP_LOGW(TAG, "%s: orden rechazada por los límites del riego", actuadores[id].id);
+                }
                 mqtt_publish_state();
-            }
-            if (strncmp(event->topic, MQTT_BASE_TOPIC"/switch/ventilador/set", event->topic_len) == 0) {
-                control_ventilador(strncmp(event->data, "ON", event->data_len) == 0);
+            } else if (event->topic_len == sizeof(MQTT_CLIMA_SET_TOPIC) - 1 &&
+                       memcmp(event->topic, MQTT_CLIMA_SET_TOPIC, event->topic_len) == 0) {
+                if (!control_clima_config_json(event->data, event->data_len)) {
+                    ESP_LOGW(TAG, "Consignas de clima no válidas: %.*s", event->data_len, event->data);
+                }
+                publicar_clima = true;
                 mqtt_publish_state();
-            }
-            if (strncmp(event->topic, MQTT_BASE_TOPIC"/switch/calefaccion/set", event->topic_len) == 0) {
-                control_calefaccion(strncmp(event->data, "ON", event->data_len) == 0);
+            } else if (event->topic_len == sizeof(MQTT_RIEGO_SET_TOPIC) - 1 &&
+                       memcmp(event->topic, MQTT_RIEGO_SET_TOPIC, event->topic_len) == 0) {
+                if (!riego_config_json(event->data, event->data_len)) {
+                    ESP_LOGW(TAG, "Programa de riego no válido: %.*s", event->data_len, event->data);
+                }
+                publicar_riego = true;
                 mqtt_publish_state();
+            } else if (event->topic_len == sizeof(MQTT_REGISTRO_SET_TOPIC) - 1 &&
+                       memcmp(event->topic, MQTT_REGISTRO_SET_TOPIC, event->topic_len) == 0) {
+                if (!registro_config_json(event->data, event->data_len)) {
+                    ESP_LOGW(TAG, "Niveles de registro no válidos: %.*s", event->data_len, event->data);
+                }
             }
             break;
+        }
             
         default:
             break;
     }
 }
 
+// Origen del estado en Discovery: tópico por entidad (legacy) o campo del JSON de estado
+#if MQTT_TELEMETRIA_LEGACY
+#define DISC_STAT_T(tipo, entidad) "\"stat_t\":\"" MQTT_BASE_TOPIC "/" tipo "/" entidad "/state\","
+#else
+#define DISC_STAT_T(tipo, entidad) "\"stat_t\":\"" MQTT_STATE_TOPIC "\",\"val_tpl\":\"{{ value_json." entidad " }}\","
+#endif
+
+#define DISC_DEV "\"dev\":{\"ids\":[\"paladario\"],\"name\":\"Paladario\",\"mf\":\"DIY\",\"mdl\":\"ESP32\"}"
+
+// Mensajes de Discovery generados en compilación (rodata, en flash): en cada
+// reconexión se publican tal cual, sin formatear ni usar buffers de pila.
+typedef struct {
+    const char *topic;
+    const char *payload;
+    uint16_t len;
+} discovery_msg_t;
+
+#define DISC_MSG(topic_, payload_) { topic_, payload_, sizeof(payload_) - 1 }
+
+#define DISC_SWITCH(e, id, nombre, uniq, icono, ...) \
+    DISC_MSG(MQTT_DISCOVERY_PREFIX "/switch/" uniq "/config", \
+             "{\"name\":\"" nombre "\"," \
+             "\"cmd_t\":\"" MQTT_BASE_TOPIC "/switch/" id "/set\"," \
+             DISC_STAT_T("switch", id) \
+             "\"uniq_id\":\"" uniq "\"," \
+             "\"icon\":\"" icono "\"," \
+             DISC_DEV "}"),
+
+static const discovery_msg_t discovery_msgs[] = {
+    // Temperatura
+    DISC_MSG(MQTT_DISCOVERY_PREFIX "/sensor/paladario_temp/config",
+             "{\"name\":\"Paladario Temperatura\","
+             DISC_STAT_T("sensor", "temperatura")
+             "\"unit_of_meas\":\"°C\","
+             "\"dev_cla\":\"temperature\","
+             "\"uniq_id\":\"paladario_temp\","
+             DISC_DEV "}"),
+    // Humedad
+    DISC_MSG(MQTT_DISCOVERY_PREFIX "/sensor/paladario_hum/config",
+             "{\"name\":\"Paladario Humedad\","
+             DISC_STAT_T("sensor", "humedad")
+             "\"unit_of_meas\":\"%\","
+             "\"dev_cla\":\"humidity\","
+             "\"uniq_id\":\"paladario_hum\","
+             DISC_DEV "}"),
+    // Actuadores (tabla de actuadores.h)
+    ACTUADORES(DISC_SWITCH)
+};
+
 // MQTT Discovery
 void mqtt_send_discovery() {
     if (mqtt_client == NULL) return;
-    
-    char payload[512];
-    char topic[128];
 
-    // Temperatura
-    snprintf(topic, sizeof(topic), "%s/sensor/paladario_temp/config", MQTT_DISCOVERY_PREFIX);
-    snprintf(payload, sizeof(payload),
-             "{\"name\":\"Paladario Temperatura\"," 
-             "\"stat_t\":\"%s/sensor/temperatura/state\"," 
-             "\"unit_of_meas\":\"°C\"," 
-             "\"dev_cla\":\"temperature\"," 
-             "\"uniq_id\":\"paladario_temp\"," 
-             "\"dev\":{\"ids\":[\"paladario\"],\"name\":\"Paladario\",\"mf\":\"DIY\",\"mdl\":\"ESP32\"}}",
-             MQTT_BASE_TOPIC);
-    esp_mqtt_client_publish(mqtt_client, topic, payload, 0, 1, 1);
-    
-    // Humedad
-    snprintf(topic, sizeof(topic), "%s/sensor/paladario_hum/config", MQTT_DISCOVERY_PREFIX);
-    snprintf(payload, sizeof(payload),
-             "{\"name\":\"Paladario Humedad\"," 
-             "\"stat_t\":\"%s/sensor/humedad/state\"," 
-             "\"unit_of_meas\":\"%%\"," 
-             "\"dev_cla\":\"humidity\"," 
-             "\"uniq_id\":\"paladario_hum\"," 
-             "\"dev\":{\"ids\":[\"paladario\"],\"name\":\"Paladario\",\"mf\":\"DIY\",\"mdl\":\"ESP32\"}}",
-             MQTT_BASE_TOPIC);
-    esp_mqtt_client_publish(mqtt_client, topic, payload, 0, 1, 1);
-    
-    // Bomba Lluvia
-    snprintf(topic, sizeof(topic), "%s/switch/paladario_lluvia/config", MQTT_DISCOVERY_PREFIX);
-    snprintf(payload, sizeof(payload),
-             "{\"name\":\"Bomba Lluvia\","
-             "\"cmd_t\":\"%s/switch/bomba_lluvia/set\","
-             "\"stat_t\":\"%s/switch/bomba_lluvia/state\","
-             "\"uniq_id\":\"paladario_lluvia\","
-             "\"icon\":\"mdi:water\","
-             "\"dev\":{\"ids\":[\"paladario\"],\"name\":\"Paladario\",\"mf\":\"DIY\",\"mdl\":\"ESP32\"}}",
-             MQTT_BASE_TOPIC, MQTT_BASE_TOPIC);
-    esp_mqtt_client_publish(mqtt_client, topic, payload, 0, 1, 1);
-    
-    // Bomba Cascada
-    snprintf(topic, sizeof(topic), "%s/switch/paladario_cascada/config", MQTT_DISCOVERY_PREFIX);
-    snprintf(payload, sizeof(payload),
-             "{\"name\":\"Bomba Cascada\","
-             "\"cmd_t\":\"%s/switch/bomba_cascada/set\","
-             "\"stat_t\":\"%s/switch/bomba_cascada/state\","
-             "\"uniq_id\":\"paladario_cascada\","
-             "\"icon\":\"mdi:waterfall\","
-             "\"dev\":{\"ids\":[\"paladario\"],\"name\":\"Paladario\",\"mf\":\"DIY\",\"mdl\":\"ESP32\"}}",
-             MQTT_BASE_TOPIC, MQTT_BASE_TOPIC);
-    esp_mqtt_client_publish(mqtt_client, topic, payload, 0, 1, 1);
-    
-    // Ventilador
-    snprintf(topic, sizeof(topic), "%s/switch/paladario_ventilador/config", MQTT_DISCOVERY_PREFIX);
-    snprintf(payload, sizeof(payload),
-             "{\"name\":\"Ventilador\","
-             "\"cmd_t\":\"%s/switch/ventilador/set\","
-             "\"stat_t\":\"%s/switch/ventilador/state\","
-             "\"uniq_id\":\"paladario_ventilador\","
-             "\"icon\":\"mdi:fan\","
-             "\"dev\":{\"ids\":[\"paladario\"],\"name\":\"Paladario\",\"mf\":\"DIY\",\"mdl\":\"ESP32\"}}",
-             MQTT_BASE_TOPIC, MQTT_BASE_TOPIC);
-    esp_mqtt_client_publish(mqtt_client, topic, payload, 0, 1, 1);
-    
-    // Calefacción
-    snprintf(topic, sizeof(topic), "%s/switch/paladario_calefaccion/config", MQTT_DISCOVERY_PREFIX);
-    snprintf(payload, sizeof(payload),
-             "{\"name\":\"Calefaccion\","
-             "\"cmd_t\":\"%s/switch/calefaccion/set\","
-             "\"stat_t\":\"%s/switch/calefaccion/state\","
-             "\"uniq_id\":\"paladario_calefaccion\","
-             "\"icon\":\"mdi:radiator\","
-             "\"dev\":{\"ids\":[\"paladario\"],\"name\":\"Paladario\",\"mf\":\"DIY\",\"mdl\":\"ESP32\"}}",
-             MQTT_BASE_TOPIC, MQTT_BASE_TOPIC);
-    esp_mqtt_client_publish(mqtt_client, topic, payload, 0, 1, 1);
+    // QoS 0 + retain: el broker conserva la configuración y no se ocupa memoria del
+    // outbox esperando PUBACK; tras otra reconexión se vuelve a enviar igualmente.
+    for (size_t i = 0; i < sizeof(discovery_msgs) / sizeof(discovery_msgs[0]); i++) {
+        const discovery_msg_t *d = &discovery_msgs[i];
+        mqtt_publicar(d->topic, d->payload, d->len, 0, 1);
+    }
     
     ESP_LOGI(TAG, "Discovery MQTT enviado");
 }
 
-// Servidor web nuevo
+// Interfaz web: HTML estático comprimido en flash; el estado llega por /api/state.
+// Cache-Control no-cache + ETag: el navegador revalida con un 304 de pocos bytes y
+// tras una OTA recibe la versión nueva sin esperar a que caduque nada.
 static esp_err_t root_handler(httpd_req_t *req) {
-    const char *html_part1 = 
-        "<!DOCTYPE html><html><head>"
-        "<meta charset='UTF-8'>"
-        "<meta name='viewport' content='width=device-width, initial-scale=1'>"
-        "<title>Paladario Control</title>"
-        "<style>"
-        "body{font-family:Arial;margin:0;padding:20px;background:#f0f0f0}"
-        ".container{max-width:600px;margin:0 auto;background:white;padding:20px;border-radius:10px;box-shadow:0 2px 10px rgba(0,0,0,0.1)}"
-        "h1{color:#333;text-align:center;margin-bottom:30px}"
-        ".card{background:#f9f9f9;padding:15px;margin:15px 0;border-radius:8px;border-left:4px solid #4CAF50}"
-        ".status{font-size:24px;font-weight:bold;margin:10px 0}"
-        ".on{color:#4CAF50}"
-        ".off{color:#e74c3c}"
-        "button{width:100%;padding:15px;font-size:18px;border:none;border-radius:5px;cursor:pointer;margin:5px 0;transition:0.3s}"
-        ".btn-on{background:#4CAF50;color:white}"
-        ".btn-on:hover{background:#45a049}"
-        ".btn-off{background:#e74c3c;color:white}"
-        ".btn-off:hover{background:#c0392b}"
-        ".info{text-align:center;color:#666;margin-top:20px;font-size:14px}"
-        "</style>"
-        "</head><body>"
-        "<div class='container'>"
-        "<h1>🌿 Paladario Control</h1>";
-    
-    httpd_resp_send_chunk(req, html_part1, strlen(html_part1));
-    
-    char html_lluvia[400];
-    snprintf(html_lluvia, sizeof(html_lluvia),
-        "<div class='card'>"
-        "<h2>💧 Bomba Lluvia</h2>"
-        "<div class='status %s'>%s</div>"
-        "<form action='/lluvia' method='post'>"
-        "<button type='submit' name='action' value='on' class='btn-on'>ENCENDER</button>"
-        "<button type='submit' name='action' value='off' class='btn-off'>APAGAR</button>"
-        "</form>"
-        "</div>",
-        bomba_lluvia_activa ? "on" : "off",
-        bomba_lluvia_activa ? "● ENCENDIDA" : "○ APAGADA");
-    
-    httpd_resp_send_chunk(req, html_lluvia, strlen(html_lluvia));
-    
-    char html_cascada[400];
-    snprintf(html_cascada, sizeof(html_cascada),
-        "<div class='card'>"
-        "<h2>🌊 Bomba Cascada</h2>"
-        "<div class='status %s'>%s</div>"
-        "<form action='/cascada' method='post'>"
-        "<button type='submit' name='action' value='on' class='btn-on'>ENCENDER</button>"
-        "<button type='submit' name='action' value='off' class='btn-off'>APAGAR</button>"
-        "</form>"
-        "</div>",
-        bomba_cascada_activa ? "on" : "off",
-        bomba_cascada_activa ? "● ENCENDIDA" : "○ APAGADA");
-    
-    httpd_resp_send_chunk(req, html_cascada, strlen(html_cascada));
-    
-    char html_ventilador[400];
-    snprintf(html_ventilador, sizeof(html_ventilador),
-        "<div class='card'>"
-        "<h2>🌬️ Ventilador</h2>"
-        "<div class='status %s'>%s</div>"
-        "<form action='/ventilador' method='post'>"
-        "<button type='submit' name='action' value='on' class='btn-on'>ENCENDER</button>"
-        "<button type='submit' name='action' value='off' class='btn-off'>APAGAR</button>"
-        "</form>"
-        "</div>",
-        ventilador_activo ? "on" : "off",
-        ventilador_activo ? "● ENCENDIDO" : "○ APAGADO");
-    
-    httpd_resp_send_chunk(req, html_ventilador, strlen(html_ventilador));
-    
-    char html_calefaccion[400];
-    snprintf(html_calefaccion, sizeof(html_calefaccion),
-        "<div class='card'>"
-        "<h2>🔥 Calefacción</h2>"
-        "<div class='status %s'>%s</div>"
-        "<form action='/calefaccion' method='post'>"
-        "<button type='submit' name='action' value='on' class='btn-on'>ENCENDER</button>"
-        "<button type='submit' name='action' value='off' class='btn-off'>APAGAR</button>"
-        "</form>"
-        "</div>",
-        calefaccion_activa ? "on" : "off",
-        calefaccion_activa ? "● ENCENDIDA" : "○ APAGADA");
-    
-    httpd_resp_send_chunk(req, html_calefaccion, strlen(html_calefaccion));
-    
-    const char *html_sensor = 
-        "<div class='card'>"
-        "<h2>📊 Sensores</h2>"
-        "<p>🌡️ Temperatura: <strong>%.1f°C</strong></p>"
-        "<p>💦 Humedad: <strong>%.1f%%</strong></p>"
-        "</div>";
-
-    char sensor_buf[200];
-    int n = snprintf(sensor_buf, sizeof(sensor_buf), html_sensor, temperatura, humedad);
-    httpd_resp_send_chunk(req, sensor_buf, n);
-
-    const char *html_ota = 
-        "<div class='card'>"
-        "<h2>🔄 Actualización OTA</h2>"
-        "<form method='POST' action='/update' enctype='multipart/form-data'>"
-        "<input type='file' name='firmware' accept='.bin' style='width:100%;padding:10px;margin:10px 0'>"
-        "<button type='submit' style='background:#2196F3;color:white;width:100%;padding:15px;font-size:18px;border:none;border-radius:5px;cursor:pointer'>📤 Subir Firmware</button>"
-        "</form>"
-        "</div>";
-    httpd_resp_send_chunk(req, html_ota, strlen(html_ota));
-    
-    const char *html_end = 
-        "<div class='info'>"
-        "<p>Sistema ESP32 Paladario v1.0</p>"
-        "<p><a href='/'>↻ Actualizar</a></p>"
-        "</div>"
-        "</div>"
-        "</body></html>";
-    
-    httpd_resp_send_chunk(req, html_end, strlen(html_end));
-    httpd_resp_send_chunk(req, NULL, 0);
-    return ESP_OK;
+    char etag[24];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", etag, sizeof(etag)) == ESP_OK &&
+        strcmp(etag, web_ui_etag) == 0) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        httpd_resp_set_hdr(req, "ETag", web_ui_etag);
+        httpd_resp_send(req, NULL, 0);
+        return ESP_OK;
+    }
+    // Todos los navegadores actuales aceptan gzip; no se guarda copia sin comprimir
+    httpd_resp_set_type(req, "text/html; charset=utf-8");
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(req, "ETag", web_ui_etag);
+    return httpd_resp_send(req, (const char *)web_ui_index_gz, web_ui_index_gz_len);
 }
 
-static esp_err_t lluvia_handler(httpd_req_t *req) {
-    char content[100];
-    int ret = httpd_req_recv(req, content, sizeof(content));
-    
-    if (ret > 0) {
-        if (strstr(content, "action=on")) {
-            control_bomba_lluvia(true);
-        } else if (strstr(content, "action=off")) {
-            control_bomba_lluvia(false);
-        }
-        mqtt_publish_state();
-    }
-    
-    httpd_resp_set_status(req, "303 See Other");
-    httpd_resp_set_hdr(req, "Location", "/");
-    httpd_resp_send(req, NULL, 0);
-    return ESP_OK;
+// Metadatos de la tabla de actuadores para construir la interfaz (constante, en flash).
+// Cada entrada empieza con ',': se envía "[" y el literal desde el segundo carácter.
+#define API_ACT_META(e, id, nombre, uniq, icono, gpio, titulo, fem, ...) \
+    ",{\"id\":\"" id "\",\"t\":\"" titulo "\",\"f\":" #fem "}"
+static const char api_actuadores_json[] = ACTUADORES(API_ACT_META) "]";
+
+static esp_err_t api_actuadores_handler(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_send_chunk(req, "[", 1);
+    httpd_resp_send_chunk(req, api_actuadores_json + 1, sizeof(api_actuadores_json) - 2);
+    return httpd_resp_send_chunk(req, NULL, 0);
 }
 
-static esp_err_t cascada_handler(httpd_req_t *req) {
-    char content[100];
-    int ret = httpd_req_recv(req, content, sizeof(content));
-    
-    if (ret > 0) {
-        if (strstr(content, "action=on")) {
-            control_bomba_cascada(true);
-        } else if (strstr(content, "action=off")) {
-            control_bomba_cascada(false);
-        }
-        mqtt_publish_state();
-    }
-    
-    httpd_resp_set_status(req, "303 See Other");
-    httpd_resp_set_hdr(req, "Location", "/");
-    httpd_resp_send(req, NULL, 0);
-    return ESP_OK;
+// Mismo documento JSON que se publica en MQTT_STATE_TOPIC
+static esp_err_t enviar_estado_json(httpd_req_t *req) {
+    char payload[192];
+    telemetria_estado_t e = estado_actual();
+    int n = telemetria_json(&e, payload, sizeof(payload));
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, payload, n);
+}
+
+static esp_err_t api_state_handler(httpd_req_t *req) {
+    return enviar_estado_json(req);
 }
 
-static esp_err_t ventilador_handler(httpd_req_t *req) {
+// POST /api/actuator {"id":"ventilador","on":true} -> responde con el estado nuevo
+static esp_err_t api_actuator_handler(httpd_req_t *req) {
+    int64_t recibida_us = esp_timer_get_time();
     char content[100];
-    int ret = httpd_req_recv(req, content, sizeof(content));
-    
-    if (ret > 0) {
-        if (strstr(content, "action=on")) {
-            control_ventilador(true);
-        } else if (strstr(content, "action=off")) {
-            control_ventilador(false);
+    if (req->content_len >= sizeof(content)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Cuerpo demasiado largo");
+        return ESP_FAIL;
+    }
+    int ret = energia_recibir(req, content, sizeof(content));
+    if (ret <= 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Sin cuerpo");
+        return ESP_FAIL;
+    }
+
+    cJSON *json = cJSON_Parse(content);
+    const cJSON *id = cJSON_GetObjectItemCaseSensitive(json, "id");
+    const cJSON *on = cJSON_GetObjectItemCaseSensitive(json, "on");
+    int act = -1;
+    if (cJSON_IsString(id) && cJSON_IsBool(on)) {
+        for (int i = 0; i < ACT_NUM; i++) {
+            if (strcmp(id->valuestring, actuadores[i].id) == 0) {
+                act = i;
+                break;
+            }
         }
-        mqtt_publish_state();
     }
-    
-    httpd_resp_set_status(req, "303 See Other");
-    httpd_resp_set_hdr(req, "Location", "/");
-    httpd_resp_send(req, NULL, 0);
-    return ESP_OK;
+    if (act < 0) {
+        cJSON_Delete(json);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Se espera {\"id\":<actuador>,\"on\":true|false}");
+        return ESP_FAIL;
+    }
+    bool aceptada = orden_manual(act, cJSON_IsTrue(on), recibida_us);
+    cJSON_Delete(json);
+
+    mqtt_publish_state();
+    if (!aceptada) {
+        // Bomba en enfriamiento o ciclo de trabajo agotado: el estado real va en el cuerpo
+        httpd_resp_set_status(req, "409 Conflict");
+    }
+    return enviar_estado_json(req);
 }
 
-static esp_err_t calefaccion_handler(httpd_req_t *req) {
-    char content[100];
-    int ret = httpd_req_recv(req, content, sizeof(content));
-    
-    if (ret > 0) {
-        if (strstr(content, "action=on")) {
-            control_calefaccion(true);
-        } else if (strstr(content, "action=off")) {
-            control_calefaccion(false);
-        }
-        mqtt_publish_state();
+// GET /api/clima: consignas y estado del control de clima
+static esp_err_t api_clima_get_handler(httpd_req_t *req) {
+    char payload[256];
+    int n = control_clima_json(payload, sizeof(payload));
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, payload, n);
+}
+
+// POST /api/clima {"temp_obj":24,"auto":true,...} -> responde con el estado nuevo
+static esp_err_t api_clima_post_handler(httpd_req_t *req) {
+    char content[160];
+    if (req->content_len >= sizeof(content)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Cuerpo demasiado largo");
+        return ESP_FAIL;
     }
-    
-    httpd_resp_set_status(req, "303 See Other");
-    httpd_resp_set_hdr(req, "Location", "/");
-    httpd_resp_send(req, NULL, 0);
-    return ESP_OK;
+    int ret = energia_recibir(req, content, sizeof(content));
+    if (ret <= 0 || !control_clima_config_json(content, ret)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            "Se espera {\"auto\":bool,\"temp_obj\":n,\"temp_max\":n,\"hum_max\":n}");
+        return ESP_FAIL;
+    }
+    publicar_clima = true;
+    mqtt_publish_state();
+    return api_clima_get_handler(req);
 }
 
-// OTA Update handler
-static esp_err_t ota_handler(httpd_req_t *req) {
-    char buf[1024];
-    int received;
-    int remaining = req->content_len;
-    
-    esp_ota_handle_t ota_handle;
-    const esp_partition_t *update_partition = esp_ota_get_next_update_partition(NULL);
-    
-    if (update_partition == NULL) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "No OTA partition");
+// GET /api/riego: límites, ventanas y saldo de cada bomba
+static esp_err_t api_riego_get_handler(httpd_req_t *req) {
+    char *payload = malloc(RIEGO_JSON_MAX);
+    if (payload == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Sin memoria");
         return ESP_FAIL;
     }
-    
-    ESP_LOGI(TAG, "Iniciando OTA...");
-    esp_err_t err = esp_ota_begin(update_partition, OTA_SIZE_UNKNOWN, &ota_handle);
-    if (err != ESP_OK) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA begin failed");
+    int n = riego_json(payload, RIEGO_JSON_MAX);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    esp_err_t err = httpd_resp_send(req, payload, n);
+    free(payload);
+    return err;
+}
+
+// POST /api/riego {"limites":{...},"ventanas":[...]} -> responde con el estado nuevo
+static esp_err_t api_riego_post_handler(httpd_req_t *req) {
+    if (req->content_len >= RIEGO_JSON_MAX) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Cuerpo demasiado largo");
         return ESP_FAIL;
     }
-    
-    while (remaining > 0) {
-        if ((received = httpd_req_recv(req, buf, MIN(remaining, sizeof(buf)))) <= 0) {
-            if (received == HTTPD_SOCK_ERR_TIMEOUT) {
-                continue;
-            }
-            esp_ota_abort(ota_handle);
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Upload failed");
-            return ESP_FAIL;
-        }
-        
-        if (esp_ota_write(ota_handle, buf, received) != ESP_OK) {
-            esp_ota_abort(ota_handle);
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA write failed");
-            return ESP_FAIL;
-        }
-        remaining -= received;
+    char *content = malloc(RIEGO_JSON_MAX);
+    if (content == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Sin memoria");
+        return ESP_FAIL;
     }
-    
-    if (esp_ota_end(ota_handle) != ESP_OK) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA end failed");
+    int ret = energia_recibir(req, content, RIEGO_JSON_MAX);
+    bool ok = ret > 0 && riego_config_json(content, ret);
+    free(content);
+    if (!ok) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            "Se espera {\"limites\":{<bomba>:{...}},\"ventanas\":[{\"bomba\",\"inicio\":\"HH:MM\",\"fin\",...}]}");
         return ESP_FAIL;
     }
-    
-    err = esp_ota_set_boot_partition(update_partition);
+    publicar_riego = true;
+    mqtt_publish_state();
+    return api_riego_get_handler(req);
+}
+
+// Avisar de lo que no se pudo registrar en el servidor web (p.ej. más de ENERGIA_URIS_MAX)
+static bool registrado(const char *que, esp_err_t err) {
     if (err != ESP_OK) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Set boot partition failed");
-        return ESP_FAIL;
+        ESP_LOGE(TAG, "No se pudo registrar %s en el servidor web: %s", que, esp_err_to_name(err));
     }
-    
-    httpd_resp_sendstr(req, "Update OK! Reiniciando...");
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    esp_restart();
-    
-    return ESP_OK;
+    return err == ESP_OK;
 }
 
 void start_webserver() {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.stack_size = 8192;
-    config.max_uri_handlers = 16;
+    config.max_uri_handlers = ENERGIA_URIS_MAX;
+    config.core_id = TAREAS_NUCLEO_RED;   // Con el resto de la red (tareas.h)
     
     if (httpd_start(&server, &config) == ESP_OK) {
         httpd_uri_t root = {
@@ -560,42 +560,63 @@ void start_webserver() {
             .handler = root_handler
         };
         
-        httpd_uri_t lluvia = {
-            .uri = "/lluvia",
-            .method = HTTP_POST,
-            .handler = lluvia_handler
+        httpd_uri_t api_state = {
+            .uri = "/api/state",
+            .method = HTTP_GET,
+            .handler = api_state_handler
         };
-        
-        httpd_uri_t cascada = {
-            .uri = "/cascada",
-            .method = HTTP_POST,
-            .handler = cascada_handler
+
+        httpd_uri_t api_actuadores = {
+            .uri = "/api/actuadores",
+            .method = HTTP_GET,
+            .handler = api_actuadores_handler
         };
-        
-        httpd_uri_t ventilador = {
-            .uri = "/ventilador",
+
+        httpd_uri_t api_actuator = {
+            .uri = "/api/actuator",
             .method = HTTP_POST,
-            .handler = ventilador_handler
+            .handler = api_actuator_handler
         };
-        
-        httpd_uri_t calefaccion = {
-            .uri = "/calefaccion",
+
+        httpd_uri_t api_clima_get = {
+            .uri = "/api/clima",
+            .method = HTTP_GET,
+            .handler = api_clima_get_handler
+        };
+
+        httpd_uri_t api_clima_post = {
+            .uri = "/api/clima",
             .method = HTTP_POST,
-            .handler = calefaccion_handler
+            .handler = api_clima_post_handler
         };
-        
-        httpd_uri_t ota = {
-            .uri = "/update",
+
+        httpd_uri_t api_riego_get = {
+            .uri = "/api/riego",
+            .method = HTTP_GET,
+            .handler = api_riego_get_handler
+        };
+
+        httpd_uri_t api_riego_post = {
+            .uri = "/api/riego",
             .method = HTTP_POST,
-            .handler = ota_handler
+            .handler = api_riego_post_handler
         };
-        
-        httpd_register_uri_handler(server, &root);
-        httpd_register_uri_handler(server, &lluvia);
-        httpd_register_uri_handler(server, &cascada);
-        httpd_register_uri_handler(server, &ventilador);
-        httpd_register_uri_handler(server, &calefaccion);
-        httpd_register_uri_handler(server, &ota);
+
+        httpd_uri_t *propias[] = {
+            &root, &api_state, &api_actuadores, &api_actuator,
+            &api_clima_get, &api_clima_post, &api_riego_get, &api_riego_post,
+        };
+        for (size_t i = 0; i < sizeof(propias) / sizeof(propias[0]); i++) {
+            registrado(propias[i]->uri, energia_registrar_uri(server, propias[i]));
+        }
+        ota_registrada = registrado("/update", ota_update_registrar(server));
+        registrado("/api/history", historia_registrar(server));
+        registrado("/api/energia", energia_registrar(server));
+        registrado("/metrics", metricas_registrar(server, mqtt_outbox));
+        registrado("/api/traza", traza_registrar(server));
+        registrado("/api/registro", registro_registrar(server));
+        registrado("/ws", web_push_init(server));
+        web_listo = true;
         
         ESP_LOGI(TAG, "Servidor web iniciado con OTA");
     }
@@ -608,6 +629,10 @@ void mqtt_init() {
         .broker.address.port = MQTT_PORT,
         .credentials.username = MQTT_USER,
         .credentials.authentication.password = MQTT_PASS,
+        // Sin broker, la cola de QoS 1 no crece sin límite: lo perdido se reenvía desde el histórico
+        .outbox.limit = MQTT_OUTBOX_LIMITE,
+        // Un programa de riego entero (riego/set) llega en un solo evento, con tópico y cabecera
+        .buffer.size = RIEGO_JSON_MAX + 256,
     };
     
     mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
@@ -616,6 +641,30 @@ void mqtt_init() {
     ESP_LOGI(TAG, "MQTT iniciado");
 }
 
+// Autocomprobación de una imagen recién actualizada: las tareas del control local creadas
+// y, además, o el servidor web con /update registrado (se puede volver a actualizar) o
+// OTA_AUTOCOMPROBACION_S en marcha sin reiniciarse. Si se reinicia antes, el bootloader
+// vuelve a la imagen anterior; si el servidor web arrancó sin /update, se vuelve ya (no
+// habría forma de corregirla sin USB). No cuentan el sensor (una OTA puede ser justo para
+// arreglarlo) ni el histórico (en placas con la tabla de particiones anterior no tiene
+// partición).
+static void autocomprobacion_ota(void) {
+    static const tarea_id_t locales[] = { TAREA_CLIMA, TAREA_SENSOR, TAREA_PUBLICADOR, TAREA_RED };
+    if (!ota_update_pendiente()) {
+        return;
+    }
+    for (size_t i = 0; i < sizeof(locales) / sizeof(locales[0]); i++) {
+        if (tarea_handle(locales[i]) == NULL) {
+            return;
+        }
+    }
+    if (web_listo && !ota_registrada) {
+        ota_update_revertir();
+    } else if (ota_registrada || esp_timer_get_time() >= OTA_AUTOCOMPROBACION_S * 1000000LL) {
+        ota_update_confirmar();
+    }
+}
+
 // Tarea sensor (DHT22 AM2302 en GPIO4)
 void task_sensor(void *pvParameter) {
     // Configurar GPIO con pull-up interno
@@ -633,23 +682,40 @@ void task_sensor(void *pvParameter) {
     }
 
     int errores = 0;
+    TickType_t ultimo_ciclo = xTaskGetTickCount();
     while (1) {
+        tarea_periodo_marcar(&periodo_sensor, SENSOR_PERIODO_MS * 1000LL);
         float h = 0, t = 0;
         esp_err_t res = ESP_FAIL;
         for (int intento = 0; intento < 3; intento++) {
+            if (intento > 0) {
+                metricas_dht_reintento();
+            }
             res = dht11_read(DHT_GPIO, &h, &t);
             if (res == ESP_OK) break;
             vTaskDelay(pdMS_TO_TICKS(500));
         }
 
         if (res == ESP_OK) {
-            temperatura = t;
-            humedad = h;
-            dht_valido = true;
             errores = 0;
-            ESP_LOGI(TAG, "DHT22 OK: T=%.1f°C H=%.1f%%", temperatura, humedad);
-            if (wifi_conectado && mqtt_client) {
-                mqtt_publish_state();
+            ESP_LOGI(TAG, "DHT22 OK: T=%.1f°C H=%.1f%%", t, h);
+
+            // Entregar la muestra al publicador sin bloquear
+            sensor_sample_t m = {
+                .timestamp_us = esp_timer_get_time(),
+                .temperatura = t,
+                .humedad = h,
+            };
+            estado_sistema_sensor(t, h, m.timestamp_us);
+            control_clima_muestra(&m);
+            riego_muestra(&m);
+            historia_muestra(&m);
+            if (!sample_ring_push(&muestras, &m)) {
+                ESP_LOGW(TAG, "Cola de muestras llena (%lu descartadas)",
+                         (unsigned long)sample_ring_overflows(&muestras));
+            }
+            if (publicador_handle) {
+                xTaskNotifyGive(publicador_handle);
             }
         } else {
             errores++;
@@ -657,46 +723,164 @@ void task_sensor(void *pvParameter) {
             // No modificar temperatura/humedad: sin valores por defecto
         }
 
-        vTaskDelay(pdMS_TO_TICKS(10000));
+        // Cadencia fija de 10s independiente de la duración de la lectura
+        xTaskDelayUntil(&ultimo_ciclo, pdMS_TO_TICKS(SENSOR_PERIODO_MS));
     }
 }
 
-// Tarea estado
+// Tarea publicador: consume las muestras y hace el I/O MQTT fuera de task_sensor;
+// también entrega cada estado a los clientes WebSocket (solo encola).
+// Despierta con cada muestra o petición de publicación, y como mínimo una vez por latido
+// (o por REENVIO_INTERVALO_MS mientras haya lotes por reenviar tras un corte).
+void task_publicador(void *pvParameter) {
+    sensor_sample_t m;
+    int64_t proximo_lote_us = 0;
+    while (1) {
+        bool reenviar = reenvio_pendiente() && mqtt_conectado;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(reenviar ? REENVIO_INTERVALO_MS : TELEMETRIA_HEARTBEAT_S * 1000));
+        bool forzar = publicar_forzado;
+        publicar_forzado = false;
+
+        telemetria_estado_t e = estado_actual();
+        historia_actuadores(e.actuadores);
+        while (sample_ring_pop(&muestras, &m)) {
+            e.dht_valido = true;
+            e.temperatura = m.temperatura;
+            e.humedad = m.humedad;
+            publicar_estado(&e, false);
+            web_push_estado(&e);
+        }
+        publicar_estado(&e, forzar);
+        web_push_estado(&e);
+
+        if (publicar_clima && mqtt_conectado) {
+            publicar_clima = false;
+            char clima[256];
+            int n = control_clima_json(clima, sizeof(clima));
+            mqtt_publicar(MQTT_CLIMA_STATE_TOPIC, clima, n, 1, 1);
+        }
+        if (publicar_riego && mqtt_conectado) {
+            publicar_riego = false;
+            char *riego = malloc(RIEGO_JSON_MAX);
+            if (riego) {
+                int n = riego_json(riego, RIEGO_JSON_MAX);
+                mqtt_publicar(MQTT_RIEGO_STATE_TOPIC, riego, n, 1, 1);
+                free(riego);
+            }
+        }
+
+        // Lo perdido en un corte, después de lo vivo y a ritmo limitado
+        if (reenviar && mqtt_conectado && esp_timer_get_time() >= proximo_lote_us &&
+            esp_mqtt_client_get_outbox_size(mqtt_client) < REENVIO_OUTBOX_MAX) {
+            proximo_lote_us = esp_timer_get_time() + REENVIO_INTERVALO_MS * 1000LL;
+            char *lote = malloc(REENVIO_JSON_MAX);
+            if (lote) {
+                int n = reenvio_lote(lote, REENVIO_JSON_MAX);
+                if (n > 0 && mqtt_publicar(MQTT_REPLAY_TOPIC, lote, n, 1, 0) >= 0) {
+                    reenvio_confirmar();
+                }
+                free(lote);
+            }
+        }
+    }
+}
+
+// Tarea estado (también la autocomprobación tras una OTA: la prioridad más baja, así
+// que llegar aquí ya dice que nada acapara la CPU)
 void task_estado(void *pvParameter) {
     while (1) {
-        ESP_LOGI(TAG, "T:%.1fC H:%.1f%% Lluvia:%s Cascada:%s Vent:%s Calef:%s",
-                temperatura, humedad,
-                bomba_lluvia_activa ? "ON" : "OFF",
-                bomba_cascada_activa ? "ON" : "OFF",
-                ventilador_activo ? "ON" : "OFF",
-                calefaccion_activa ? "ON" : "OFF");
+        autocomprobacion_ota();
+        estado_sistema_t s;
+        estado_sistema_leer(&s);
+        char act[128];
+        int n = 0;
+        for (int i = 0; i < ACT_NUM && n < (int)sizeof(act); i++) {
+            n += snprintf(act + n, sizeof(act) - n, " %s:%s", actuadores[i].id, (s.actuadores & ACT_BIT(i)) ? "ON" : "OFF");
+        }
+        ESP_LOGI(TAG, "T:%.1fC H:%.1f%%%s", s.temperatura, s.humedad, act);
+        ESP_LOGI(TAG, "Cola muestras: %lu pendientes, max %lu, descartadas %lu",
+                (unsigned long)sample_ring_depth(&muestras),
+                (unsigned long)sample_ring_max_depth(&muestras),
+                (unsigned long)sample_ring_overflows(&muestras));
+        tarea_periodo_t p;
+        tarea_periodo_leer(&periodo_sensor, &p);
+        ESP_LOGI(TAG, "Periodo sensor: %lu medidos, desvío medio %lu us, máx %lu us",
+                 (unsigned long)p.n, (unsigned long)(p.n ? p.suma_us / p.n : 0), (unsigned long)p.max_us);
         vTaskDelay(pdMS_TO_TICKS(15000)); // Cada 15s
     }
 }
 
+// SNTP: la hora local que necesitan las ventanas de riego
+static void hora_sincronizada(struct timeval *tv) {
+    riego_reprogramar();
+}
+
+static void arranque_fase(const char *fase) {
+    int64_t ahora = esp_timer_get_time();
+    ESP_LOGI(TAG, "Arranque: %-10s %5lld ms (total %lld ms)", fase,
+             (long long)((ahora - fase_us) / 1000), (long long)(ahora / 1000));
+    fase_us = ahora;
+}
+
+// Tarea red: arranca el servidor web y MQTT con la primera IP y los reintenta con cada
+// IP nueva si no llegaron a arrancar. Tras una reconexión adelanta la de MQTT en vez de
+// esperar a su propio temporizador de reintento.
+void task_red(void *pvParameter) {
+    bool lista = false;
+    while (1) {
+        xEventGroupWaitBits(eventos_red, RED_IP_NUEVA, pdTRUE, pdFALSE, portMAX_DELAY);
+        ESP_LOGI(TAG, "Arranque: IP a los %lld ms", (long long)(esp_timer_get_time() / 1000));
+
+        if (server == NULL) {
+            start_webserver();
+        }
+        if (mqtt_client == NULL) {
+            mqtt_init();
+        } else if (!mqtt_conectado) {
+            esp_mqtt_client_reconnect(mqtt_client);
+        }
+        if (!lista && server != NULL && mqtt_client != NULL) {
+            lista = true;
+            ESP_LOGI(TAG, "Arranque: red lista a los %lld ms - Control por Home Assistant",
+                     (long long)(esp_timer_get_time() / 1000));
+        }
+    }
+}
+
 void app_main() {
+    registro_init();
     ESP_LOGI(TAG, "=== PALADARIO MQTT ===");
-    
-    config_gpio();
+    fase_us = esp_timer_get_time();
+    traza_init();
+    arranque_fase("app_main");
+    eventos_red = xEventGroupCreate();
+    
+    actuadores_init();
+    // El control de clima no depende de la red: arranca antes que la WiFi
+    control_clima_init(mqtt_publish_state);
+    arranque_fase("actuadores");
     wifi_init();
-    
-    ESP_LOGI(TAG, "Esperando WiFi...");
-    int timeout = 20;
-    while (!wifi_conectado && timeout > 0) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        timeout--;
-    }
-    
-    if (wifi_conectado) {
-        start_webserver();
-        mqtt_init();
-        ESP_LOGI(TAG, "Sistema listo - Control por Home Assistant");
-    } else {
-        ESP_LOGW(TAG, "Sin WiFi - Modo offline");
-    }
-    
-    xTaskCreate(&task_sensor, "sensor", 4096, NULL, 5, NULL);
-    xTaskCreate(&task_estado, "estado", 2048, NULL, 5, NULL);
-    
-    ESP_LOGI(TAG, "Sistema iniciado");
+    energia_init();
+    arranque_fase("wifi");
+    // El riego lee su programa de NVS (inicializada en wifi_init) y arranca sin esperar a la red;
+    // las ventanas horarias empiezan cuando SNTP da la hora
+    riego_init(mqtt_publish_state);
+    reenvio_init();
+    esp_sntp_config_t sntp = ESP_NETIF_SNTP_DEFAULT_CONFIG(RIEGO_NTP_SERVIDOR);
+    sntp.sync_cb = hora_sincronizada;
+    esp_netif_sntp_init(&sntp);
+    arranque_fase("riego");
+    historia_init();
+    arranque_fase("historia");
+    
+    // Sensor y publicación no esperan a la red: lo que se mida sin conexión se publica
+    // (o se reenvía desde el histórico) al conectar
+    sample_ring_init(&muestras);
+    publicador_handle = tarea_crear(TAREA_PUBLICADOR, task_publicador, NULL);
+    tarea_crear(TAREA_SENSOR, task_sensor, NULL);
+    tarea_crear(TAREA_ESTADO, task_estado, NULL);
+    tarea_crear(TAREA_RED, task_red, NULL);
+    arranque_fase("tareas");
+    
+    ESP_LOGI(TAG, "Sistema iniciado; web y MQTT arrancarán al obtener IP");
 }
@@ -0,0 +1,275 @@
+#include "metricas.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_system.h"
+#include "esp_wifi.h"
+#include "energia.h"
+#include "registro.h"
+#include "tareas.h"
+#include "wifi_conexion.h"
+
+#define NUCLEOS portNUM_PROCESSORS
+
+// Límites superiores de los cubos en µs; el último cubo (+Inf) va aparte
+static const uint32_t limites_dht[] = { 110000, 120000, 130000, 140000, 150000, 200000, 500000 };
+static const uint32_t limites_http[] = { 1000, 5000, 10000, 25000, 50000, 100000, 250000, 1000000 };
+#define CUBOS_DHT  (sizeof(limites_dht) / sizeof(limites_dht[0]) + 1)
+#define CUBOS_HTTP (sizeof(limites_http) / sizeof(limites_http[0]) + 1)
+
+typedef struct {
+    uint32_t n[NUCLEOS];
+} contador_t;
+
+typedef struct {
+    uint64_t suma_us[NUCLEOS];
+    uint32_t cubos[NUCLEOS][CUBOS_HTTP];   // Sin acumular; el mayor de los dos tamaños
+} histograma_t;
+_Static_assert(CUBOS_HTTP >= CUBOS_DHT, "Ampliar los cubos del histograma");
+
+typedef struct {
+    const char *uri;
+    httpd_method_t metodo;
+    histograma_t duracion;
+} uri_t;
+
+static histograma_t dht_lectura;
+static contador_t dht_reintentos;
+static contador_t dht_fallos[DHT_FALLO_NUM];
+static contador_t mqtt_publicaciones;
+static contador_t mqtt_fallos;
+static uri_t uris[ENERGIA_URIS_MAX];
+static int num_uris = 0;
+static int (*outbox)(void) = NULL;
+
+#define DHT_FALLO_ETIQUETA(id, etiqueta) [id] = etiqueta,
+static const char *const sitios_dht[DHT_FALLO_NUM] = {
+    DHT_FALLOS(DHT_FALLO_ETIQUETA)
+};
+#undef DHT_FALLO_ETIQUETA
+
+// Tareas del sistema que no crea tareas.c (nombres de ESP-IDF y esp-mqtt)
+static const char *const tareas_sistema[] = { "wifi", "tiT", "sys_evt", "esp_timer", "mqtt_task", "httpd" };
+
+// Escrituras: solo la ranura del núcleo actual, con sus interrupciones enmascaradas
+// (ni otra tarea ni una ISR del mismo núcleo pueden colarse a mitad)
+static void contar(contador_t *c) {
+    UBaseType_t m = portSET_INTERRUPT_MASK_FROM_ISR();
+    c->n[xPortGetCoreID()]++;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(m);
+}
+
+static void observar(histograma_t *h, const uint32_t *limites, size_t num, uint32_t us) {
+    size_t i = 0;
+    while (i < num && us > limites[i]) {
+        i++;
+    }
+    UBaseType_t m = portSET_INTERRUPT_MASK_FROM_ISR();
+    int c = xPortGetCoreID();
+    h->cubos[c][i]++;
+    h->suma_us[c] += us;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(m);
+}
+
+// Lecturas desde otro núcleo: 32 bits se leen enteros; 64 bits pueden salir partidos
+// si se escriben a la vez, así que se leen hasta que dos lecturas coinciden
+static uint32_t total(const contador_t *c) {
+    uint32_t t = 0;
+    for (int i = 0; i < NUCLEOS; i++) {
+        t += ((volatile const uint32_t *)c->n)[i];
+    }
+    return t;
+}
+
+static uint64_t leer64(const uint64_t *p) {
+    volatile const uint64_t *v = p;
+    uint64_t a, b;
+    do {
+        a = *v;
+        b = *v;
+    } while (a != b);
+    return a;
+}
+
+void metricas_dht_lectura(uint32_t us) {
+    observar(&dht_lectura, limites_dht, CUBOS_DHT - 1, us);
+}
+
+void metricas_dht_reintento(void) {
+    contar(&dht_reintentos);
+}
+
+void metricas_dht_fallo(dht_fallo_t sitio) {
+    contar(&dht_fallos[sitio]);
+}
+
+void metricas_mqtt_publicacion(bool ok) {
+    contar(ok ? &mqtt_publicaciones : &mqtt_fallos);
+}
+
+// Solo al arrancar el servidor web (una tarea)
+int metricas_http_alta(const char *uri, httpd_method_t metodo) {
+    if (num_uris == ENERGIA_URIS_MAX) {
+        return -1;
+    }
+    uris[num_uris].uri = uri;
+    uris[num_uris].metodo = metodo;
+    return num_uris++;
+}
+
+void metricas_http(int uri, uint32_t us) {
+    if (uri >= 0) {
+        observar(&uris[uri].duracion, limites_http, CUBOS_HTTP - 1, us);
+    }
+}
+
+// Respuesta por trozos desde un búfer en la pila de httpd
+typedef struct {
+    httpd_req_t *req;
+    esp_err_t err;
+    int n;
+    char buf[768];
+} salida_t;
+
+static void volcar(salida_t *s) {
+    if (s->n > 0 && s->err == ESP_OK) {
+        s->err = httpd_resp_send_chunk(s->req, s->buf, s->n);
+    }
+    s->n = 0;
+}
+
+static void escribir(salida_t *s, const char *fmt, ...) {
+    for (int intento = 0; intento < 2; intento++) {
+        va_list ap;
+        va_start(ap, fmt);
+        int r = vsnprintf(s->buf + s->n, sizeof(s->buf) - s->n, fmt, ap);
+        va_end(ap);
+        if (r >= 0 && s->n + r < (int)sizeof(s->buf)) {
+            s->n += r;
+            return;
+        }
+        volcar(s);
+    }
+}
+
+static void cabecera(salida_t *s, const char *nombre, const char *tipo, const char *ayuda) {
+    escribir(s, "# HELP %s %s\n# TYPE %s %s\n", nombre, ayuda, nombre, tipo);
+}
+
+// etiquetas: "" o 'clave="valor",...' (sin coma final)
+static void histograma(salida_t *s, const char *nombre, const char *etiquetas, const histograma_t *h,
+                       const uint32_t *limites, size_t num) {
+    const char *coma = etiquetas[0] ? "," : "";
+    uint64_t acumulado = 0;
+    uint64_t suma = 0;
+    for (size_t i = 0; i <= num; i++) {
+        for (int c = 0; c < NUCLEOS; c++) {
+            acumulado += ((volatile const uint32_t *)h->cubos[c])[i];
+        }
+        if (i < num) {
+            escribir(s, "%s_bucket{%s%sle=\"%g\"} %llu\n", nombre, etiquetas, coma, limites[i] / 1e6,
+                     (unsigned long long)acumulado);
+        } else {
+            escribir(s, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", nombre, etiquetas, coma, (unsigned long long)acumulado);
+        }
+    }
+    for (int c = 0; c < NUCLEOS; c++) {
+        suma += leer64(&h->suma_us[c]);
+    }
+    const char *abre = etiquetas[0] ? "{" : "";
+    const char *cierra = etiquetas[0] ? "}" : "";
+    escribir(s, "%s_sum%s%s%s %.6f\n%s_count%s%s%s %llu\n", nombre, abre, etiquetas, cierra, suma / 1e6,
+             nombre, abre, etiquetas, cierra, (unsigned long long)acumulado);
+}
+
+static void pila(salida_t *s, const char *nombre, TaskHandle_t t) {
+    if (t != NULL) {
+        escribir(s, "paladario_pila_libre_minima_bytes{tarea=\"%s\"} %u\n", nombre,
+                 (unsigned)uxTaskGetStackHighWaterMark(t));
+    }
+}
+
+static esp_err_t metricas_handler(httpd_req_t *req) {
+    salida_t *s = malloc(sizeof(salida_t));
+    if (s == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Sin memoria");
+        return ESP_FAIL;
+    }
+    s->req = req;
+    s->err = ESP_OK;
+    s->n = 0;
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+    cabecera(s, "paladario_dht_lectura_segundos", "histogram", "Duración de cada lectura del DHT22");
+    histograma(s, "paladario_dht_lectura_segundos", "", &dht_lectura, limites_dht, CUBOS_DHT - 1);
+    cabecera(s, "paladario_dht_reintentos_total", "counter", "Lecturas repetidas tras un fallo");
+    escribir(s, "paladario_dht_reintentos_total %lu\n", (unsigned long)total(&dht_reintentos));
+    cabecera(s, "paladario_dht_fallos_total", "counter", "Lecturas fallidas por sitio del fallo");
+    for (int i = 0; i < DHT_FALLO_NUM; i++) {
+        escribir(s, "paladario_dht_fallos_total{sitio=\"%s\"} %lu\n", sitios_dht[i], (unsigned long)total(&dht_fallos[i]));
+    }
+
+    cabecera(s, "paladario_mqtt_publicaciones_total", "counter", "Mensajes entregados a esp-mqtt");
+    escribir(s, "paladario_mqtt_publicaciones_total %lu\n", (unsigned long)total(&mqtt_publicaciones));
+    cabecera(s, "paladario_mqtt_fallos_total", "counter", "Publicaciones rechazadas por esp-mqtt");
+    escribir(s, "paladario_mqtt_fallos_total %lu\n", (unsigned long)total(&mqtt_fallos));
+    if (outbox != NULL) {
+        cabecera(s, "paladario_mqtt_outbox_bytes", "gauge", "Bytes pendientes en la cola de salida de MQTT");
+        escribir(s, "paladario_mqtt_outbox_bytes %d\n", outbox());
+    }
+
+    cabecera(s, "paladario_http_duracion_segundos", "histogram", "Peticiones HTTP por URI y su duración");
+    for (int i = 0; i < num_uris; i++) {
+        char etiquetas[96];
+        snprintf(etiquetas, sizeof(etiquetas), "uri=\"%s\",metodo=\"%s\"", uris[i].uri, http_method_str(uris[i].metodo));
+        histograma(s, "paladario_http_duracion_segundos", etiquetas, &uris[i].duracion, limites_http, CUBOS_HTTP - 1);
+    }
+
+    cabecera(s, "paladario_heap_libre_bytes", "gauge", "Heap libre");
+    escribir(s, "paladario_heap_libre_bytes %lu\n", (unsigned long)esp_get_free_heap_size());
+    cabecera(s, "paladario_heap_minimo_bytes", "gauge", "Mínimo de heap libre desde el arranque");
+    escribir(s, "paladario_heap_minimo_bytes %lu\n", (unsigned long)esp_get_minimum_free_heap_size());
+
+    cabecera(s, "paladario_pila_libre_minima_bytes", "gauge", "Mínimo de pila libre de cada tarea desde el arranque");
+    for (int i = 0; i < TAREA_NUM; i++) {
+        pila(s, tarea_nombre(i), tarea_handle(i));
+    }
+    for (size_t i = 0; i < sizeof(tareas_sistema) / sizeof(tareas_sistema[0]); i++) {
+        pila(s, tareas_sistema[i], xTaskGetHandle(tareas_sistema[i]));
+    }
+
+    wifi_metricas_t w;
+    wifi_conexion_metricas(&w);
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) {
+        cabecera(s, "paladario_wifi_rssi_dbm", "gauge", "Señal del punto de acceso");
+        escribir(s, "paladario_wifi_rssi_dbm %d\n", ap.rssi);
+    }
+    cabecera(s, "paladario_wifi_caidas_total", "counter", "Desconexiones tras haber tenido IP");
+    escribir(s, "paladario_wifi_caidas_total %lu\n", (unsigned long)w.caidas);
+    cabecera(s, "paladario_wifi_intentos_fallidos_total", "counter", "Intentos de conexión fallidos");
+    escribir(s, "paladario_wifi_intentos_fallidos_total %lu\n", (unsigned long)w.intentos);
+    cabecera(s, "paladario_wifi_reconexion_segundos", "gauge", "Lo que tardó la última reconexión");
+    escribir(s, "paladario_wifi_reconexion_segundos %.3f\n", w.ultima_ms / 1e3);
+
+    cabecera(s, "paladario_registro_perdidos_total", "counter", "Líneas de registro descartadas con el anillo lleno");
+    escribir(s, "paladario_registro_perdidos_total %lu\n", (unsigned long)registro_perdidos());
+
+    volcar(s);
+    esp_err_t err = s->err == ESP_OK ? httpd_resp_send_chunk(req, NULL, 0) : s->err;
+    free(s);
+    return err;
+}
+
+esp_err_t metricas_registrar(httpd_handle_t server, int (*mqtt_outbox)(void)) {
+    outbox = mqtt_outbox;
+    httpd_uri_t metricas = {
+        .uri = "/metrics",
+        .method = HTTP_GET,
+        .handler = metricas_handler,
+    };
+    return energia_registrar_uri(server, &metricas);
+}
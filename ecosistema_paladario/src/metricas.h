@@ -0,0 +1,51 @@
+// Métricas del firmware para Prometheus: GET /metrics en el servidor web (formato de
+// texto 0.0.4), para rasparlo desde el Prometheus de casa igual en cada paludario.
+//
+// Cada contador e histograma tiene una ranura por núcleo: incrementar es enmascarar las
+// interrupciones del propio núcleo unos ciclos (nadie más escribe esa ranura), sin
+// spinlock ni operaciones atómicas entre núcleos, así que se puede llamar en cualquier
+// camino de la aplicación sin perturbarlo. Al raspar se suman las ranuras.
+// Los valores instantáneos (heap, pilas, RSSI, cola de MQTT) se leen al raspar.
+#ifndef METRICAS_H
+#define METRICAS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+// Dónde falla una lectura en dht11_read: X(id, etiqueta sitio="...")
+#define DHT_FALLOS(X) \
+    X(DHT_FALLO_RMT,         "rmt")          /* No se pudo crear o habilitar el canal RMT */ \
+    X(DHT_FALLO_RECEPCION,   "recepcion")    /* rmt_receive rechazó la captura */ \
+    X(DHT_FALLO_TIMEOUT,     "timeout")      /* El sensor no respondió */ \
+    X(DHT_FALLO_TRAMA_CORTA, "trama_corta")  /* Menos de 40 bits */ \
+    X(DHT_FALLO_TIEMPOS,     "tiempos")      /* Pulso imposible */ \
+    X(DHT_FALLO_CHECKSUM,    "checksum") \
+    X(DHT_FALLO_CEROS,       "ceros")        /* Trama todo ceros */ \
+    X(DHT_FALLO_RANGO,       "rango")        /* Valores fuera de rango */
+
+#define DHT_FALLO_ENUM(id, etiqueta) id,
+typedef enum {
+    DHT_FALLOS(DHT_FALLO_ENUM)
+    DHT_FALLO_NUM
+} dht_fallo_t;
+#undef DHT_FALLO_ENUM
+
+// Sensor: duración de cada dht11_read, reintentos de task_sensor y fallos por sitio
+void metricas_dht_lectura(uint32_t us);
+void metricas_dht_reintento(void);
+void metricas_dht_fallo(dht_fallo_t sitio);
+
+// Resultado de cada esp_mqtt_client_publish
+void metricas_mqtt_publicacion(bool ok);
+
+// Dar de alta una URI (al registrarla) y anotar cada petición con su duración.
+// -1 si ya hay ENERGIA_URIS_MAX (energia_registrar_uri no deja llegar); metricas_http lo ignora.
+int metricas_http_alta(const char *uri, httpd_method_t metodo);
+void metricas_http(int uri, uint32_t us);
+
+// GET /metrics. mqtt_outbox: bytes pendientes en la cola de salida de MQTT.
+esp_err_t metricas_registrar(httpd_handle_t server, int (*mqtt_outbox)(void));
+
+#endif // METRICAS_H
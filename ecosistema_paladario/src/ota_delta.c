@@ -0,0 +1,175 @@
+#include "ota_delta.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "OTA_DELTA";
+
+struct ota_delta {
+    const esp_partition_t *base;
+    ota_delta_salida_t salida;
+    void *ctx;
+    uint8_t *buf_base;               // Lectura de la partición base
+    uint8_t *buf_salida;             // Acumula la imagen nueva hasta OTA_DELTA_BUF
+    size_t n_salida;
+    uint8_t cab[OTA_DELTA_CAB];      // Cabecera del registro en curso (o el magic)
+    size_t n_cab;
+    bool magic_ok;
+    bool fin;
+    uint8_t op;                      // Registro con datos pendientes ('A' o 'D')
+    uint32_t restante;
+    uint32_t off_base;
+};
+
+static uint32_t leer_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Escrituras a flash de tamaño fijo aunque los registros sean de pocos bytes
+static esp_err_t emitir(ota_delta_t *d, const uint8_t *datos, size_t len) {
+    while (len > 0) {
+        size_t n = OTA_DELTA_BUF - d->n_salida < len ? OTA_DELTA_BUF - d->n_salida : len;
+        memcpy(d->buf_salida + d->n_salida, datos, n);
+        d->n_salida += n;
+        datos += n;
+        len -= n;
+        if (d->n_salida == OTA_DELTA_BUF) {
+            esp_err_t err = d->salida(d->ctx, d->buf_salida, d->n_salida);
+            d->n_salida = 0;
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+// len bytes de la base desde off; si dif != NULL se le suman byte a byte
+static esp_err_t desde_base(ota_delta_t *d, uint32_t off, const uint8_t *dif, size_t len) {
+    while (len > 0) {
+        size_t n = len < OTA_DELTA_BUF ? len : OTA_DELTA_BUF;
+        esp_err_t err = esp_partition_read(d->base, off, d->buf_base, n);
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (dif != NULL) {
+            for (size_t i = 0; i < n; i++) {
+                d->buf_base[i] += dif[i];
+            }
+            dif += n;
+        }
+        err = emitir(d, d->buf_base, n);
+        if (err != ESP_OK) {
+            return err;
+        }
+        off += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t empezar_registro(ota_delta_t *d) {
+    uint8_t op = d->cab[0];
+    uint32_t len = leer_u32(d->cab + 1);
+    uint32_t off = leer_u32(d->cab + 5);
+    if ((op == 'C' || op == 'D') && ((uint64_t)off + len > d->base->size)) {
+        ESP_LOGE(TAG, "Registro '%c' fuera de la base: %lu+%lu", op, (unsigned long)off, (unsigned long)len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    switch (op) {
+        case 'C':
+            return desde_base(d, off, NULL, len);
+        case 'D':
+        case 'A':
+            d->op = op;
+            d->restante = len;
+            d->off_base = off;
+            return ESP_OK;
+        case 'E':
+            d->fin = true;
+            return ESP_OK;
+        default:
+            ESP_LOGE(TAG, "Registro desconocido 0x%02x", op);
+            return ESP_ERR_INVALID_ARG;
+    }
+}
+
+ota_delta_t *ota_delta_crear(const esp_partition_t *base, ota_delta_salida_t salida, void *ctx) {
+    ota_delta_t *d = calloc(1, sizeof(*d));
+    if (d == NULL) {
+        return NULL;
+    }
+    d->base = base;
+    d->salida = salida;
+    d->ctx = ctx;
+    d->buf_base = heap_caps_malloc(OTA_DELTA_BUF, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    d->buf_salida = heap_caps_malloc(OTA_DELTA_BUF, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (d->buf_base == NULL || d->buf_salida == NULL) {
+        ota_delta_liberar(d);
+        return NULL;
+    }
+    return d;
+}
+
+esp_err_t ota_delta_procesar(ota_delta_t *d, const uint8_t *datos, size_t len) {
+    while (len > 0) {
+        if (d->fin) {
+            return ESP_ERR_INVALID_SIZE;  // Datos tras el registro 'E'
+        }
+        esp_err_t err;
+        if (d->restante == 0) {
+            size_t total = d->magic_ok ? OTA_DELTA_CAB : sizeof(OTA_DELTA_MAGIC) - 1;
+            size_t n = total - d->n_cab < len ? total - d->n_cab : len;
+            memcpy(d->cab + d->n_cab, datos, n);
+            d->n_cab += n;
+            datos += n;
+            len -= n;
+            if (d->n_cab < total) {
+                return ESP_OK;
+            }
+            d->n_cab = 0;
+            if (!d->magic_ok) {
+                if (memcmp(d->cab, OTA_DELTA_MAGIC, total) != 0) {
+                    return ESP_ERR_INVALID_VERSION;
+                }
+                d->magic_ok = true;
+                continue;
+            }
+            err = empezar_registro(d);
+        } else {
+            size_t n = d->restante < len ? d->restante : len;
+            if (d->op == 'A') {
+                err = emitir(d, datos, n);
+            } else {
+                err = desde_base(d, d->off_base, datos, n);
+                d->off_base += n;
+            }
+            d->restante -= n;
+            datos += n;
+            len -= n;
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t ota_delta_terminar(ota_delta_t *d) {
+    if (!d->fin) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t err = d->n_salida > 0 ? d->salida(d->ctx, d->buf_salida, d->n_salida) : ESP_OK;
+    d->n_salida = 0;
+    return err;
+}
+
+void ota_delta_liberar(ota_delta_t *d) {
+    if (d == NULL) {
+        return;
+    }
+    heap_caps_free(d->buf_base);
+    heap_caps_free(d->buf_salida);
+    free(d);
+}
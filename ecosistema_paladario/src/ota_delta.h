@@ -0,0 +1,40 @@
+// Aplicación en streaming de un parche delta (generado por ota_delta.py) contra la
+// imagen en ejecución: lee la partición activa y entrega la imagen nueva por bloques.
+//
+// Formato: "PDL1" y una serie de registros de cabecera fija (op, len, off; enteros
+// little-endian de 32 bits) seguida, según la op, de len bytes de datos:
+//   'C' copiar len bytes de la base desde off                 (sin datos)
+//   'D' len bytes de la base desde off más los datos (mod 256) (len datos)
+//   'A' len bytes nuevos                                      (len datos)
+//   'E' fin del parche                                        (sin datos)
+#ifndef OTA_DELTA_H
+#define OTA_DELTA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#define OTA_DELTA_MAGIC "PDL1"
+#define OTA_DELTA_CAB   9       // op + len + off
+#define OTA_DELTA_BUF   4096    // Lecturas de la base y escrituras de salida
+
+// Recibe la imagen reconstruida en bloques de OTA_DELTA_BUF (el último puede ser menor)
+typedef esp_err_t (*ota_delta_salida_t)(void *ctx, const uint8_t *datos, size_t len);
+
+typedef struct ota_delta ota_delta_t;
+
+// NULL si no hay memoria
+ota_delta_t *ota_delta_crear(const esp_partition_t *base, ota_delta_salida_t salida, void *ctx);
+
+// Consumir un trozo cualquiera del parche. Los errores de formato devuelven
+// ESP_ERR_INVALID_VERSION/ARG/SIZE; los de la salida se propagan tal cual.
+esp_err_t ota_delta_procesar(ota_delta_t *d, const uint8_t *datos, size_t len);
+
+// Tras el último trozo: vacía la salida. ESP_ERR_INVALID_SIZE si faltó el registro 'E'.
+esp_err_t ota_delta_terminar(ota_delta_t *d);
+
+void ota_delta_liberar(ota_delta_t *d);
+
+#endif // OTA_DELTA_H
@@ -0,0 +1,443 @@
+#include "ota_update.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_app_desc.h"
+#include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "mbedtls/sha256.h"
+#include "rom/miniz.h"
+#include "ota_delta.h"
+#include "energia.h"
+
+static const char *TAG = "OTA";
+
+typedef struct {
+    uint8_t *datos;
+    size_t len;              // 0 = fin de la imagen
+} ota_bloque_t;
+
+typedef struct {
+    httpd_req_t *req;                    // Copia asíncrona de la petición
+    const esp_partition_t *particion;
+    esp_ota_handle_t handle;
+    QueueHandle_t libres;                // Búferes listos para recibir
+    QueueHandle_t llenos;                // Búferes listos para escribir en flash
+    TaskHandle_t receptor;
+    mbedtls_sha256_context sha;
+    uint8_t sha_esperado[32];
+    bool con_sha;
+    volatile esp_err_t err_flash;        // Primer error de esp_ota_write
+    uint8_t *bufs[OTA_NUM_BUFS];
+    size_t escritos;                     // Bytes de imagen escritos en flash
+    // Solo con Content-Encoding: deflate (tinfl de la ROM)
+    tinfl_decompressor *inflador;
+    uint8_t *ventana;                    // Salida circular = diccionario de OTA_VENTANA bytes
+    size_t ventana_pos;
+    bool inflado_fin;                    // Se llegó al final del flujo zlib (Adler-32 correcto)
+    bool err_deflate;                    // err_flash viene del flujo comprimido
+    bool err_escritura;                  // err_flash viene de esp_ota_write
+    // Solo con X-OTA-Base-SHA256: parche contra la imagen en ejecución
+    ota_delta_t *delta;
+    uint8_t sha_base[32];
+} ota_sesion_t;
+
+static atomic_bool en_curso = false;
+
+// SHA-256 de la imagen en ejecución (el que añade esptool al .bin); no cambia hasta reiniciar
+static uint8_t sha_ejecucion[32];
+static bool sha_ejecucion_ok;
+
+static esp_err_t escribir(ota_sesion_t *s, const uint8_t *datos, size_t len) {
+    mbedtls_sha256_update(&s->sha, datos, len);
+    s->escritos += len;
+    esp_err_t err = esp_ota_write(s->handle, datos, len);
+    s->err_escritura = err != ESP_OK;
+    return err;
+}
+
+static esp_err_t escribir_delta(void *ctx, const uint8_t *datos, size_t len) {
+    return escribir(ctx, datos, len);
+}
+
+// Datos ya descomprimidos: imagen tal cual o parche delta
+static esp_err_t consumir(ota_sesion_t *s, const uint8_t *datos, size_t len) {
+    return s->delta != NULL ? ota_delta_procesar(s->delta, datos, len) : escribir(s, datos, len);
+}
+
+// Descomprime un bloque recibido. La salida va a la ventana circular y se escribe
+// cada vez que se llena; tinfl usa lo ya escrito en ella como diccionario.
+static esp_err_t inflar(ota_sesion_t *s, const uint8_t *in, size_t len) {
+    if (s->inflado_fin) {
+        s->err_deflate = len > 0;  // Datos tras el final del flujo
+        return len > 0 ? ESP_ERR_INVALID_SIZE : ESP_OK;
+    }
+    while (true) {
+        size_t n_in = len;
+        size_t n_out = OTA_VENTANA - s->ventana_pos;
+        tinfl_status st = tinfl_decompress(s->inflador, in, &n_in, s->ventana, s->ventana + s->ventana_pos, &n_out,
+                                           TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_COMPUTE_ADLER32 |
+                                           TINFL_FLAG_HAS_MORE_INPUT);
+        in += n_in;
+        len -= n_in;
+        s->ventana_pos += n_out;
+        if (s->ventana_pos == OTA_VENTANA || (st == TINFL_STATUS_DONE && s->ventana_pos > 0)) {
+            esp_err_t err = consumir(s, s->ventana, s->ventana_pos);
+            s->ventana_pos = 0;
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+        if (st == TINFL_STATUS_DONE) {
+            s->inflado_fin = true;
+            s->err_deflate = len > 0;
+            return len > 0 ? ESP_ERR_INVALID_SIZE : ESP_OK;
+        }
+        if (st < 0) {
+            ESP_LOGE(TAG, "Flujo deflate corrupto (tinfl %d)", (int)st);
+            s->err_deflate = true;
+            return ESP_ERR_INVALID_CRC;
+        }
+        if (st == TINFL_STATUS_NEEDS_MORE_INPUT && len == 0) {
+            return ESP_OK;
+        }
+    }
+}
+
+// Tarea escritora: SHA-256 y esp_ota_write de cada bloque mientras el receptor llena el otro
+static void task_ota_escritor(void *arg) {
+    ota_sesion_t *s = arg;
+    ota_bloque_t b;
+    bool primero = true;
+    while (xQueueReceive(s->llenos, &b, portMAX_DELAY) == pdTRUE && b.len > 0) {
+        if (s->err_flash == ESP_OK && s->inflador == NULL) {
+            s->err_flash = consumir(s, b.datos, b.len);
+        } else if (s->err_flash == ESP_OK) {
+            // CINFO de la cabecera zlib: una ventana mayor que la nuestra no se puede descomprimir
+            if (primero && (b.datos[0] >> 4) + 8 > OTA_VENTANA_BITS) {
+                ESP_LOGE(TAG, "Ventana deflate de %d bytes (max %d)", 1 << ((b.datos[0] >> 4) + 8), OTA_VENTANA);
+                s->err_flash = ESP_ERR_NOT_SUPPORTED;
+                s->err_deflate = true;
+            } else {
+                s->err_flash = inflar(s, b.datos, b.len);
+            }
+        }
+        primero = false;
+        xQueueSend(s->libres, &b, portMAX_DELAY);
+    }
+    xTaskNotifyGive(s->receptor);
+    vTaskDelete(NULL);
+}
+
+static int hex_a_bytes(const char *hex, uint8_t *out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        unsigned v;
+        if (sscanf(hex + 2 * i, "%2x", &v) != 1) {
+            return -1;
+        }
+        out[i] = (uint8_t)v;
+    }
+    return hex[2 * n] == '\0' ? 0 : -1;
+}
+
+static const char *fallo_escritor(const ota_sesion_t *s) {
+    if (s->err_escritura) {
+        return "OTA write failed";
+    }
+    return s->err_deflate ? "Invalid deflate stream" : "Invalid delta patch";
+}
+
+static void sesion_liberar(ota_sesion_t *s) {
+    for (int i = 0; i < OTA_NUM_BUFS; i++) {
+        heap_caps_free(s->bufs[i]);
+    }
+    free(s->inflador);
+    heap_caps_free(s->ventana);
+    ota_delta_liberar(s->delta);
+    if (s->libres) vQueueDelete(s->libres);
+    if (s->llenos) vQueueDelete(s->llenos);
+    mbedtls_sha256_free(&s->sha);
+    free(s);
+}
+
+// Recibe del socket en bloques de OTA_BUF_SIZE; devuelve NULL o el motivo del fallo
+static const char *recibir(ota_sesion_t *s, size_t *total) {
+    httpd_req_t *req = s->req;
+    size_t restante = req->content_len;
+    int timeouts = 0;
+    while (restante > 0) {
+        ota_bloque_t b;
+        xQueueReceive(s->libres, &b, portMAX_DELAY);
+        if (s->err_flash != ESP_OK) {
+            return fallo_escritor(s);
+        }
+        b.len = 0;
+        while (b.len < OTA_BUF_SIZE && restante > 0) {
+            size_t pedir = OTA_BUF_SIZE - b.len < restante ? OTA_BUF_SIZE - b.len : restante;
+            int r = httpd_req_recv(req, (char *)b.datos + b.len, pedir);
+            if (r == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < OTA_MAX_TIMEOUTS) {
+                continue;
+            }
+            if (r <= 0) {
+                xQueueSend(s->libres, &b, 0);
+                return "Upload failed";
+            }
+            timeouts = 0;
+            b.len += r;
+            restante -= r;
+            *total += r;
+        }
+        xQueueSend(s->llenos, &b, portMAX_DELAY);
+    }
+    return NULL;
+}
+
+static void task_ota_receptor(void *arg) {
+    ota_sesion_t *s = arg;
+    httpd_req_t *req = s->req;
+    int64_t t0 = esp_timer_get_time();
+    size_t total = 0;
+    const char *fallo = NULL;
+    energia_bloquear();   // Hasta terminar (o reiniciar)
+
+    // Un parche solo vale para la imagen exacta contra la que se generó
+    if (s->delta != NULL && (!sha_ejecucion_ok || memcmp(s->sha_base, sha_ejecucion, sizeof(sha_ejecucion)) != 0)) {
+        ESP_LOGE(TAG, "Parche delta para otra imagen base");
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "Base del parche distinta de la imagen en ejecucion");
+        goto fin;
+    }
+
+    // Borrado sector a sector a medida que se escribe: sin pausa inicial de varios segundos
+    esp_err_t err = esp_ota_begin(s->particion, OTA_WITH_SEQUENTIAL_WRITES, &s->handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_begin: %s", esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA begin failed");
+        goto fin;
+    }
+    mbedtls_sha256_starts(&s->sha, 0);
+
+    // Escritor en la APP CPU; WiFi y lwIP quedan en la PRO CPU con el receptor
+    if (xTaskCreatePinnedToCore(task_ota_escritor, "ota_flash", 4096, s, 5, NULL, 1) != pdPASS) {
+        esp_ota_abort(s->handle);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA sin memoria");
+        goto fin;
+    }
+
+    fallo = recibir(s, &total);
+    ota_bloque_t fin_imagen = { NULL, 0 };
+    xQueueSend(s->llenos, &fin_imagen, portMAX_DELAY);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);  // El escritor ha vaciado la cola y terminado
+    if (fallo == NULL && s->err_flash != ESP_OK) {
+        fallo = fallo_escritor(s);
+    }
+    if (fallo == NULL && s->inflador != NULL && !s->inflado_fin) {
+        fallo = "Truncated deflate stream";
+    }
+    if (fallo == NULL && s->delta != NULL && ota_delta_terminar(s->delta) != ESP_OK) {
+        fallo = fallo_escritor(s);
+    }
+
+    uint8_t sha[32];
+    mbedtls_sha256_finish(&s->sha, sha);
+    if (fallo == NULL && s->con_sha && memcmp(sha, s->sha_esperado, sizeof(sha)) != 0) {
+        fallo = "SHA-256 mismatch";
+    }
+    if (fallo != NULL) {
+        ESP_LOGE(TAG, "OTA abortada tras %u bytes: %s", (unsigned)total, fallo);
+        esp_ota_abort(s->handle);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, fallo);
+        goto fin;
+    }
+
+    // esp_ota_end valida además la cabecera y el hash propio de la imagen
+    err = esp_ota_end(s->handle);
+    if (err == ESP_OK) {
+        err = esp_ota_set_boot_partition(s->particion);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Imagen rechazada: %s", esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Invalid image");
+        goto fin;
+    }
+
+    // Ratio en centésimas: imagen escrita / bytes recibidos
+    int64_t dt_ms = (esp_timer_get_time() - t0) / 1000;
+    unsigned ratio = total > 0 ? (unsigned)((uint64_t)s->escritos * 100 / total) : 0;
+    char resp[192];
+    snprintf(resp, sizeof(resp),
+             "Update OK! %u bytes recibidos, %u escritos (x%u.%02u) en %lld ms "
+             "(red %u KB/s, imagen %u KB/s), SHA-256 %s. Reiniciando...",
+             (unsigned)total, (unsigned)s->escritos, ratio / 100, ratio % 100, (long long)dt_ms,
+             (unsigned)(dt_ms > 0 ? total / dt_ms : 0), (unsigned)(dt_ms > 0 ? s->escritos / dt_ms : 0),
+             s->con_sha ? "verificado" : "no enviado");
+    ESP_LOGI(TAG, "%s", resp);
+    httpd_resp_sendstr(req, resp);
+    httpd_req_async_handler_complete(req);
+    sesion_liberar(s);
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    esp_restart();
+
+fin:
+    httpd_req_async_handler_complete(req);
+    sesion_liberar(s);
+    atomic_store(&en_curso, false);
+    energia_liberar();
+    vTaskDelete(NULL);
+}
+
+static esp_err_t ota_handler(httpd_req_t *req) {
+    if (atomic_exchange(&en_curso, true)) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_sendstr(req, "OTA ya en curso");
+        return ESP_OK;
+    }
+
+    const esp_partition_t *particion = esp_ota_get_next_update_partition(NULL);
+    ota_sesion_t *s = calloc(1, sizeof(*s));
+    if (particion == NULL || s == NULL) {
+        free(s);
+        atomic_store(&en_curso, false);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "No OTA partition");
+        return ESP_FAIL;
+    }
+    s->particion = particion;
+    mbedtls_sha256_init(&s->sha);
+
+    char hex[65];
+    if (httpd_req_get_hdr_value_str(req, "X-OTA-SHA256", hex, sizeof(hex)) == ESP_OK) {
+        if (hex_a_bytes(hex, s->sha_esperado, sizeof(s->sha_esperado)) != 0) {
+            sesion_liberar(s);
+            atomic_store(&en_curso, false);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "X-OTA-SHA256 invalido");
+            return ESP_FAIL;
+        }
+        s->con_sha = true;
+    }
+
+    // Parche delta: exige el SHA-256 del resultado, que es lo único que lo valida de punta a punta
+    if (httpd_req_get_hdr_value_str(req, "X-OTA-Base-SHA256", hex, sizeof(hex)) == ESP_OK) {
+        if (!s->con_sha || hex_a_bytes(hex, s->sha_base, sizeof(s->sha_base)) != 0) {
+            sesion_liberar(s);
+            atomic_store(&en_curso, false);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Delta requiere X-OTA-Base-SHA256 y X-OTA-SHA256 validos");
+            return ESP_FAIL;
+        }
+        s->delta = ota_delta_crear(esp_ota_get_running_partition(), escribir_delta, s);
+        if (s->delta == NULL) {
+            sesion_liberar(s);
+            atomic_store(&en_curso, false);
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA sin memoria");
+            return ESP_FAIL;
+        }
+    }
+
+    // Imagen comprimida: el inflador (~11 KB) y la ventana solo se reservan si hacen falta
+    char codificacion[16];
+    bool deflate = false;
+    if (httpd_req_get_hdr_value_str(req, "Content-Encoding", codificacion, sizeof(codificacion)) == ESP_OK) {
+        if (strcasecmp(codificacion, "deflate") != 0) {
+            sesion_liberar(s);
+            atomic_store(&en_curso, false);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Content-Encoding no soportado");
+            return ESP_FAIL;
+        }
+        deflate = true;
+    }
+
+    // Búferes en RAM interna (el driver de flash no escribe desde PSRAM sin copia), alineados a 4
+    s->libres = xQueueCreate(OTA_NUM_BUFS, sizeof(ota_bloque_t));
+    s->llenos = xQueueCreate(OTA_NUM_BUFS + 1, sizeof(ota_bloque_t));
+    bool ok = s->libres && s->llenos;
+    for (int i = 0; i < OTA_NUM_BUFS && ok; i++) {
+        s->bufs[i] = heap_caps_malloc(OTA_BUF_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        ota_bloque_t b = { s->bufs[i], 0 };
+        ok = s->bufs[i] != NULL && xQueueSend(s->libres, &b, 0) == pdTRUE;
+    }
+    if (ok && deflate) {
+        s->inflador = malloc(sizeof(tinfl_decompressor));
+        s->ventana = heap_caps_malloc(OTA_VENTANA, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        ok = s->inflador != NULL && s->ventana != NULL;
+        if (ok) {
+            tinfl_init(s->inflador);
+        }
+    }
+
+    // Sacar la petición del hilo de httpd: el servidor sigue atendiendo al resto
+    if (ok) {
+        ok = httpd_req_async_handler_begin(req, &s->req) == ESP_OK;
+    }
+    if (ok && xTaskCreate(task_ota_receptor, "ota_rx", 4096, s, 5, &s->receptor) != pdPASS) {
+        httpd_req_async_handler_complete(s->req);
+        ok = false;
+    }
+    if (!ok) {
+        sesion_liberar(s);
+        atomic_store(&en_curso, false);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA sin memoria");
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Iniciando OTA: %u bytes%s%s hacia %s", (unsigned)req->content_len,
+             deflate ? " comprimidos" : "", s->delta ? " de parche delta" : "", particion->label);
+    return ESP_OK;
+}
+
+// GET /update: qué imagen está en ejecución, para generar parches contra ella
+static esp_err_t ota_info_handler(httpd_req_t *req) {
+    char hex[65] = "";
+    for (int i = 0; sha_ejecucion_ok && i < 32; i++) {
+        snprintf(hex + 2 * i, 3, "%02x", sha_ejecucion[i]);
+    }
+    char resp[192];
+    int n = snprintf(resp, sizeof(resp), "{\"particion\":\"%s\",\"version\":\"%s\",\"sha256\":\"%s\"}",
+                     esp_ota_get_running_partition()->label, esp_app_get_description()->version, hex);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, resp, n);
+}
+
+esp_err_t ota_update_registrar(httpd_handle_t server) {
+    // Una sola vez por arranque: verifica la imagen entera en flash
+    sha_ejecucion_ok = esp_partition_get_sha256(esp_ota_get_running_partition(), sha_ejecucion) == ESP_OK;
+
+    httpd_uri_t ota = {
+        .uri = "/update",
+        .method = HTTP_POST,
+        .handler = ota_handler,
+    };
+    httpd_uri_t info = {
+        .uri = "/update",
+        .method = HTTP_GET,
+        .handler = ota_info_handler,
+    };
+    esp_err_t err = energia_registrar_uri(server, &ota);
+    return err == ESP_OK ? energia_registrar_uri(server, &info) : err;
+}
+
+bool ota_update_pendiente(void) {
+    esp_ota_img_states_t estado;
+    return esp_ota_get_state_partition(esp_ota_get_running_partition(), &estado) == ESP_OK &&
+           estado == ESP_OTA_IMG_PENDING_VERIFY;
+}
+
+void ota_update_confirmar(void) {
+    if (ota_update_pendiente()) {
+        ESP_LOGI(TAG, "Imagen nueva operativa: se confirma y se cancela el rollback");
+        esp_ota_mark_app_valid_cancel_rollback();
+    }
+}
+
+void ota_update_revertir(void) {
+    if (ota_update_pendiente()) {
+        ESP_LOGE(TAG, "Imagen nueva sin /update: volviendo a la anterior");
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+    }
+}
@@ -0,0 +1,36 @@
+// Actualización OTA por HTTP (POST /update) en segundo plano.
+// La petición sale del hilo de httpd (el resto de endpoints siguen atendiéndose) y
+// se procesa en dos tareas: una recibe del socket y otra escribe en flash, con
+// doble búfer entre ambas. El SHA-256 se calcula al vuelo y, si el cliente envía
+// la cabecera X-OTA-SHA256, se comprueba antes de cambiar la partición de arranque.
+// Con "Content-Encoding: deflate" la imagen llega comprimida (zlib, ventana de 4 KB)
+// y se descomprime al vuelo; sin esa cabecera se acepta la imagen tal cual.
+// Con X-OTA-Base-SHA256 el cuerpo es un parche delta (ota_delta.h) contra la imagen en
+// ejecución, cuyo SHA-256 publica GET /update.
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#define OTA_BUF_SIZE     4096   // Un sector de flash por bloque
+#define OTA_NUM_BUFS     2
+#define OTA_MAX_TIMEOUTS 5      // Esperas de recv seguidas antes de abortar
+#define OTA_VENTANA_BITS 12     // Ventana deflate máxima aceptada (4 KB, zlib wbits=12)
+#define OTA_VENTANA      (1 << OTA_VENTANA_BITS)
+
+// Registrar POST /update y GET /update
+esp_err_t ota_update_registrar(httpd_handle_t server);
+
+// true si esta imagen arrancó tras una OTA y aún no se ha confirmado
+bool ota_update_pendiente(void);
+
+// Imagen nueva operativa (autocomprobación superada, ver main.c): cancelar el rollback
+void ota_update_confirmar(void);
+
+// La imagen nueva no se podría volver a actualizar por OTA: volver a la anterior y reiniciar.
+// No hace nada si la imagen ya estaba confirmada.
+void ota_update_revertir(void);
+
+#endif // OTA_UPDATE_H
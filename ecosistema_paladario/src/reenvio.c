@@ -0,0 +1,150 @@
+#include "reenvio.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "historia.h"
+
+static const char *TAG = "REENVIO";
+
+#define LOTE_LLENO ESP_ERR_INVALID_SIZE   // El callback para el recorrido con esto
+
+// Del manejador de eventos MQTT al publicador
+static _Atomic int64_t corte_us = 0;
+static _Atomic bool hay_corte = true;     // El arranque cuenta como corte
+
+// Solo el publicador
+static uint32_t desde = 0;       // Primera hora Unix por reenviar (0 = nada pendiente)
+static uint32_t fin = 0;         // Última (la de la reconexión; 0 = aún sin fijar)
+static uint32_t guardado = 0;    // Lo que hay en NVS
+static uint32_t lote_hasta = 0;  // Hora de la última muestra del lote en curso
+
+typedef struct {
+    char *buf;
+    size_t len;
+    int n;
+    int muestras;
+} lote_t;
+
+static void guardar(uint32_t t) {
+    if (t == guardado) {
+        return;
+    }
+    nvs_handle_t h;
+    if (nvs_open("reenvio", NVS_READWRITE, &h) != ESP_OK) {
+        return;
+    }
+    if (t) {
+        nvs_set_u32(h, "desde", t);
+    } else {
+        nvs_erase_key(h, "desde");
+    }
+    nvs_commit(h);
+    nvs_close(h);
+    guardado = t;
+}
+
+void reenvio_init(void) {
+    nvs_handle_t h;
+    if (nvs_open("reenvio", NVS_READONLY, &h) != ESP_OK) {
+        return;
+    }
+    if (nvs_get_u32(h, "desde", &desde) == ESP_OK) {
+        guardado = desde;
+        ESP_LOGI(TAG, "Corte pendiente desde %lu", (unsigned long)desde);
+    }
+    nvs_close(h);
+}
+
+void reenvio_corte(void) {
+    corte_us = esp_timer_get_time();
+    hay_corte = true;
+}
+
+// Pasar el corte a hora Unix (hace falta SNTP). Se conserva el más antiguo: si ya había
+// algo pendiente, se sigue desde donde iba.
+static bool atender_corte(void) {
+    if (!hay_corte) {
+        return true;
+    }
+    time_t ahora = time(NULL);
+    if (ahora < HISTORIA_T_MIN) {
+        return false;
+    }
+    hay_corte = false;
+    if (desde == 0) {
+        desde = (uint32_t)(ahora - (esp_timer_get_time() - corte_us) / 1000000);
+    }
+    fin = 0;
+    guardar(desde);
+    return true;
+}
+
+bool reenvio_pendiente(void) {
+    atender_corte();
+    return desde != 0 || hay_corte;
+}
+
+static void terminar(void) {
+    ESP_LOGI(TAG, "Reenvío completado hasta %lu", (unsigned long)fin);
+    desde = fin = 0;
+    guardar(0);
+}
+
+static esp_err_t agregar(const historia_registro_t *r, void *arg) {
+    lote_t *l = arg;
+    if (r->tipo != HISTORIA_MUESTRA) {
+        return ESP_OK;
+    }
+    if (l->muestras == REENVIO_LOTE) {
+        return LOTE_LLENO;
+    }
+    int n = snprintf(l->buf + l->n, l->len - l->n, "%s[%lu,%.1f,%.1f,%u]", l->muestras ? "," : "",
+                     (unsigned long)r->t, r->temperatura / 10.0f, r->humedad / 10.0f, r->actuadores);
+    if (n < 0 || (size_t)(l->n + n) >= l->len - 3) {
+        return LOTE_LLENO;
+    }
+    l->n += n;
+    l->muestras++;
+    lote_hasta = r->t;
+    return ESP_OK;
+}
+
+int reenvio_lote(char *buf, size_t len) {
+    if (!atender_corte() || desde == 0) {
+        return 0;
+    }
+    if (fin == 0) {
+        fin = (uint32_t)time(NULL);   // Lo posterior ya se publica en vivo
+        ESP_LOGI(TAG, "Reenviando las muestras de %lu a %lu", (unsigned long)desde, (unsigned long)fin);
+    }
+    void *pagina = malloc(HISTORIA_PAGINA);
+    if (pagina == NULL) {
+        return 0;
+    }
+    lote_t l = { .buf = buf, .len = len };
+    l.n = snprintf(buf, len, "{\"muestras\":[");
+    esp_err_t err = historia_recorrer(desde, fin, pagina, agregar, &l);
+    free(pagina);
+    if (err == ESP_ERR_NOT_FOUND) {
+        ESP_LOGW(TAG, "Sin histórico en flash: no se puede reenviar");
+        terminar();
+        return 0;
+    }
+    if (l.muestras == 0) {
+        terminar();
+        return 0;
+    }
+    l.n += snprintf(buf + l.n, len - l.n, "]}");
+    return l.n;
+}
+
+void reenvio_confirmar(void) {
+    desde = lote_hasta + 1;
+    if (desde > fin) {
+        terminar();
+    }
+}
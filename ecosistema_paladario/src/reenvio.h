@@ -0,0 +1,51 @@
+// Reenvío de la telemetría perdida durante un corte de MQTT (WiFi o broker caídos).
+// Las muestras ya están en el histórico de la flash (historia.h) con su hora Unix, así
+// que no se guardan otra vez: se apunta desde cuándo falta (en NVS, por si se reinicia
+// durante el corte) y al reconectar se publican en lotes, con su hora, en
+// MQTT_BASE_TOPIC/telemetria/replay:
+//   {"muestras":[[t,temperatura,humedad,actuadores],...]}
+// El publicador manda como mucho un lote por REENVIO_INTERVALO_MS y solo con la cola de
+// salida de MQTT casi vacía, para no retrasar el estado en vivo. Un arranque cuenta como
+// corte (hasta conectar no se publica nada). Si se corta a medias puede repetir
+// muestras: se identifican por t.
+#ifndef REENVIO_H
+#define REENVIO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "wifi_config.h"
+
+// Valores por defecto; se pueden redefinir en wifi_config.h
+#ifndef REENVIO_LOTE
+#define REENVIO_LOTE 40               // Muestras por mensaje (~1.2 KB)
+#endif
+#ifndef REENVIO_INTERVALO_MS
+#define REENVIO_INTERVALO_MS 1000     // Entre lotes: un día de corte se reenvía en ~4 min
+#endif
+#ifndef REENVIO_OUTBOX_MAX
+#define REENVIO_OUTBOX_MAX 4096       // Bytes pendientes en MQTT por encima de los cuales se espera
+#endif
+#ifndef MQTT_OUTBOX_LIMITE
+#define MQTT_OUTBOX_LIMITE 16384      // Tope de la cola de salida de esp-mqtt (QoS 1 sin confirmar)
+#endif
+
+#define REENVIO_JSON_MAX (REENVIO_LOTE * 32 + 32)
+
+// Recuperar de NVS un corte pendiente de antes de reiniciar
+void reenvio_init(void);
+
+// MQTT desconectado (desde el manejador de eventos; no bloquea)
+void reenvio_corte(void);
+
+// Hay muestras por reenviar (o un corte cuya hora aún no se conoce). Lo llama el
+// publicador en cada vuelta, también sin conexión: así el corte llega a NVS enseguida.
+bool reenvio_pendiente(void);
+
+// Siguiente lote en JSON; devuelve la longitud o 0 si no hay nada que enviar todavía.
+// Solo desde el publicador, con MQTT conectado.
+int reenvio_lote(char *buf, size_t len);
+
+// El último lote se ha entregado a MQTT: el siguiente empieza después
+void reenvio_confirmar(void);
+
+#endif // REENVIO_H
@@ -0,0 +1,529 @@
+#include "registro.h"
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_memory_utils.h"
+#include "energia.h"
+#include "tareas.h"
+
+static const char *TAG = "REGISTRO";
+
+#define LINEA        256              // Línea formateada más larga
+#define REGISTRO_MAX 192              // Registro más largo en el anillo, cabecera incluida
+#define EN_FLASH     0xFF             // Marca de %s guardado como puntero a la flash
+
+_Static_assert(REGISTRO_CADENA_MAX < EN_FLASH, "REGISTRO_CADENA_MAX debe ser menor que 255");
+
+typedef struct {
+    uint16_t longitud;       // Bytes del registro, cabecera incluida
+    uint8_t texto;           // 1 = línea ya formateada; 0 = argumentos de formato
+    uint8_t reservado;
+    const char *formato;
+} cabecera_t;
+
+// Qué se guarda de cada conversión de printf
+typedef enum {
+    ARG_NINGUNO,             // %%
+    ARG_ENTERO,              // d i u x X o c (también h y hh, que llegan como int)
+    ARG_LARGO,               // l
+    ARG_LARGO_LARGO,         // ll j
+    ARG_TAMANO,              // z t
+    ARG_REAL,                // f e g a
+    ARG_PUNTERO,             // p
+    ARG_CADENA,              // s
+    ARG_OTRO,                // n, L, %ls...: no se difiere
+} arg_t;
+
+typedef struct {
+    const char *inicio;      // El '%'
+    const char *fin;         // Tras la letra de conversión
+    uint8_t asteriscos;      // Ancho o precisión '*': un int cada uno antes del valor
+    bool precision_asterisco;
+    int precision;           // Precisión fija (-1 = ninguna)
+    arg_t tipo;
+} conversion_t;
+
+static uint8_t anillo[REGISTRO_BYTES];
+static uint32_t escrito = 0;              // Bytes totales (el índice es % REGISTRO_BYTES)
+static uint32_t leido = 0;
+static uint32_t perdidos = 0;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t tarea = NULL;
+static vprintf_like_t uart = vprintf;     // Salida original de ESP-IDF
+
+typedef struct {
+    char etiqueta[16];
+    esp_log_level_t nivel;
+} nivel_t;
+static nivel_t niveles[REGISTRO_ETIQUETAS];
+static int num_niveles = 0;
+static portMUX_TYPE niveles_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Índice = esp_log_level_t
+static const char *const nombres_nivel[] = { "none", "error", "warn", "info", "debug", "verbose" };
+#define NUM_NIVELES (sizeof(nombres_nivel) / sizeof(nombres_nivel[0]))
+
+// Analizar la conversión que empieza en p (un '%')
+static void conversion(const char *p, conversion_t *c) {
+    c->inicio = p++;
+    c->asteriscos = 0;
+    c->precision_asterisco = false;
+    c->precision = -1;
+    while (*p && strchr("-+ #0'", *p)) {
+        p++;
+    }
+    if (*p == '*') {
+        c->asteriscos++;
+        p++;
+    } else {
+        while (isdigit((unsigned char)*p)) {
+            p++;
+        }
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            c->asteriscos++;
+            c->precision_asterisco = true;
+            p++;
+        } else {
+            c->precision = 0;
+            while (isdigit((unsigned char)*p)) {
+                c->precision = c->precision * 10 + (*p++ - '0');
+            }
+        }
+    }
+    int l = 0;
+    bool tamano = false, largo_doble = false;
+    for (; *p && strchr("hlzjtL", *p); p++) {
+        if (*p == 'l') {
+            l++;
+        } else if (*p == 'j') {
+            l = 2;
+        } else if (*p == 'z' || *p == 't') {
+            tamano = true;
+        } else if (*p == 'L') {
+            largo_doble = true;
+        }
+    }
+    switch (*p) {
+        case '%':
+            c->tipo = ARG_NINGUNO;
+            break;
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            c->tipo = l >= 2 ? ARG_LARGO_LARGO : l == 1 ? ARG_LARGO : tamano ? ARG_TAMANO : ARG_ENTERO;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            c->tipo = largo_doble ? ARG_OTRO : ARG_REAL;
+            break;
+        case 'p':
+            c->tipo = ARG_PUNTERO;
+            break;
+        case 's':
+            c->tipo = l ? ARG_OTRO : ARG_CADENA;
+            break;
+        default:
+            c->tipo = ARG_OTRO;
+            break;
+    }
+    c->fin = *p ? p + 1 : p;
+}
+
+#define GUARDAR(tipo_c, valor) do { \
+        tipo_c v_ = (valor); \
+        if (n + sizeof(v_) > REGISTRO_MAX) return 0; \
+        memcpy(reg + n, &v_, sizeof(v_)); \
+        n += sizeof(v_); \
+    } while (0)
+
+// Argumentos de fmt tras la cabecera; devuelve la longitud del registro o 0 si hay que
+// formatearlo ya (conversión desconocida o no cabe)
+static size_t diferir(uint8_t *reg, const char *fmt, va_list ap) {
+    size_t n = sizeof(cabecera_t);
+    for (const char *p = fmt; *p;) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        conversion_t c;
+        conversion(p, &c);
+        p = c.fin;
+        int asterisco = -1;
+        for (int i = 0; i < c.asteriscos; i++) {
+            asterisco = va_arg(ap, int);
+            GUARDAR(int, asterisco);
+        }
+        switch (c.tipo) {
+            case ARG_NINGUNO:
+                break;
+            case ARG_ENTERO:
+                GUARDAR(int, va_arg(ap, int));
+                break;
+            case ARG_LARGO:
+                GUARDAR(long, va_arg(ap, long));
+                break;
+            case ARG_LARGO_LARGO:
+                GUARDAR(long long, va_arg(ap, long long));
+                break;
+            case ARG_TAMANO:
+                GUARDAR(size_t, va_arg(ap, size_t));
+                break;
+            case ARG_REAL:
+                GUARDAR(double, va_arg(ap, double));
+                break;
+            case ARG_PUNTERO:
+                GUARDAR(void *, va_arg(ap, void *));
+                break;
+            case ARG_CADENA: {
+                const char *s = va_arg(ap, const char *);
+                if (s != NULL && esp_ptr_in_drom(s)) {
+                    GUARDAR(uint8_t, EN_FLASH);
+                    GUARDAR(const char *, s);
+                    break;
+                }
+                if (s == NULL) {
+                    s = "(null)";
+                }
+                int precision = c.precision_asterisco ? asterisco : c.precision;
+                size_t max = precision >= 0 && precision < REGISTRO_CADENA_MAX ? precision : REGISTRO_CADENA_MAX;
+                size_t len = strnlen(s, max);
+                if (n + len + 2 > REGISTRO_MAX) {
+                    return 0;
+                }
+                reg[n++] = len;
+                memcpy(reg + n, s, len);
+                n += len;
+                reg[n++] = '\0';
+                break;
+            }
+            default:
+                return 0;
+        }
+    }
+    return n;
+}
+
+#define LEER(v) do { memcpy(&(v), a, sizeof(v)); a += sizeof(v); } while (0)
+
+// Formatear un registro diferido, conversión a conversión con los valores guardados
+static int formatear(char *linea, size_t len, const char *fmt, const uint8_t *a) {
+    size_t n = 0;
+    for (const char *p = fmt; *p && n < len - 1;) {
+        if (*p != '%') {
+            linea[n++] = *p++;
+            continue;
+        }
+        conversion_t c;
+        conversion(p, &c);
+        p = c.fin;
+        // La especificación con los '*' ya sustituidos por su valor
+        char espec[32];
+        size_t m = 0;
+        for (const char *q = c.inicio; q < c.fin && m < sizeof(espec) - 12; q++) {
+            if (*q == '*') {
+                int v;
+                LEER(v);
+                m += snprintf(espec + m, sizeof(espec) - m, "%d", v);
+            } else {
+                espec[m++] = *q;
+            }
+        }
+        espec[m] = '\0';
+
+        char *dst = linea + n;
+        size_t resto = len - n;
+        int k = 0;
+        switch (c.tipo) {
+            case ARG_NINGUNO:
+                k = snprintf(dst, resto, "%%");
+                break;
+            case ARG_ENTERO: {
+                int v;
+                LEER(v);
+                k = snprintf(dst, resto, espec, v);
+                break;
+            }
+            case ARG_LARGO: {
+                long v;
+                LEER(v);
+                k = snprintf(dst, resto, espec, v);
+                break;
+            }
+            case ARG_LARGO_LARGO: {
+                long long v;
+                LEER(v);
+                k = snprintf(dst, resto, espec, v);
+                break;
+            }
+            case ARG_TAMANO: {
+                size_t v;
+                LEER(v);
+                k = snprintf(dst, resto, espec, v);
+                break;
+            }
+            case ARG_REAL: {
+                double v;
+                LEER(v);
+                k = snprintf(dst, resto, espec, v);
+                break;
+            }
+            case ARG_PUNTERO: {
+                void *v;
+                LEER(v);
+                k = snprintf(dst, resto, espec, v);
+                break;
+            }
+            case ARG_CADENA: {
+                const char *s;
+                uint8_t l = *a++;
+                if (l == EN_FLASH) {
+                    LEER(s);
+                } else {
+                    s = (const char *)a;
+                    a += l + 1;
+                }
+                k = snprintf(dst, resto, espec, s);
+                break;
+            }
+            default:
+                break;
+        }
+        if (k > 0) {
+            n += (size_t)k < resto ? (size_t)k : resto - 1;
+        }
+    }
+    linea[n] = '\0';
+    return n;
+}
+
+static void encolar(const uint8_t *reg, size_t n) {
+    portENTER_CRITICAL_SAFE(&lock);
+    bool cabe = REGISTRO_BYTES - (escrito - leido) >= n;
+    if (cabe) {
+        size_t i = escrito % REGISTRO_BYTES;
+        size_t primero = n < REGISTRO_BYTES - i ? n : REGISTRO_BYTES - i;
+        memcpy(&anillo[i], reg, primero);
+        memcpy(anillo, reg + primero, n - primero);
+        escrito += n;
+    } else {
+        perdidos++;
+    }
+    portEXIT_CRITICAL_SAFE(&lock);
+    if (cabe && tarea != NULL && !xPortInIsrContext()) {
+        xTaskNotifyGive(tarea);
+    }
+}
+
+static void copiar_de(uint32_t pos, void *dst, size_t n) {
+    size_t i = pos % REGISTRO_BYTES;
+    size_t primero = n < REGISTRO_BYTES - i ? n : REGISTRO_BYTES - i;
+    memcpy(dst, &anillo[i], primero);
+    memcpy((uint8_t *)dst + primero, anillo, n - primero);
+}
+
+// Siguiente registro del anillo a reg; false si está vacío
+static bool sacar(uint8_t *reg) {
+    bool hay;
+    portENTER_CRITICAL(&lock);
+    hay = escrito != leido;
+    if (hay) {
+        uint16_t n;
+        copiar_de(leido, &n, sizeof(n));
+        copiar_de(leido, reg, n);
+        leido += n;
+    }
+    portEXIT_CRITICAL(&lock);
+    return hay;
+}
+
+// Sustituto de vprintf para esp_log_set_vprintf: lo llama ESP_LOGx en la tarea que registra
+static int registro_vprintf(const char *fmt, va_list ap) {
+    uint8_t reg[REGISTRO_MAX] __attribute__((aligned(4)));
+    size_t n = 0;
+    if (esp_ptr_in_drom(fmt)) {
+        va_list copia;
+        va_copy(copia, ap);
+        n = diferir(reg, fmt, copia);
+        va_end(copia);
+    }
+    cabecera_t c = { .texto = n == 0, .formato = fmt };
+    if (c.texto) {
+        // Formato en RAM o que no se sabe diferir: como antes, pero sin esperar a la UART
+        size_t max = REGISTRO_MAX - sizeof(cabecera_t);
+        int k = vsnprintf((char *)reg + sizeof(cabecera_t), max, fmt, ap);
+        n = sizeof(cabecera_t) + (k < 0 ? 0 : (size_t)k < max ? (size_t)k : max - 1) + 1;
+    }
+    c.longitud = n;
+    memcpy(reg, &c, sizeof(c));
+    encolar(reg, n);
+    return n;
+}
+
+// Formato con la salida original de ESP-IDF (la UART)
+static void escribir(const char *formato, ...) {
+    va_list ap;
+    va_start(ap, formato);
+    uart(formato, ap);
+    va_end(ap);
+}
+
+static void task_registro(void *arg) {
+    static uint8_t reg[REGISTRO_MAX] __attribute__((aligned(4)));
+    static char linea[LINEA];
+    uint32_t avisados = 0;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (sacar(reg)) {
+            cabecera_t c;
+            memcpy(&c, reg, sizeof(c));
+            if (c.texto) {
+                escribir("%s", (const char *)reg + sizeof(c));
+            } else {
+                formatear(linea, sizeof(linea), c.formato, reg + sizeof(c));
+                escribir("%s", linea);
+            }
+        }
+        uint32_t p = perdidos;
+        if (p != avisados) {
+            escribir("W (%lu) %s: %lu registros perdidos (anillo lleno)\n",
+                     (unsigned long)esp_log_timestamp(), TAG, (unsigned long)(p - avisados));
+            avisados = p;
+        }
+    }
+}
+
+void registro_init(void) {
+#if REGISTRO_DIFERIDO
+    tarea = tarea_crear(TAREA_REGISTRO, task_registro, NULL);
+    if (tarea != NULL) {
+        uart = esp_log_set_vprintf(registro_vprintf);
+    }
+#endif
+}
+
+uint32_t registro_perdidos(void) {
+    return perdidos;
+}
+
+static int nivel_por_nombre(const char *nombre) {
+    for (size_t i = 0; i < NUM_NIVELES; i++) {
+        if (strcmp(nombre, nombres_nivel[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Índice de la etiqueta en la tabla (-1 si no está); con niveles_lock
+static int buscar(const char *etiqueta) {
+    for (int i = 0; i < num_niveles; i++) {
+        if (strcmp(niveles[i].etiqueta, etiqueta) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool registro_config_json(const char *json, size_t len) {
+    cJSON *raiz = cJSON_ParseWithLength(json, len);
+    bool ok = cJSON_IsObject(raiz) && cJSON_GetArraySize(raiz) > 0;
+    int nuevas = 0;
+    const cJSON *e;
+    portENTER_CRITICAL(&niveles_lock);
+    cJSON_ArrayForEach(e, raiz) {
+        if (!ok || !cJSON_IsString(e) || nivel_por_nombre(e->valuestring) < 0 ||
+            strlen(e->string) == 0 || strlen(e->string) >= sizeof(niveles[0].etiqueta)) {
+            ok = false;
+            break;
+        }
+        nuevas += buscar(e->string) < 0;
+    }
+    ok = ok && num_niveles + nuevas <= REGISTRO_ETIQUETAS;
+    portEXIT_CRITICAL(&niveles_lock);
+
+    if (ok) {
+        cJSON_ArrayForEach(e, raiz) {
+            esp_log_level_t nivel = nivel_por_nombre(e->valuestring);
+            esp_log_level_set(e->string, nivel);
+            portENTER_CRITICAL(&niveles_lock);
+            int i = buscar(e->string);
+            if (i < 0 && num_niveles < REGISTRO_ETIQUETAS) {
+                i = num_niveles++;
+                strcpy(niveles[i].etiqueta, e->string);
+            }
+            if (i >= 0) {
+                niveles[i].nivel = nivel;
+            }
+            portEXIT_CRITICAL(&niveles_lock);
+            ESP_LOGI(TAG, "Nivel de %s: %s", e->string, nombres_nivel[nivel]);
+        }
+    }
+    cJSON_Delete(raiz);
+    return ok;
+}
+
+int registro_json(char *buf, size_t len) {
+    portENTER_CRITICAL(&lock);
+    uint32_t pendientes = escrito - leido, p = perdidos;
+    portEXIT_CRITICAL(&lock);
+    int n = snprintf(buf, len, "{\"diferido\":%s,\"capacidad\":%d,\"pendientes\":%lu,\"perdidos\":%lu,\"niveles\":{",
+                     tarea != NULL ? "true" : "false", REGISTRO_BYTES, (unsigned long)pendientes, (unsigned long)p);
+    nivel_t copia[REGISTRO_ETIQUETAS];
+    portENTER_CRITICAL(&niveles_lock);
+    int num = num_niveles;
+    memcpy(copia, niveles, num * sizeof(nivel_t));
+    portEXIT_CRITICAL(&niveles_lock);
+    for (int i = 0; i < num && n < (int)len; i++) {
+        n += snprintf(buf + n, len - n, "%s\"%s\":\"%s\"", i ? "," : "", copia[i].etiqueta,
+                      nombres_nivel[copia[i].nivel]);
+    }
+    if (n < (int)len) {
+        n += snprintf(buf + n, len - n, "}}");
+    }
+    return n < (int)len ? n : (int)len - 1;
+}
+
+// GET /api/registro
+static esp_err_t registro_get_handler(httpd_req_t *req) {
+    char payload[640];
+    int n = registro_json(payload, sizeof(payload));
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_send(req, payload, n);
+}
+
+// POST /api/registro {"etiqueta":"nivel",...} -> responde con el estado nuevo
+static esp_err_t registro_post_handler(httpd_req_t *req) {
+    char content[256];
+    if (req->content_len >= sizeof(content)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Cuerpo demasiado largo");
+        return ESP_FAIL;
+    }
+    int ret = energia_recibir(req, content, sizeof(content));
+    if (ret <= 0 || !registro_config_json(content, ret)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            "Se espera {\"etiqueta\":\"none|error|warn|info|debug|verbose\",...}");
+        return ESP_FAIL;
+    }
+    return registro_get_handler(req);
+}
+
+esp_err_t registro_registrar(httpd_handle_t server) {
+    httpd_uri_t get = {
+        .uri = "/api/registro",
+        .method = HTTP_GET,
+        .handler = registro_get_handler,
+    };
+    httpd_uri_t post = {
+        .uri = "/api/registro",
+        .method = HTTP_POST,
+        .handler = registro_post_handler,
+    };
+    esp_err_t err = energia_registrar_uri(server, &get);
+    return err == ESP_OK ? energia_registrar_uri(server, &post) : err;
+}
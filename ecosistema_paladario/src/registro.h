@@ -0,0 +1,55 @@
+// Registro (ESP_LOGx) diferido: a 115200 baudios cada línea cuesta ~1 ms por cada 11
+// caracteres de UART, y la salida estándar espera a que se vacíe la FIFO. Con esto,
+// ESP_LOGx solo copia la cadena de formato (un puntero: está en la flash) y los
+// argumentos a un anillo en RAM; la tarea "registro", con la prioridad más baja, les da
+// formato y los escribe en la UART cuando no hay otra cosa que hacer.
+//
+// Los %s se copian (hasta REGISTRO_CADENA_MAX bytes) salvo que apunten a la flash, como
+// las etiquetas. Si un formato no está en la flash o no se sabe diferir, se formatea en el
+// momento como antes. Con el anillo lleno el registro se descarta y se cuenta (ni se
+// espera ni se bloquea): la tarea avisa de cuántos se han perdido y /metrics los suma.
+// Lo que quede en el anillo si el ESP32 se reinicia por un fallo no llega a salir.
+//
+// Nivel de cada etiqueta en marcha, por HTTP (POST /api/registro) o MQTT
+// (MQTT_BASE_TOPIC/registro/set): {"DHT22":"warn","*":"info"} con none, error, warn,
+// info, debug o verbose. No sube de CONFIG_LOG_MAXIMUM_LEVEL (info en sdkconfig).
+#ifndef REGISTRO_H
+#define REGISTRO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "wifi_config.h"
+
+// Valores por defecto; se pueden redefinir en wifi_config.h
+#ifndef REGISTRO_DIFERIDO
+#define REGISTRO_DIFERIDO 1           // 0 = escribir en la UART desde quien llama, como ESP-IDF
+#endif
+#ifndef REGISTRO_BYTES
+#define REGISTRO_BYTES 4096           // Anillo en RAM (una línea ocupa ~30-60 bytes)
+#endif
+#ifndef REGISTRO_CADENA_MAX
+#define REGISTRO_CADENA_MAX 64        // Bytes guardados de cada %s que no está en la flash
+#endif
+
+#define REGISTRO_ETIQUETAS 16         // Etiquetas con nivel propio
+
+// Desviar ESP_LOGx al anillo y crear la tarea que lo vacía (lo primero en app_main)
+void registro_init(void);
+
+// Registros descartados por falta de sitio desde el arranque
+uint32_t registro_perdidos(void);
+
+// Niveles por etiqueta: {"etiqueta":"nivel",...}; false si algo no es válido (no se
+// aplica nada)
+bool registro_config_json(const char *json, size_t len);
+
+// Niveles y estado del anillo en JSON; devuelve la longitud
+int registro_json(char *buf, size_t len);
+
+// GET y POST /api/registro
+esp_err_t registro_registrar(httpd_handle_t server);
+
+#endif // REGISTRO_H
@@ -0,0 +1,408 @@
+#include "resumen.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+static const char *TAG = "RESUMEN";
+
+#define MAGIC       0x314D5352u   // "RSM1"
+#define PAGINA      4096
+#define REG         ((uint32_t)sizeof(resumen_t))
+#define CAB         ((uint32_t)sizeof(pagina_cab_t))
+#define POR_PAGINA  ((PAGINA - CAB) / REG)
+#define DIA         86400
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;            // +1 por cada página abierta del nivel
+    uint32_t t0;             // Inicio del primer registro
+    uint32_t crc;            // CRC-32 de los campos anteriores
+} pagina_cab_t;
+
+// Suma exacta de un intervalo (los registros guardan la media ya redondeada)
+typedef struct {
+    uint32_t n;
+    int32_t suma_t;
+    uint32_t suma_h;
+    int16_t t_min, t_max;
+    uint16_t h_min, h_max;
+} parcial_t;
+
+typedef struct {
+    uint32_t periodo;
+    uint32_t primera;        // Primera página del nivel dentro de la partición
+    uint32_t num_paginas;
+    uint32_t *t0;
+    // Índice, bajo lock
+    uint32_t antigua;
+    uint32_t validas;
+    uint32_t seq_actual;
+    // Solo la tarea del histórico, salvo abierto (bajo lock, lo lee /api/history)
+    uint32_t libre;          // Siguiente registro libre en la última página
+    uint32_t inicio, fin;    // Intervalo abierto
+    parcial_t abierto;
+} nivel_t;
+
+static uint32_t t0_minuto[RESUMEN_PAGINAS_MINUTO];
+static uint32_t t0_hora[RESUMEN_PAGINAS_HORA];
+static uint32_t t0_dia[RESUMEN_PAGINAS_DIA];
+
+static nivel_t niveles[RESUMEN_NIVELES] = {
+    { .periodo = 60, .primera = 0, .num_paginas = RESUMEN_PAGINAS_MINUTO, .t0 = t0_minuto },
+    { .periodo = 3600, .primera = RESUMEN_PAGINAS_MINUTO, .num_paginas = RESUMEN_PAGINAS_HORA, .t0 = t0_hora },
+    { .periodo = DIA, .primera = RESUMEN_PAGINAS_MINUTO + RESUMEN_PAGINAS_HORA,
+      .num_paginas = RESUMEN_PAGINAS_DIA, .t0 = t0_dia },
+};
+
+static const esp_partition_t *part = NULL;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void sumar(nivel_t *nv, const parcial_t *p, uint32_t t);
+
+static uint32_t crc_cab(const pagina_cab_t *c) {
+    return esp_rom_crc32_le(0, (const uint8_t *)c, offsetof(pagina_cab_t, crc));
+}
+
+static uint8_t crc_registro(const resumen_t *r) {
+    return esp_rom_crc8_le(0, (const uint8_t *)r, offsetof(resumen_t, crc));
+}
+
+static size_t dir(const nivel_t *nv, uint32_t p) {
+    return (size_t)(nv->primera + p) * PAGINA;
+}
+
+static bool leer_cab(const nivel_t *nv, uint32_t p, pagina_cab_t *c) {
+    return esp_partition_read(part, dir(nv, p), c, CAB) == ESP_OK && c->magic == MAGIC && c->crc == crc_cab(c);
+}
+
+static bool vacio(const void *buf, size_t len) {
+    const uint8_t *b = buf;
+    for (size_t i = 0; i < len; i++) {
+        if (b[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool registro_vacio(const nivel_t *nv, uint32_t p, uint32_t i) {
+    resumen_t r;
+    return esp_partition_read(part, dir(nv, p) + CAB + i * REG, &r, REG) == ESP_OK && vacio(&r, REG);
+}
+
+// Inicio del intervalo que contiene t. Los días empiezan a medianoche local.
+static uint32_t inicio_intervalo(uint32_t periodo, uint32_t t) {
+    if (periodo < DIA) {
+        return t - t % periodo;
+    }
+    time_t tt = t;
+    struct tm tm;
+    localtime_r(&tt, &tm);
+    tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+    tm.tm_isdst = -1;   // El cambio de hora puede caer entre medianoche y t
+    return (uint32_t)mktime(&tm);
+}
+
+// Fin del intervalo que empieza en inicio. Un día local dura 23, 24 o 25 horas: 26 h
+// después de su medianoche ya es el día siguiente.
+static uint32_t fin_intervalo(uint32_t periodo, uint32_t inicio) {
+    return periodo < DIA ? inicio + periodo : inicio_intervalo(DIA, inicio + DIA + 2 * 3600);
+}
+
+// Reconstruir el índice del nivel como en historia.c: la página con la secuencia más
+// alta es la actual y su primer registro libre se busca por bisección
+static void reconstruir(nivel_t *nv) {
+    pagina_cab_t c;
+    bool valida[RESUMEN_PAGINAS_MINUTO + RESUMEN_PAGINAS_HORA + RESUMEN_PAGINAS_DIA];
+    uint32_t seq[RESUMEN_PAGINAS_MINUTO + RESUMEN_PAGINAS_HORA + RESUMEN_PAGINAS_DIA];
+    int actual = -1;
+    for (uint32_t p = 0; p < nv->num_paginas; p++) {
+        valida[p] = leer_cab(nv, p, &c);
+        seq[p] = c.seq;
+        nv->t0[p] = c.t0;
+        if (valida[p] && (actual < 0 || seq[p] > seq[actual])) {
+            actual = p;
+        }
+    }
+    nv->libre = POR_PAGINA;
+    if (actual < 0) {
+        return;
+    }
+    nv->antigua = actual;
+    nv->validas = 1;
+    nv->seq_actual = seq[actual];
+    while (nv->validas < nv->num_paginas) {
+        uint32_t q = (nv->antigua + nv->num_paginas - 1) % nv->num_paginas;
+        if (!valida[q] || seq[q] != seq[nv->antigua] - 1) {
+            break;
+        }
+        nv->antigua = q;
+        nv->validas++;
+    }
+    uint32_t lo = 0, hi = POR_PAGINA;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (registro_vacio(nv, actual, mid)) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    nv->libre = lo;
+}
+
+// Abrir la página siguiente a la actual, borrando la más antigua del nivel si está lleno
+static bool abrir_pagina(nivel_t *nv, uint32_t t) {
+    uint32_t p = nv->validas ? (nv->antigua + nv->validas) % nv->num_paginas : nv->antigua;
+    portENTER_CRITICAL(&lock);
+    if (nv->validas == nv->num_paginas) {
+        nv->antigua = (nv->antigua + 1) % nv->num_paginas;   // Sale del índice antes de borrarla
+        nv->validas--;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    pagina_cab_t c = { .magic = MAGIC, .seq = nv->seq_actual + 1, .t0 = t };
+    c.crc = crc_cab(&c);
+    esp_err_t err = esp_partition_erase_range(part, dir(nv, p), PAGINA);
+    if (err == ESP_OK) {
+        err = esp_partition_write(part, dir(nv, p), &c, CAB);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No se pudo preparar la página %lu: %s", (unsigned long)(nv->primera + p), esp_err_to_name(err));
+        return false;
+    }
+    portENTER_CRITICAL(&lock);
+    nv->t0[p] = t;
+    nv->seq_actual = c.seq;
+    nv->validas++;
+    portEXIT_CRITICAL(&lock);
+    nv->libre = 0;
+    return true;
+}
+
+static void escribir(nivel_t *nv, const resumen_t *r) {
+    if ((nv->validas == 0 || nv->libre >= POR_PAGINA) && !abrir_pagina(nv, r->t)) {
+        return;
+    }
+    uint32_t p = (nv->antigua + nv->validas - 1) % nv->num_paginas;
+    esp_err_t err = esp_partition_write(part, dir(nv, p) + CAB + nv->libre * REG, r, REG);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error escribiendo el resumen: %s", esp_err_to_name(err));
+    }
+    nv->libre++;    // Aun con error: ese hueco puede estar a medias
+}
+
+static int32_t media(int64_t suma, uint32_t n) {
+    return (int32_t)((suma >= 0 ? suma + n / 2 : suma - (int64_t)(n / 2)) / (int64_t)n);
+}
+
+static resumen_t a_registro(uint32_t t, const parcial_t *p) {
+    resumen_t r = {
+        .t = t,
+        .n = p->n > UINT16_MAX ? UINT16_MAX : (uint16_t)p->n,
+        .t_min = p->t_min,
+        .t_media = (int16_t)media(p->suma_t, p->n),
+        .t_max = p->t_max,
+        .h_min = p->h_min,
+        .h_media = (uint16_t)media(p->suma_h, p->n),
+        .h_max = p->h_max,
+    };
+    r.crc = crc_registro(&r);
+    return r;
+}
+
+static parcial_t de_registro(const resumen_t *r) {
+    parcial_t p = {
+        .n = r->n,
+        .suma_t = (int32_t)r->t_media * r->n,
+        .suma_h = (uint32_t)r->h_media * r->n,
+        .t_min = r->t_min,
+        .t_max = r->t_max,
+        .h_min = r->h_min,
+        .h_max = r->h_max,
+    };
+    return p;
+}
+
+// Guardar el intervalo abierto y pasarlo al nivel superior
+static void cerrar(nivel_t *nv) {
+    resumen_t r = a_registro(nv->inicio, &nv->abierto);
+    parcial_t p = nv->abierto;
+    portENTER_CRITICAL(&lock);
+    nv->abierto.n = 0;
+    portEXIT_CRITICAL(&lock);
+    escribir(nv, &r);
+    if (nv < &niveles[RESUMEN_NIVELES - 1]) {
+        sumar(nv + 1, &p, r.t);
+    }
+}
+
+// Añadir p (que empieza en t) al intervalo abierto del nivel: O(1) salvo al cruzar el
+// fin del intervalo, y como mucho una vez por nivel
+static void sumar(nivel_t *nv, const parcial_t *p, uint32_t t) {
+    if (nv->abierto.n && t < nv->inicio) {
+        return;   // Hora corregida hacia atrás: no reescribir intervalos ya cerrados
+    }
+    if (nv->abierto.n && t >= nv->fin) {
+        cerrar(nv);
+    }
+    portENTER_CRITICAL(&lock);
+    parcial_t *a = &nv->abierto;
+    if (a->n == 0) {
+        nv->inicio = inicio_intervalo(nv->periodo, t);
+        nv->fin = fin_intervalo(nv->periodo, nv->inicio);
+        *a = *p;
+    } else {
+        a->n += p->n;
+        a->suma_t += p->suma_t;
+        a->suma_h += p->suma_h;
+        a->t_min = p->t_min < a->t_min ? p->t_min : a->t_min;
+        a->t_max = p->t_max > a->t_max ? p->t_max : a->t_max;
+        a->h_min = p->h_min < a->h_min ? p->h_min : a->h_min;
+        a->h_max = p->h_max > a->h_max ? p->h_max : a->h_max;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void resumen_muestra(uint32_t t, int16_t temperatura, uint16_t humedad) {
+    if (part == NULL) {
+        return;
+    }
+    parcial_t p = { 1, temperatura, humedad, temperatura, temperatura, humedad, humedad };
+    sumar(&niveles[0], &p, t);
+}
+
+uint32_t resumen_periodo(int nivel) {
+    return niveles[nivel].periodo;
+}
+
+uint32_t resumen_desde(int nivel) {
+    const nivel_t *nv = &niveles[nivel];
+    portENTER_CRITICAL(&lock);
+    uint32_t t = nv->validas ? nv->t0[nv->antigua] : nv->abierto.n ? nv->inicio : UINT32_MAX;
+    portEXIT_CRITICAL(&lock);
+    return part ? t : UINT32_MAX;
+}
+
+// Registros desde la última página cuyo primer registro no es posterior a desde. Si la
+// tarea del histórico recicla una página mientras se lee (cambia su secuencia), se acaba ahí.
+esp_err_t resumen_recorrer(int nivel, uint32_t desde, uint32_t hasta, void *pagina_buf,
+                           resumen_cb_t cb, void *arg) {
+    if (part == NULL) {
+        return ESP_OK;
+    }
+    nivel_t *nv = &niveles[nivel];
+    portENTER_CRITICAL(&lock);
+    uint32_t lo = 0, hi = nv->validas;   // Primera página lógica con t0 > desde
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (nv->t0[(nv->antigua + mid) % nv->num_paginas] <= desde) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    uint32_t inicio = lo ? lo - 1 : 0;
+    uint32_t pagina = (nv->antigua + inicio) % nv->num_paginas;
+    uint32_t seq = nv->seq_actual - (nv->validas - 1 - inicio);
+    uint32_t quedan = nv->validas - inicio;
+    portEXIT_CRITICAL(&lock);
+
+    const pagina_cab_t *c = pagina_buf;
+    const resumen_t *regs = (const resumen_t *)((const uint8_t *)pagina_buf + CAB);
+    for (; quedan > 0; quedan--, seq++, pagina = (pagina + 1) % nv->num_paginas) {
+        if (esp_partition_read(part, dir(nv, pagina), pagina_buf, PAGINA) != ESP_OK ||
+            c->magic != MAGIC || c->crc != crc_cab(c) || c->seq != seq) {
+            break;
+        }
+        for (uint32_t i = 0; i < POR_PAGINA && !vacio(&regs[i], REG); i++) {
+            resumen_t r = regs[i];
+            if (r.crc != crc_registro(&r) || r.t < desde) {
+                continue;
+            }
+            if (r.t > hasta) {
+                return ESP_OK;
+            }
+            esp_err_t err = cb(&r, arg);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+
+    portENTER_CRITICAL(&lock);
+    uint32_t t = nv->inicio;
+    parcial_t abierto = nv->abierto;
+    portEXIT_CRITICAL(&lock);
+    if (abierto.n == 0 || t < desde || t > hasta) {
+        return ESP_OK;
+    }
+    resumen_t r = a_registro(t, &abierto);
+    return cb(&r, arg);
+}
+
+// Último registro guardado del nivel
+static bool ultimo(const nivel_t *nv, resumen_t *r) {
+    if (nv->validas == 0) {
+        return false;
+    }
+    uint32_t p = (nv->antigua + nv->validas - 1) % nv->num_paginas;
+    uint32_t i = nv->libre;
+    if (i == 0) {
+        if (nv->validas == 1) {
+            return false;
+        }
+        p = (p + nv->num_paginas - 1) % nv->num_paginas;
+        i = POR_PAGINA;
+    }
+    return esp_partition_read(part, dir(nv, p) + CAB + (i - 1) * REG, r, REG) == ESP_OK &&
+           r->crc == crc_registro(r);
+}
+
+static esp_err_t recuperar_cb(const resumen_t *r, void *arg) {
+    parcial_t p = de_registro(r);
+    sumar(arg, &p, r->t);
+    return ESP_OK;
+}
+
+// Los intervalos abiertos se pierden al reiniciar; el de cada nivel se rehace con los
+// registros del nivel inferior posteriores a su último registro. Primero el de arriba:
+// lo que el de abajo cierre al rehacerse le llega después como siempre.
+static void recuperar_abiertos(void *pagina_buf) {
+    for (int k = RESUMEN_NIVELES - 1; k > 0; k--) {
+        nivel_t *nv = &niveles[k];
+        resumen_t r;
+        uint32_t desde = ultimo(nv, &r) ? fin_intervalo(nv->periodo, r.t) : 0;
+        resumen_recorrer(k - 1, desde, UINT32_MAX, pagina_buf, recuperar_cb, nv);
+    }
+}
+
+esp_err_t resumen_init(void) {
+    const esp_partition_t *p =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, RESUMEN_PARTICION);
+    uint32_t paginas = RESUMEN_PAGINAS_MINUTO + RESUMEN_PAGINAS_HORA + RESUMEN_PAGINAS_DIA;
+    if (p == NULL || p->size < paginas * PAGINA) {
+        ESP_LOGW(TAG, "Sin partición \"%s\" de %lu KB: resúmenes desactivados", RESUMEN_PARTICION,
+                 (unsigned long)(paginas * PAGINA / 1024));
+        return ESP_ERR_NOT_FOUND;
+    }
+    void *buf = malloc(PAGINA);
+    if (buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    part = p;
+    for (int k = 0; k < RESUMEN_NIVELES; k++) {
+        reconstruir(&niveles[k]);
+    }
+    recuperar_abiertos(buf);
+    free(buf);
+    ESP_LOGI(TAG, "Resúmenes: %lu/%lu/%lu páginas en uso (1 min/1 h/1 día)", (unsigned long)niveles[0].validas,
+             (unsigned long)niveles[1].validas, (unsigned long)niveles[2].validas);
+    return ESP_OK;
+}
@@ -0,0 +1,68 @@
+// Resúmenes del histórico a 1 minuto, 1 hora y 1 día (mínimo, media, máximo y número
+// de lecturas) en la partición "resumen" de la flash. Cada nivel es un registro circular
+// de páginas propio, como el de historia.c pero con registros de tamaño fijo, y guarda
+// mucho más tiempo que las lecturas sin resumir: un gráfico de un año son 365 puntos.
+//
+// Cada lectura actualiza el intervalo abierto del nivel de 1 minuto en O(1); al cerrarse
+// se escribe y se suma al de 1 hora, y este al de 1 día. Las horas van alineadas en UTC
+// y los días de medianoche a medianoche en hora local (RIEGO_ZONA_HORARIA).
+// Lo escribe la tarea del histórico (historia.c), que es quien pone la hora a las lecturas.
+#ifndef RESUMEN_H
+#define RESUMEN_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "wifi_config.h"
+
+#define RESUMEN_PARTICION "resumen"
+#define RESUMEN_NIVELES   3         // 1 min, 1 h, 1 día
+
+// Páginas de 4 KB de cada nivel (204 registros por página; se pueden redefinir en
+// wifi_config.h ajustando la partición): se pierde una al rotar.
+// 6 páginas de 1 min = unas 17 horas, 6 de 1 h = unas 6 semanas, 4 de 1 día = más de
+// año y medio: las 16 páginas de la partición (64 KB).
+#ifndef RESUMEN_PAGINAS_MINUTO
+#define RESUMEN_PAGINAS_MINUTO 6
+#endif
+#ifndef RESUMEN_PAGINAS_HORA
+#define RESUMEN_PAGINAS_HORA   6
+#endif
+#ifndef RESUMEN_PAGINAS_DIA
+#define RESUMEN_PAGINAS_DIA    4
+#endif
+
+// Registro en flash (20 bytes)
+typedef struct {
+    uint32_t t;              // Inicio del intervalo (hora Unix)
+    uint16_t n;              // Lecturas resumidas
+    int16_t t_min;           // Décimas de °C
+    int16_t t_media;
+    int16_t t_max;
+    uint16_t h_min;          // Décimas de %
+    uint16_t h_media;
+    uint16_t h_max;
+    uint8_t reservado;
+    uint8_t crc;             // CRC-8 de los campos anteriores
+} resumen_t;
+
+typedef esp_err_t (*resumen_cb_t)(const resumen_t *r, void *arg);
+
+// Buscar la partición, reconstruir los niveles y recuperar los intervalos abiertos de
+// las horas y días a partir de los niveles inferiores
+esp_err_t resumen_init(void);
+
+// Sumar una lectura con hora Unix (décimas de °C y %). Solo desde la tarea del histórico.
+void resumen_muestra(uint32_t t, int16_t temperatura, uint16_t humedad);
+
+// Duración en segundos de los intervalos del nivel
+uint32_t resumen_periodo(int nivel);
+
+// Inicio del registro más antiguo del nivel (UINT32_MAX si está vacío)
+uint32_t resumen_desde(int nivel);
+
+// Llamar a cb con los registros del nivel cuyo inicio está en [desde, hasta], en orden,
+// y al final con el intervalo abierto si también lo está. pagina_buf: 4096 bytes.
+esp_err_t resumen_recorrer(int nivel, uint32_t desde, uint32_t hasta, void *pagina_buf,
+                           resumen_cb_t cb, void *arg);
+
+#endif // RESUMEN_H
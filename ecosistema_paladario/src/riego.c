@@ -0,0 +1,479 @@
+#include "riego.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "cJSON.h"
+
+static const char *TAG = "RIEGO";
+
+#define US(s) ((int64_t)(s) * 1000000)
+#define DIA_S (24 * 3600)
+#define TOLERANCIA_S 5       // Margen del temporizador respecto a la hora de cada lluvia
+
+typedef struct {
+    actuador_id_t id;
+    riego_limites_t lim;
+    esp_timer_handle_t apagar;
+    int64_t encendida_us;    // 0 = apagada
+    int64_t parada_us;       // Último apagado, para el enfriamiento (0 = nunca)
+    float saldo_s;           // Cubo de tokens del ciclo de trabajo, en segundos encendida
+    int64_t saldo_us;        // Última actualización de saldo_s
+} bomba_t;
+
+static bomba_t bombas[] = {
+    { .id = ACT_BOMBA_LLUVIA,
+      .lim = { RIEGO_LLUVIA_MAX_S, RIEGO_LLUVIA_ENFRIAMIENTO_S, RIEGO_LLUVIA_CICLO_PCT } },
+    { .id = ACT_BOMBA_CASCADA,
+      .lim = { RIEGO_CASCADA_MAX_S, RIEGO_CASCADA_ENFRIAMIENTO_S, RIEGO_CASCADA_CICLO_PCT } },
+};
+#define NUM_BOMBAS (sizeof(bombas) / sizeof(bombas[0]))
+
+// Tarea del esp_timer, task_sensor, httpd y MQTT: todo bajo mutex
+static SemaphoreHandle_t mutex;
+static riego_ventana_t ventanas[RIEGO_MAX_VENTANAS];
+static int num_ventanas = 0;
+static esp_timer_handle_t programa;
+static riego_cambio_t al_cambiar = NULL;
+
+static bomba_t *bomba(actuador_id_t id) {
+    for (size_t i = 0; i < NUM_BOMBAS; i++) {
+        if (bombas[i].id == id) {
+            return &bombas[i];
+        }
+    }
+    return NULL;
+}
+
+static float saldo_max(const bomba_t *b) {
+    return b->lim.ciclo_pct * (RIEGO_CICLO_S / 100.0f);
+}
+
+// Recarga del cubo: ciclo_pct segundos por cada 100 s transcurridos, hasta el máximo
+static void actualizar_saldo(bomba_t *b, int64_t ahora) {
+    b->saldo_s += b->lim.ciclo_pct / 100.0f * (ahora - b->saldo_us) / 1e6f;
+    if (b->saldo_s > saldo_max(b)) {
+        b->saldo_s = saldo_max(b);
+    }
+    b->saldo_us = ahora;
+}
+
+static int enfriamiento_restante_s(const bomba_t *b, int64_t ahora) {
+    if (b->parada_us == 0 || b->encendida_us != 0) {
+        return 0;
+    }
+    int64_t fin = b->parada_us + US(b->lim.enfriamiento_s);
+    return ahora < fin ? (int)((fin - ahora + 999999) / 1000000) : 0;
+}
+
+static void apagar(bomba_t *b, int64_t ahora) {
+    if (b->encendida_us == 0) {
+        return;
+    }
+    esp_timer_stop(b->apagar);
+    actualizar_saldo(b, ahora);
+    b->saldo_s -= (ahora - b->encendida_us) / 1e6f;
+    if (b->saldo_s < 0.0f) {
+        b->saldo_s = 0.0f;
+    }
+    b->encendida_us = 0;
+    b->parada_us = ahora;
+    actuador_set(b->id, false);
+}
+
+// Sin enfriamiento pendiente y con saldo para al menos un segundo de pulso
+static bool disponible(bomba_t *b, int64_t ahora) {
+    if (enfriamiento_restante_s(b, ahora) > 0) {
+        return false;
+    }
+    actualizar_saldo(b, ahora);
+    return b->saldo_s >= 1.0f && b->lim.max_continuo_s >= 1;
+}
+
+// Pulso de hasta duracion_s, recortado por max_continuo_s y el saldo del ciclo
+static bool encender(bomba_t *b, int duracion_s, int64_t ahora) {
+    if (b->encendida_us != 0) {
+        return true;  // Ya en marcha: se mantiene el pulso en curso
+    }
+    int enfriando = enfriamiento_restante_s(b, ahora);
+    if (enfriando > 0) {
+        ESP_LOGW(TAG, "%s en enfriamiento (%d s)", actuadores[b->id].id, enfriando);
+        return false;
+    }
+    actualizar_saldo(b, ahora);
+    float s = duracion_s;
+    if (s > b->lim.max_continuo_s) s = b->lim.max_continuo_s;
+    if (s > b->saldo_s) s = b->saldo_s;
+    if (s < 1.0f) {
+        ESP_LOGW(TAG, "%s: ciclo de trabajo agotado (%d%%/h)", actuadores[b->id].id, b->lim.ciclo_pct);
+        return false;
+    }
+    b->encendida_us = ahora;
+    actuador_set(b->id, true);
+    esp_timer_start_once(b->apagar, (uint64_t)(s * 1e6f));
+    ESP_LOGI(TAG, "%s: pulso de %.0f s", actuadores[b->id].id, s);
+    return true;
+}
+
+static void fin_pulso(void *arg) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    apagar(arg, esp_timer_get_time());
+    xSemaphoreGive(mutex);
+    if (al_cambiar) {
+        al_cambiar();
+    }
+}
+
+// Segundo del día en hora local, o -1 si aún no hay hora (SNTP)
+static int segundo_del_dia(void) {
+    time_t t = time(NULL);
+    struct tm tm;
+    localtime_r(&t, &tm);
+    if (tm.tm_year < 2024 - 1900) {
+        return -1;
+    }
+    return tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+}
+
+static bool en_ventana(const riego_ventana_t *v, int seg) {
+    int min = seg / 60;
+    return v->inicio_min <= v->fin_min ? (min >= v->inicio_min && min < v->fin_min)
+                                       : (min >= v->inicio_min || min < v->fin_min);
+}
+
+static int duracion_ventana_min(const riego_ventana_t *v) {
+    return (v->fin_min - v->inicio_min + 24 * 60) % (24 * 60);
+}
+
+// Lluvias periódicas de la ventana: inicio + k * cada_min mientras siga abierta
+static int num_pulsos(const riego_ventana_t *v) {
+    return v->cada_min ? (duracion_ventana_min(v) + v->cada_min - 1) / v->cada_min : 0;
+}
+
+static int segundo_pulso(const riego_ventana_t *v, int k) {
+    return (v->inicio_min + k * v->cada_min) % (24 * 60) * 60;
+}
+
+// Segundos hasta el evento t (segundo del día) desde seg
+static int hasta(int seg, int t) {
+    return ((t - seg) % DIA_S + DIA_S) % DIA_S;
+}
+
+// Llover si la humedad está por debajo del umbral de alguna ventana abierta. Con la
+// bomba en enfriamiento o sin saldo se calla: se reevalúa en cada muestra (10 s)
+static bool disparar_por_humedad(float humedad, int seg, int64_t ahora) {
+    bool cambio = false;
+    for (int i = 0; i < num_ventanas; i++) {
+        const riego_ventana_t *v = &ventanas[i];
+        bomba_t *b = bomba(v->bomba);
+        if (b && v->hum_min > 0 && en_ventana(v, seg) && humedad < v->hum_min && b->encendida_us == 0 &&
+            disponible(b, ahora)) {
+            ESP_LOGI(TAG, "Humedad %.1f%% < %d%%", humedad, v->hum_min);
+            cambio |= encender(b, v->pulso_s, ahora);
+        }
+    }
+    return cambio;
+}
+
+// Armar el temporizador para la próxima lluvia periódica. Las de los próximos
+// TOLERANCIA_S segundos ya las ha atendido evento_programa. Llamar con el mutex tomado.
+static void armar_programa(int seg) {
+    esp_timer_stop(programa);
+    if (seg < 0) {
+        return;  // Sin hora: se rearma al sincronizar
+    }
+    int espera = -1;
+    for (int i = 0; i < num_ventanas; i++) {
+        for (int k = 0; k < num_pulsos(&ventanas[i]); k++) {
+            int d = hasta(seg, segundo_pulso(&ventanas[i], k));
+            if (d <= TOLERANCIA_S) {
+                d += DIA_S;
+            }
+            if (espera < 0 || d < espera) {
+                espera = d;
+            }
+        }
+    }
+    if (espera > 0) {
+        esp_timer_start_once(programa, US(espera));
+    }
+}
+
+// Lluvias periódicas que tocan ahora (el temporizador puede adelantarse o retrasarse
+// un poco respecto a la hora local, que SNTP va corrigiendo)
+static void evento_programa(void *arg) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int64_t ahora = esp_timer_get_time();
+    int seg = segundo_del_dia();
+    bool cambio = false;
+    for (int i = 0; seg >= 0 && i < num_ventanas; i++) {
+        const riego_ventana_t *v = &ventanas[i];
+        bomba_t *b = bomba(v->bomba);
+        for (int k = 0; b && k < num_pulsos(v); k++) {
+            int d = hasta(seg, segundo_pulso(v, k));
+            if (d <= TOLERANCIA_S || d >= DIA_S - TOLERANCIA_S) {
+                cambio |= encender(b, v->pulso_s, ahora);
+                break;
+            }
+        }
+    }
+    armar_programa(seg);
+    xSemaphoreGive(mutex);
+    if (cambio && al_cambiar) {
+        al_cambiar();
+    }
+}
+
+static void guardar(void) {
+    nvs_handle_t h;
+    if (nvs_open("riego", NVS_READWRITE, &h) != ESP_OK) {
+        ESP_LOGE(TAG, "No se pudo abrir NVS");
+        return;
+    }
+    riego_limites_t lim[NUM_BOMBAS];
+    for (size_t i = 0; i < NUM_BOMBAS; i++) {
+        lim[i] = bombas[i].lim;
+    }
+    nvs_set_blob(h, "limites", lim, sizeof(lim));
+    nvs_set_blob(h, "ventanas", ventanas, num_ventanas * sizeof(riego_ventana_t));
+    nvs_commit(h);
+    nvs_close(h);
+}
+
+// Un blob de otro tamaño (otra versión del firmware) se ignora
+static void cargar(void) {
+    nvs_handle_t h;
+    if (nvs_open("riego", NVS_READONLY, &h) != ESP_OK) {
+        return;
+    }
+    riego_limites_t lim[NUM_BOMBAS];
+    size_t len = sizeof(lim);
+    if (nvs_get_blob(h, "limites", lim, &len) == ESP_OK && len == sizeof(lim)) {
+        for (size_t i = 0; i < NUM_BOMBAS; i++) {
+            bombas[i].lim = lim[i];
+        }
+    }
+    len = sizeof(ventanas);
+    if (nvs_get_blob(h, "ventanas", ventanas, &len) == ESP_OK && len % sizeof(riego_ventana_t) == 0) {
+        num_ventanas = len / sizeof(riego_ventana_t);
+    }
+    nvs_close(h);
+}
+
+void riego_init(riego_cambio_t cb) {
+    al_cambiar = cb;
+    mutex = xSemaphoreCreateMutex();
+    cargar();
+
+    int64_t ahora = esp_timer_get_time();
+    for (size_t i = 0; i < NUM_BOMBAS; i++) {
+        esp_timer_create_args_t args = {
+            .callback = fin_pulso,
+            .arg = &bombas[i],
+            .name = "riego_pulso",
+        };
+        esp_timer_create(&args, &bombas[i].apagar);
+        bombas[i].saldo_s = saldo_max(&bombas[i]);
+        bombas[i].saldo_us = ahora;
+    }
+    esp_timer_create_args_t args = {
+        .callback = evento_programa,
+        .name = "riego_programa",
+    };
+    esp_timer_create(&args, &programa);
+
+    setenv("TZ", RIEGO_ZONA_HORARIA, 1);
+    tzset();
+    armar_programa(segundo_del_dia());
+    ESP_LOGI(TAG, "Riego: %d ventanas", num_ventanas);
+}
+
+bool riego_es_bomba(actuador_id_t id) {
+    return bomba(id) != NULL;
+}
+
+bool riego_manual(actuador_id_t id, bool activar) {
+    bomba_t *b = bomba(id);
+    if (b == NULL) {
+        return false;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int64_t ahora = esp_timer_get_time();
+    bool ok = true;
+    if (activar) {
+        ok = encender(b, b->lim.max_continuo_s, ahora);
+    } else {
+        apagar(b, ahora);
+    }
+    xSemaphoreGive(mutex);
+    return ok;
+}
+
+void riego_muestra(const sensor_sample_t *m) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int seg = segundo_del_dia();
+    bool cambio = seg >= 0 && disparar_por_humedad(m->humedad, seg, esp_timer_get_time());
+    xSemaphoreGive(mutex);
+    if (cambio && al_cambiar) {
+        al_cambiar();
+    }
+}
+
+void riego_reprogramar(void) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int seg = segundo_del_dia();
+    armar_programa(seg);
+    xSemaphoreGive(mutex);
+    if (seg >= 0) {
+        ESP_LOGI(TAG, "Hora local: %02d:%02d, programa armado", seg / 3600, seg / 60 % 60);
+    }
+}
+
+static int bomba_por_nombre(const char *id) {
+    for (size_t i = 0; i < NUM_BOMBAS; i++) {
+        if (strcmp(actuadores[bombas[i].id].id, id) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Entero en [min, max] de un objeto JSON; ausente = se deja *v igual
+static bool leer_entero(const cJSON *obj, const char *clave, int min, int max, int *v) {
+    const cJSON *n = cJSON_GetObjectItemCaseSensitive(obj, clave);
+    if (n == NULL) {
+        return true;
+    }
+    if (!cJSON_IsNumber(n) || n->valuedouble < min || n->valuedouble > max) {
+        return false;
+    }
+    *v = (int)n->valuedouble;
+    return true;
+}
+
+// "HH:MM" -> minuto del día
+static bool leer_hora(const cJSON *obj, const char *clave, uint16_t *min) {
+    const cJSON *s = cJSON_GetObjectItemCaseSensitive(obj, clave);
+    unsigned h, m;
+    char fin;
+    if (!cJSON_IsString(s) || sscanf(s->valuestring, "%2u:%2u%c", &h, &m, &fin) != 2 || h > 23 || m > 59) {
+        return false;
+    }
+    *min = h * 60 + m;
+    return true;
+}
+
+static bool leer_limites(const cJSON *json, riego_limites_t *lim) {
+    const cJSON *item;
+    cJSON_ArrayForEach(item, json) {
+        int i = bomba_por_nombre(item->string);
+        int max_s = lim[i < 0 ? 0 : i].max_continuo_s;
+        int enfr = lim[i < 0 ? 0 : i].enfriamiento_s;
+        int pct = lim[i < 0 ? 0 : i].ciclo_pct;
+        if (i < 0 || !cJSON_IsObject(item) ||
+            !leer_entero(item, "max_s", 1, 3600, &max_s) ||
+            !leer_entero(item, "enfriamiento_s", 0, 3600, &enfr) ||
+            !leer_entero(item, "ciclo_pct", 1, 100, &pct)) {
+            return false;
+        }
+        lim[i] = (riego_limites_t){ max_s, enfr, pct };
+    }
+    return true;
+}
+
+static bool leer_ventanas(const cJSON *json, riego_ventana_t *v, int *n) {
+    if (!cJSON_IsArray(json) || cJSON_GetArraySize(json) > RIEGO_MAX_VENTANAS) {
+        return false;
+    }
+    *n = 0;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, json) {
+        const cJSON *id = cJSON_GetObjectItemCaseSensitive(item, "bomba");
+        int b = cJSON_IsString(id) ? bomba_por_nombre(id->valuestring) : -1;
+        int hum = 0, pulso = 0, cada = 0;
+        riego_ventana_t *w = &v[(*n)++];
+        if (b < 0 || !leer_hora(item, "inicio", &w->inicio_min) || !leer_hora(item, "fin", &w->fin_min) ||
+            !leer_entero(item, "hum_min", 0, 100, &hum) ||
+            !leer_entero(item, "pulso_s", 1, 3600, &pulso) || pulso == 0 ||
+            !leer_entero(item, "cada_min", 0, 24 * 60, &cada) ||
+            w->inicio_min == w->fin_min || (hum == 0 && cada == 0)) {
+            return false;
+        }
+        w->bomba = bombas[b].id;
+        w->hum_min = hum;
+        w->pulso_s = pulso;
+        w->cada_min = cada;
+    }
+    return true;
+}
+
+bool riego_config_json(const char *json, size_t len) {
+    cJSON *raiz = cJSON_ParseWithLength(json, len);
+    const cJSON *j_lim = cJSON_GetObjectItemCaseSensitive(raiz, "limites");
+    const cJSON *j_ven = cJSON_GetObjectItemCaseSensitive(raiz, "ventanas");
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    riego_limites_t lim[NUM_BOMBAS];
+    for (size_t i = 0; i < NUM_BOMBAS; i++) {
+        lim[i] = bombas[i].lim;
+    }
+    riego_ventana_t ven[RIEGO_MAX_VENTANAS];
+    int n = num_ventanas;
+    memcpy(ven, ventanas, sizeof(ven));
+
+    bool ok = cJSON_IsObject(raiz) && (j_lim || j_ven) &&
+              (j_lim == NULL || (cJSON_IsObject(j_lim) && leer_limites(j_lim, lim))) &&
+              (j_ven == NULL || leer_ventanas(j_ven, ven, &n));
+    if (ok) {
+        int64_t ahora = esp_timer_get_time();
+        for (size_t i = 0; i < NUM_BOMBAS; i++) {
+            actualizar_saldo(&bombas[i], ahora);
+            bombas[i].lim = lim[i];
+            actualizar_saldo(&bombas[i], ahora);  // Recorta el saldo al nuevo máximo
+        }
+        memcpy(ventanas, ven, sizeof(ventanas));
+        num_ventanas = n;
+        guardar();
+        armar_programa(segundo_del_dia());
+        ESP_LOGI(TAG, "Configuración guardada: %d ventanas", num_ventanas);
+    }
+    xSemaphoreGive(mutex);
+    cJSON_Delete(raiz);
+    return ok;
+}
+
+int riego_json(char *buf, size_t len) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int64_t ahora = esp_timer_get_time();
+    int n = snprintf(buf, len, "{\"hora_ok\":%s,\"limites\":{", segundo_del_dia() >= 0 ? "true" : "false");
+    for (size_t i = 0; i < NUM_BOMBAS && n > 0 && (size_t)n < len; i++) {
+        bomba_t *b = &bombas[i];
+        actualizar_saldo(b, ahora);
+        float saldo = b->saldo_s - (b->encendida_us ? (ahora - b->encendida_us) / 1e6f : 0.0f);
+        n += snprintf(buf + n, len - n,
+                      "%s\"%s\":{\"max_s\":%u,\"enfriamiento_s\":%u,\"ciclo_pct\":%u,\"saldo_s\":%d,\"enfriando_s\":%d}",
+                      i ? "," : "", actuadores[b->id].id, b->lim.max_continuo_s, b->lim.enfriamiento_s,
+                      b->lim.ciclo_pct, saldo > 0.0f ? (int)saldo : 0, enfriamiento_restante_s(b, ahora));
+    }
+    if (n > 0 && (size_t)n < len) {
+        n += snprintf(buf + n, len - n, "},\"ventanas\":[");
+    }
+    for (int i = 0; i < num_ventanas && n > 0 && (size_t)n < len; i++) {
+        const riego_ventana_t *v = &ventanas[i];
+        n += snprintf(buf + n, len - n,
+                      "%s{\"bomba\":\"%s\",\"inicio\":\"%02u:%02u\",\"fin\":\"%02u:%02u\","
+                      "\"hum_min\":%u,\"pulso_s\":%u,\"cada_min\":%u}",
+                      i ? "," : "", actuadores[v->bomba].id, v->inicio_min / 60, v->inicio_min % 60,
+                      v->fin_min / 60, v->fin_min % 60, v->hum_min, v->pulso_s, v->cada_min);
+    }
+    if (n > 0 && (size_t)n < len) {
+        n += snprintf(buf + n, len - n, "]}");
+    }
+    xSemaphoreGive(mutex);
+    return n;
+}
@@ -0,0 +1,94 @@
+// Bombas de lluvia y cascada: pulsos temporizados con esp_timer y límites por bomba
+// (tiempo máximo seguido, enfriamiento tras parar, ciclo de trabajo máximo) que se
+// aplican a cualquier orden, sea del programa, de la web, de MQTT o de HA.
+// El ciclo de trabajo es un cubo de tokens: se recarga a ciclo_pct y guarda como
+// mucho el saldo de una hora, así que tras un rato parada una bomba puede gastar
+// esa hora de golpe.
+// El programa son ventanas horarias (hora local, requiere SNTP) que llueven cuando
+// la humedad baja de un umbral y/o cada N minutos. Entre eventos no hay sondeo: solo
+// un temporizador armado para el próximo evento horario y las muestras del sensor.
+// Límites y ventanas se guardan en NVS.
+#ifndef RIEGO_H
+#define RIEGO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "actuadores.h"
+#include "sample_ring.h"
+#include "wifi_config.h"
+
+// Valores por defecto; se pueden redefinir en wifi_config.h
+#ifndef RIEGO_ZONA_HORARIA
+#define RIEGO_ZONA_HORARIA "CET-1CEST,M3.5.0,M10.5.0/3"   // POSIX TZ (España peninsular)
+#endif
+#ifndef RIEGO_NTP_SERVIDOR
+#define RIEGO_NTP_SERVIDOR "pool.ntp.org"
+#endif
+#ifndef RIEGO_LLUVIA_MAX_S
+#define RIEGO_LLUVIA_MAX_S 60          // Encendida seguida como máximo
+#endif
+#ifndef RIEGO_LLUVIA_ENFRIAMIENTO_S
+#define RIEGO_LLUVIA_ENFRIAMIENTO_S 300
+#endif
+#ifndef RIEGO_LLUVIA_CICLO_PCT
+#define RIEGO_LLUVIA_CICLO_PCT 10      // % del tiempo encendida como máximo
+#endif
+#ifndef RIEGO_CASCADA_MAX_S
+#define RIEGO_CASCADA_MAX_S 1800
+#endif
+#ifndef RIEGO_CASCADA_ENFRIAMIENTO_S
+#define RIEGO_CASCADA_ENFRIAMIENTO_S 300
+#endif
+#ifndef RIEGO_CASCADA_CICLO_PCT
+#define RIEGO_CASCADA_CICLO_PCT 75
+#endif
+
+#define RIEGO_MAX_VENTANAS 8
+#define RIEGO_CICLO_S      3600        // Saldo máximo del ciclo de trabajo: ciclo_pct de este periodo
+#define RIEGO_JSON_MAX     1280
+
+typedef struct {
+    uint16_t max_continuo_s;
+    uint16_t enfriamiento_s;
+    uint8_t ciclo_pct;
+} riego_limites_t;
+
+typedef struct {
+    uint8_t bomba;           // actuador_id_t
+    uint8_t hum_min;         // Llover si la humedad baja de aquí (0 = no)
+    uint16_t inicio_min;     // Minuto del día, hora local
+    uint16_t fin_min;        // Si es menor que inicio, la ventana cruza la medianoche
+    uint16_t pulso_s;
+    uint16_t cada_min;       // Lluvia periódica desde el inicio (0 = no)
+} riego_ventana_t;
+
+// Avisado cada vez que una bomba cambia sin orden directa (fin de pulso, programa)
+typedef void (*riego_cambio_t)(void);
+
+// Cargar la configuración de NVS (nvs_flash_init ya hecho) y armar el programa
+void riego_init(riego_cambio_t al_cambiar);
+
+// true si id es una bomba gestionada por el riego
+bool riego_es_bomba(actuador_id_t id);
+
+// Orden manual: encender = pulso de hasta max_continuo_s, si los límites lo permiten.
+// false si se rechaza (enfriamiento o ciclo agotado).
+bool riego_manual(actuador_id_t id, bool activar);
+
+// Nueva lectura válida del sensor (desde task_sensor): dispara las ventanas por humedad
+void riego_muestra(const sensor_sample_t *m);
+
+// La hora local ha cambiado (sincronización SNTP): recalcular el próximo evento
+void riego_reprogramar(void);
+
+// Sustituir los límites de las bombas y/o las ventanas presentes en el JSON:
+// {"limites":{"bomba_lluvia":{"max_s":60,"enfriamiento_s":300,"ciclo_pct":10}},
+//  "ventanas":[{"bomba":"bomba_lluvia","inicio":"08:00","fin":"20:00","hum_min":75,"pulso_s":20,"cada_min":0}]}
+// Se guarda en NVS. false si el JSON no es válido (no se cambia nada).
+bool riego_config_json(const char *json, size_t len);
+
+// Configuración y estado en JSON; devuelve la longitud (como snprintf)
+int riego_json(char *buf, size_t len);
+
+#endif // RIEGO_H
@@ -0,0 +1,51 @@
+#include "sample_ring.h"
+
+// head/tail son contadores libres (no se enmascaran al guardar): head - tail es la
+// ocupación aunque den la vuelta. release/acquire publican el contenido del hueco.
+
+void sample_ring_init(sample_ring_t *r) {
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->overflows, 0);
+    atomic_init(&r->max_depth, 0);
+}
+
+bool sample_ring_push(sample_ring_t *r, const sensor_sample_t *s) {
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    uint32_t depth = head - tail;
+    if (depth >= SAMPLE_RING_SIZE) {
+        atomic_fetch_add_explicit(&r->overflows, 1, memory_order_relaxed);
+        return false;
+    }
+    r->buf[head & (SAMPLE_RING_SIZE - 1)] = *s;
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    if (depth + 1 > atomic_load_explicit(&r->max_depth, memory_order_relaxed)) {
+        atomic_store_explicit(&r->max_depth, depth + 1, memory_order_relaxed);
+    }
+    return true;
+}
+
+bool sample_ring_pop(sample_ring_t *r, sensor_sample_t *s) {
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+    *s = r->buf[tail & (SAMPLE_RING_SIZE - 1)];
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+uint32_t sample_ring_depth(sample_ring_t *r) {
+    return atomic_load_explicit(&r->head, memory_order_acquire) -
+           atomic_load_explicit(&r->tail, memory_order_acquire);
+}
+
+uint32_t sample_ring_overflows(sample_ring_t *r) {
+    return atomic_load_explicit(&r->overflows, memory_order_relaxed);
+}
+
+uint32_t sample_ring_max_depth(sample_ring_t *r) {
+    return atomic_load_explicit(&r->max_depth, memory_order_relaxed);
+}
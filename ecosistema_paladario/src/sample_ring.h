@@ -0,0 +1,38 @@
+// Cola circular lock-free de un productor / un consumidor para muestras del sensor.
+// task_sensor es el único productor y el publicador MQTT el único consumidor.
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SAMPLE_RING_SIZE 16  // Potencia de 2: 16 muestras = 160s de margen a 10s/muestra
+
+typedef struct {
+    int64_t timestamp_us;    // esp_timer_get_time() al completar la lectura
+    float temperatura;
+    float humedad;
+} sensor_sample_t;
+
+typedef struct {
+    sensor_sample_t buf[SAMPLE_RING_SIZE];
+    _Atomic uint32_t head;       // Escrito solo por el productor
+    _Atomic uint32_t tail;       // Escrito solo por el consumidor
+    _Atomic uint32_t overflows;  // Muestras descartadas por cola llena
+    _Atomic uint32_t max_depth;  // Máxima ocupación observada
+} sample_ring_t;
+
+void sample_ring_init(sample_ring_t *r);
+
+// Productor: nunca bloquea. Si la cola está llena descarta la muestra y cuenta el desbordamiento.
+bool sample_ring_push(sample_ring_t *r, const sensor_sample_t *s);
+
+// Consumidor: false si no hay muestras pendientes
+bool sample_ring_pop(sample_ring_t *r, sensor_sample_t *s);
+
+uint32_t sample_ring_depth(sample_ring_t *r);
+uint32_t sample_ring_overflows(sample_ring_t *r);
+uint32_t sample_ring_max_depth(sample_ring_t *r);
+
+#endif // SAMPLE_RING_H
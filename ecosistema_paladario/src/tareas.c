@@ -0,0 +1,83 @@
+#include "tareas.h"
+#include <stdbool.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "TAREAS";
+
+// Pila y TCB de cada tarea (StackType_t es un byte en ESP-IDF)
+#define TAREA_MEMORIA(id, nombre, nucleo, prio, bytes, prio_ant) \
+    static StackType_t pila_##id[bytes]; \
+    static StaticTask_t tcb_##id;
+TAREAS(TAREA_MEMORIA)
+#undef TAREA_MEMORIA
+
+typedef struct {
+    const char *nombre;
+    BaseType_t nucleo;
+    UBaseType_t prioridad;
+    uint32_t bytes;
+    StackType_t *pila;
+    StaticTask_t *tcb;
+} tarea_plan_t;
+
+#if TAREAS_REPARTO_ANTERIOR
+#define TAREA_PLAN(id, nombre_, nucleo_, prio, bytes_, prio_ant) \
+    [id] = { nombre_, tskNO_AFFINITY, prio_ant, bytes_, pila_##id, &tcb_##id },
+#else
+#define TAREA_PLAN(id, nombre_, nucleo_, prio, bytes_, prio_ant) \
+    [id] = { nombre_, nucleo_, prio, bytes_, pila_##id, &tcb_##id },
+#endif
+static const tarea_plan_t plan[TAREA_NUM] = {
+    TAREAS(TAREA_PLAN)
+};
+#undef TAREA_PLAN
+
+static bool creada[TAREA_NUM];
+static TaskHandle_t handles[TAREA_NUM];
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+TaskHandle_t tarea_crear(tarea_id_t id, TaskFunction_t funcion, void *arg) {
+    const tarea_plan_t *t = &plan[id];
+    portENTER_CRITICAL(&lock);
+    bool ya = creada[id];
+    creada[id] = true;
+    portEXIT_CRITICAL(&lock);
+    if (ya) {
+        ESP_LOGE(TAG, "La tarea %s ya existe (su pila es estática)", t->nombre);
+        return NULL;
+    }
+    handles[id] = xTaskCreateStaticPinnedToCore(funcion, t->nombre, t->bytes, arg, t->prioridad,
+                                                t->pila, t->tcb, t->nucleo);
+    return handles[id];
+}
+
+TaskHandle_t tarea_handle(tarea_id_t id) {
+    return handles[id];
+}
+
+const char *tarea_nombre(tarea_id_t id) {
+    return plan[id].nombre;
+}
+
+void tarea_periodo_marcar(tarea_periodo_t *p, int64_t periodo_us) {
+    int64_t ahora = esp_timer_get_time();
+    portENTER_CRITICAL(&lock);
+    if (p->anterior_us != 0) {
+        int64_t desvio = ahora - p->anterior_us - periodo_us;
+        uint32_t us = (uint32_t)(desvio < 0 ? -desvio : desvio);
+        if (us > p->max_us) {
+            p->max_us = us;
+        }
+        p->suma_us += us;
+        p->n++;
+    }
+    p->anterior_us = ahora;
+    portEXIT_CRITICAL(&lock);
+}
+
+void tarea_periodo_leer(const tarea_periodo_t *p, tarea_periodo_t *copia) {
+    portENTER_CRITICAL(&lock);
+    *copia = *p;
+    portEXIT_CRITICAL(&lock);
+}
@@ -0,0 +1,79 @@
+// Reparto de las tareas fijas del firmware entre los dos núcleos, con pila y TCB en
+// memoria estática (xTaskCreateStaticPinnedToCore): nada sale del heap y el tamaño
+// de cada pila está a la vista en una sola tabla.
+//
+// PRO CPU (0): la red. Ahí ya están WiFi (23), esp_timer (22), el bucle de eventos (20)
+//   y, por sdkconfig, lwIP (18) y esp-mqtt (5); httpd (5) se fija en start_webserver.
+//   Las tareas de la aplicación que hablan con la red van por debajo, y la que escribe
+//   el registro en la UART (registro.h) con la prioridad más baja.
+// APP CPU (1): solo la captura del sensor y el control de clima, por encima de todo lo
+//   demás de ese núcleo (la escritura de la OTA, 5), para que su periodo no dependa del
+//   tráfico. Las escrituras en flash (histórico, OTA) sí paran los dos núcleos un momento.
+//
+// Con TAREAS_REPARTO_ANTERIOR 1 (wifi_config.h) las tareas de la tabla y httpd vuelven a
+// crearse sin fijar núcleo y con las prioridades de antes, para comparar la regularidad
+// del periodo del sensor (el registro de task_estado da el desvío del periodo de 10 s).
+// Para que la comparación sea con el reparto de antes entero hay que quitar además de
+// sdkconfig.defaults las tres líneas de "Reparto de tareas" (lwIP y esp-mqtt vuelven a
+// no tener núcleo) y borrar sdkconfig.az-delivery-devkit-v4 para que se regenere.
+// Las pilas siguen siendo estáticas: no cambia cuándo se ejecuta nada, solo de dónde
+// sale la memoria.
+#ifndef TAREAS_H
+#define TAREAS_H
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "wifi_config.h"
+
+#ifndef TAREAS_REPARTO_ANTERIOR
+#define TAREAS_REPARTO_ANTERIOR 0
+#endif
+
+// Núcleo de las tareas de red que no están en la tabla (httpd)
+#if TAREAS_REPARTO_ANTERIOR
+#define TAREAS_NUCLEO_RED tskNO_AFFINITY
+#else
+#define TAREAS_NUCLEO_RED 0
+#endif
+
+// X(id, nombre, núcleo, prioridad, pila en bytes, prioridad del reparto anterior)
+#define TAREAS(X) \
+    X(TAREA_CLIMA,      "clima",      1, 8, 3072, 6) \
+    X(TAREA_SENSOR,     "sensor",     1, 7, 4096, 5) \
+    X(TAREA_PUBLICADOR, "publicador", 0, 4, 4096, 4) \
+    X(TAREA_RED,        "red",        0, 4, 4096, 4) \
+    X(TAREA_WEB_PUSH,   "web_push",   0, 4, 3072, 4) \
+    X(TAREA_HISTORIA,   "historia",   0, 3, 3072, 3) \
+    X(TAREA_ESTADO,     "estado",     0, 1, 2048, 5) \
+    X(TAREA_REGISTRO,   "registro",   0, 1, 3072, 1)
+
+#define TAREA_ENUM(id, ...) id,
+typedef enum {
+    TAREAS(TAREA_ENUM)
+    TAREA_NUM
+} tarea_id_t;
+#undef TAREA_ENUM
+
+// Crear la tarea del plan (una sola vez cada una); NULL si ya existe
+TaskHandle_t tarea_crear(tarea_id_t id, TaskFunction_t funcion, void *arg);
+
+// Handle (NULL si aún no se ha creado) y nombre de una tarea del plan
+TaskHandle_t tarea_handle(tarea_id_t id);
+const char *tarea_nombre(tarea_id_t id);
+
+// Regularidad de una tarea periódica: desvío de cada periodo real respecto al nominal
+typedef struct {
+    int64_t anterior_us;     // Última marca (0 = ninguna)
+    uint32_t n;              // Periodos medidos
+    uint32_t max_us;         // Mayor desvío
+    uint64_t suma_us;        // Suma de desvíos (para la media)
+} tarea_periodo_t;
+
+// Llamar al despertar en cada periodo (desde la propia tarea)
+void tarea_periodo_marcar(tarea_periodo_t *p, int64_t periodo_us);
+
+// Copia coherente (desde cualquier tarea)
+void tarea_periodo_leer(const tarea_periodo_t *p, tarea_periodo_t *copia);
+
+#endif // TAREAS_H
@@ -0,0 +1,61 @@
+#include "telemetria.h"
+#include <stdio.h>
+#include <math.h>
+#include "actuadores.h"
+
+static telemetria_estado_t publicado;
+static bool hay_publicado = false;
+static int64_t ultimo_publicado_us = 0;
+
+bool telemetria_debe_publicar(const telemetria_estado_t *actual, int64_t ahora_us) {
+    if (!hay_publicado) {
+        return true;
+    }
+    if (actual->actuadores != publicado.actuadores ||
+        actual->dht_valido != publicado.dht_valido) {
+        return true;
+    }
+    if (actual->dht_valido &&
+        (fabsf(actual->temperatura - publicado.temperatura) >= TELEMETRIA_DEADBAND_TEMP ||
+         fabsf(actual->humedad - publicado.humedad) >= TELEMETRIA_DEADBAND_HUM)) {
+        return true;
+    }
+    return ahora_us - ultimo_publicado_us >= (int64_t)TELEMETRIA_HEARTBEAT_S * 1000000;
+}
+
+void telemetria_marcar_publicado(const telemetria_estado_t *actual, int64_t ahora_us) {
+    publicado = *actual;
+    hay_publicado = true;
+    ultimo_publicado_us = ahora_us;
+}
+
+// Décimas: la resolución del DHT22 y de lo que se serializa
+static bool decimas_distintas(float a, float b) {
+    return lroundf(a * 10.0f) != lroundf(b * 10.0f);
+}
+
+int telemetria_json_delta(const telemetria_estado_t *antes, const telemetria_estado_t *e, char *buf, size_t len) {
+    int n = snprintf(buf, len, "{");
+    if (e->dht_valido) {
+        bool completo = antes == NULL || !antes->dht_valido;
+        if (completo || decimas_distintas(e->temperatura, antes->temperatura)) {
+            n += snprintf(buf + n, len - n, "%s\"temperatura\":%.1f", n > 1 ? "," : "", e->temperatura);
+        }
+        if (n > 0 && (size_t)n < len && (completo || decimas_distintas(e->humedad, antes->humedad))) {
+            n += snprintf(buf + n, len - n, "%s\"humedad\":%.1f", n > 1 ? "," : "", e->humedad);
+        }
+    }
+    for (int i = 0; i < ACT_NUM && n > 0 && (size_t)n < len; i++) {
+        if (antes != NULL && !((antes->actuadores ^ e->actuadores) & ACT_BIT(i))) continue;
+        n += snprintf(buf + n, len - n, "%s\"%s\":\"%s\"", n > 1 ? "," : "", actuadores[i].id,
+                      (e->actuadores & ACT_BIT(i)) ? "ON" : "OFF");
+    }
+    if (n > 0 && (size_t)n < len) {
+        n += snprintf(buf + n, len - n, "}");
+    }
+    return n;
+}
+
+int telemetria_json(const telemetria_estado_t *e, char *buf, size_t len) {
+    return telemetria_json_delta(NULL, e, buf, len);
+}
@@ -0,0 +1,47 @@
+// Telemetría por cambio: un único documento JSON de estado que solo se publica
+// cuando un valor supera la banda muerta, cambia un actuador o vence el latido.
+#ifndef TELEMETRIA_H
+#define TELEMETRIA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "wifi_config.h"
+
+// Valores por defecto; se pueden redefinir en wifi_config.h
+#ifndef TELEMETRIA_DEADBAND_TEMP
+#define TELEMETRIA_DEADBAND_TEMP 0.2f     // °C
+#endif
+#ifndef TELEMETRIA_DEADBAND_HUM
+#define TELEMETRIA_DEADBAND_HUM 1.0f      // %
+#endif
+#ifndef TELEMETRIA_HEARTBEAT_S
+#define TELEMETRIA_HEARTBEAT_S 300        // Republicar aunque nada cambie
+#endif
+// 1 = publicar también los tópicos antiguos por entidad (.../sensor/temperatura/state, ...)
+#ifndef MQTT_TELEMETRIA_LEGACY
+#define MQTT_TELEMETRIA_LEGACY 0
+#endif
+
+typedef struct {
+    bool dht_valido;
+    float temperatura;
+    float humedad;
+    uint32_t actuadores;     // Máscara ACT_BIT(...) de actuadores encendidos
+} telemetria_estado_t;
+
+// true si el estado debe publicarse: primera vez, cambio de actuador, valor fuera
+// de la banda muerta respecto a lo último publicado o latido vencido
+bool telemetria_debe_publicar(const telemetria_estado_t *actual, int64_t ahora_us);
+
+// Registrar lo publicado como nueva referencia
+void telemetria_marcar_publicado(const telemetria_estado_t *actual, int64_t ahora_us);
+
+// Serializar el documento compacto; devuelve la longitud (como snprintf)
+int telemetria_json(const telemetria_estado_t *e, char *buf, size_t len);
+
+// Solo las claves que cambian respecto a antes (décimas para los sensores); antes
+// NULL = documento completo. Sin cambios devuelve "{}" (longitud 2).
+int telemetria_json_delta(const telemetria_estado_t *antes, const telemetria_estado_t *e, char *buf, size_t len);
+
+#endif // TELEMETRIA_H
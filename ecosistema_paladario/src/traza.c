@@ -0,0 +1,178 @@
+#include "traza.h"
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_freertos_hooks.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "energia.h"
+#include "tareas.h"
+#include "traza_freertos.h"
+
+#define NUCLEOS  portNUM_PROCESSORS
+
+static const char *TAG = "TRAZA";
+
+static traza_uri_t uris[ENERGIA_URIS_MAX];
+static int num_uris = 0;
+
+// Tareas del sistema que no crea tareas.c (nombres de ESP-IDF y esp-mqtt)
+static const char *const tareas_sistema[] = {
+    "wifi", "tiT", "sys_evt", "esp_timer", "mqtt_task", "httpd", "ipc0", "ipc1"
+};
+
+uint16_t traza_uri_alta(const char *uri, httpd_method_t metodo) {
+    if (num_uris == ENERGIA_URIS_MAX) {
+        return 0xFFFF;
+    }
+    traza_uri_t *u = &uris[num_uris];
+    strncpy(u->metodo, http_method_str(metodo), sizeof(u->metodo) - 1);
+    strncpy(u->uri, uri, sizeof(u->uri) - 1);
+    return num_uris++;
+}
+
+#if TRAZA_HABILITADA
+
+_Static_assert((TRAZA_EVENTOS & (TRAZA_EVENTOS - 1)) == 0, "TRAZA_EVENTOS debe ser potencia de 2");
+
+traza_anillo_t traza_anillos[NUCLEOS];
+
+static TaskHandle_t idle[NUCLEOS];
+static TaskHandle_t actual[NUCLEOS];  // Última tarea que entró en cada núcleo
+static uint32_t ticks[NUCLEOS];
+
+void IRAM_ATTR traza_sincronizar(void) {
+    traza(TRAZA_SINCRONIA, esp_rom_get_cpu_ticks_per_us(), (uint32_t)esp_timer_get_time());
+}
+
+// traceTASK_SWITCHED_IN, dentro del cambio de contexto (interrupciones ya enmascaradas).
+// Salir de IDLE es salir de un posible light sleep o de la frecuencia mínima: sincronía.
+void IRAM_ATTR traza_cambio_tarea(void) {
+    int nucleo = xPortGetCoreID();
+    TaskHandle_t t = xTaskGetCurrentTaskHandle();
+    if (actual[nucleo] == idle[nucleo] && t != idle[nucleo]) {
+        traza_sincronizar();
+    }
+    actual[nucleo] = t;
+    traza(TRAZA_TAREA, 0, (uint32_t)t);
+}
+
+static void IRAM_ATTR tick(void) {
+    int nucleo = xPortGetCoreID();
+    if (++ticks[nucleo] >= pdMS_TO_TICKS(TRAZA_SINCRONIA_MS)) {
+        ticks[nucleo] = 0;
+        traza_sincronizar();
+    }
+}
+
+void traza_init(void) {
+    for (int i = 0; i < NUCLEOS; i++) {
+        idle[i] = xTaskGetIdleTaskHandleForCore(i);
+        esp_register_freertos_tick_hook_for_cpu(tick, i);
+    }
+}
+
+static int tarea(traza_tarea_t *t, TaskHandle_t h, const char *nombre) {
+    if (h == NULL) {
+        return 0;
+    }
+    memset(t, 0, sizeof(*t));
+    t->handle = (uint32_t)h;
+    strncpy(t->nombre, nombre, sizeof(t->nombre) - 1);
+    return 1;
+}
+
+// Eventos de un núcleo, en dos tramos del anillo si da la vuelta. Los escritores siguen
+// apuntando mientras se copia: solo valen los que ya estaban completos al empezar
+// (< escritos antes) y que nadie ha podido sobrescribir hasta terminar.
+static esp_err_t enviar_nucleo(httpd_req_t *req, int nucleo, traza_evento_t *copia) {
+    traza_anillo_t *a = &traza_anillos[nucleo];
+    uint32_t antes = __atomic_load_n(&a->escritos, __ATOMIC_ACQUIRE);
+    memcpy(copia, a->eventos, sizeof(a->eventos));
+    uint32_t despues = __atomic_load_n(&a->escritos, __ATOMIC_ACQUIRE);
+    uint32_t desde = despues >= TRAZA_EVENTOS ? despues - TRAZA_EVENTOS + 1 : 0;
+    uint32_t n = antes > desde ? antes - desde : 0;
+    uint32_t i0 = desde & (TRAZA_EVENTOS - 1);
+    uint32_t primero = n < TRAZA_EVENTOS - i0 ? n : TRAZA_EVENTOS - i0;
+
+    // Un trozo vacío cerraría la respuesta
+    esp_err_t err = httpd_resp_send_chunk(req, (const char *)&n, sizeof(n));
+    if (err == ESP_OK && primero > 0) {
+        err = httpd_resp_send_chunk(req, (const char *)&copia[i0], primero * sizeof(traza_evento_t));
+    }
+    if (err == ESP_OK && n > primero) {
+        err = httpd_resp_send_chunk(req, (const char *)copia, (n - primero) * sizeof(traza_evento_t));
+    }
+    return err;
+}
+
+static esp_err_t traza_handler(httpd_req_t *req) {
+    traza_tarea_t tareas[TAREA_NUM + NUCLEOS + sizeof(tareas_sistema) / sizeof(tareas_sistema[0])];
+    int n_tareas = 0;
+    for (int i = 0; i < TAREA_NUM; i++) {
+        n_tareas += tarea(&tareas[n_tareas], tarea_handle(i), tarea_nombre(i));
+    }
+    for (int i = 0; i < NUCLEOS; i++) {
+        n_tareas += tarea(&tareas[n_tareas], idle[i], pcTaskGetName(idle[i]));
+    }
+    for (size_t i = 0; i < sizeof(tareas_sistema) / sizeof(tareas_sistema[0]); i++) {
+        n_tareas += tarea(&tareas[n_tareas], xTaskGetHandle(tareas_sistema[i]), tareas_sistema[i]);
+    }
+
+    traza_evento_t *copia = malloc(sizeof(traza_anillos[0].eventos));
+    if (copia == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Sin memoria");
+        return ESP_FAIL;
+    }
+    traza_cabecera_t cab = {
+        .magic = { 'P', 'T', 'R', '1' },
+        .nucleos = NUCLEOS,
+        .tareas = n_tareas,
+        .uris = num_uris,
+        .eventos = TRAZA_EVENTOS,
+    };
+    httpd_resp_set_type(req, "application/octet-stream");
+    esp_err_t err = httpd_resp_send_chunk(req, (const char *)&cab, sizeof(cab));
+    if (err == ESP_OK && n_tareas > 0) {
+        err = httpd_resp_send_chunk(req, (const char *)tareas, n_tareas * sizeof(traza_tarea_t));
+    }
+    if (err == ESP_OK && num_uris > 0) {
+        err = httpd_resp_send_chunk(req, (const char *)uris, num_uris * sizeof(traza_uri_t));
+    }
+    for (int i = 0; i < NUCLEOS && err == ESP_OK; i++) {
+        err = enviar_nucleo(req, i, copia);
+    }
+    free(copia);
+    if (err == ESP_OK) {
+        err = httpd_resp_send_chunk(req, NULL, 0);
+    }
+    return err;
+}
+
+esp_err_t traza_registrar(httpd_handle_t server) {
+    httpd_uri_t api_traza = {
+        .uri = "/api/traza",
+        .method = HTTP_GET,
+        .handler = traza_handler,
+    };
+    ESP_LOGI(TAG, "%d eventos por núcleo en /api/traza", TRAZA_EVENTOS);
+    return energia_registrar_uri(server, &api_traza);
+}
+
+#else
+
+// El gancho de FreeRTOS sigue compilado (CMakeLists.txt): una llamada vacía
+void IRAM_ATTR traza_cambio_tarea(void) {
+}
+
+void traza_init(void) {
+}
+
+esp_err_t traza_registrar(httpd_handle_t server) {
+    return ESP_OK;
+}
+
+#endif // TRAZA_HABILITADA
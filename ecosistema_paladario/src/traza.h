@@ -0,0 +1,130 @@
+// Traza de eventos en binario para ver qué hacía el sistema cuando algo va mal (la web se
+// queda colgada, falla una lectura del DHT22): cambios de tarea, lecturas del sensor,
+// eventos y publicaciones de MQTT, peticiones web y conmutaciones de los relés.
+//
+// Cada núcleo tiene su propio anillo de TRAZA_EVENTOS registros de 12 bytes con la hora
+// en ciclos de CPU (CCOUNT). Apuntar un evento es enmascarar las interrupciones del
+// propio núcleo, leer CCOUNT y escribir el registro: sin spinlock ni esperas entre
+// núcleos, así que se puede dejar activada siempre. Lo más antiguo se sobrescribe.
+//
+// Los ciclos no son tiempo: con el modo ahorro (energia.h) la frecuencia cambia y en
+// light sleep CCOUNT se para. Por eso cada núcleo apunta también una sincronía (hora de
+// esp_timer y MHz de ese momento) cada TRAZA_SINCRONIA_MS, al salir de la tarea IDLE y al
+// subir la CPU a tope; traza_perfetto.py pasa los ciclos a µs desde la última sincronía.
+//
+// GET /api/traza: "PTR1", traza_cabecera_t, las tareas conocidas (traza_tarea_t), las
+// URIs (traza_uri_t) y, por núcleo, el número de eventos (uint32) y sus traza_evento_t,
+// del más antiguo al más reciente.
+//   python traza_perfetto.py 192.168.1.150 -o traza.json   -> abrir en ui.perfetto.dev
+//
+// Los cambios de tarea los avisa FreeRTOS (traceTASK_SWITCHED_IN, ver traza_freertos.h
+// y CMakeLists.txt). Con TRAZA_HABILITADA 0 en wifi_config.h los traza() desaparecen al
+// compilar y /api/traza no se registra.
+#ifndef TRAZA_H
+#define TRAZA_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "wifi_config.h"
+
+#ifndef TRAZA_HABILITADA
+#define TRAZA_HABILITADA 1
+#endif
+#ifndef TRAZA_EVENTOS
+#define TRAZA_EVENTOS 512             // Por núcleo (potencia de 2): 6 KB cada uno
+#endif
+#ifndef TRAZA_SINCRONIA_MS
+#define TRAZA_SINCRONIA_MS 100
+#endif
+
+// X(id, nombre): qué llevan arg y dato
+#define TRAZA_TIPOS(X) \
+    X(TRAZA_SINCRONIA,   "sincronia")    /* arg: MHz; dato: esp_timer_get_time() (µs, 32 bits bajos) */ \
+    X(TRAZA_TAREA,       "tarea")        /* Entra a ejecutarse; dato: TaskHandle_t */ \
+    X(TRAZA_DHT_INICIO,  "dht_inicio")   /* dht11_read */ \
+    X(TRAZA_DHT_FIN,     "dht_fin")      /* dato: esp_err_t */ \
+    X(TRAZA_MQTT,        "mqtt")         /* Evento de esp-mqtt; arg: esp_mqtt_event_id_t; dato: msg_id */ \
+    X(TRAZA_MQTT_PUBLICA, "mqtt_publica") /* arg: QoS; dato: msg_id (-1 = error) */ \
+    X(TRAZA_HTTP_INICIO, "http_inicio")  /* arg: índice de traza_uri_t */ \
+    X(TRAZA_HTTP_FIN,    "http_fin")     /* arg: índice de traza_uri_t; dato: esp_err_t */ \
+    X(TRAZA_GPIO,        "gpio")         /* arg: GPIO; dato: nivel */
+
+#define TRAZA_TIPO_ENUM(id, nombre) id,
+typedef enum {
+    TRAZA_TIPOS(TRAZA_TIPO_ENUM)
+    TRAZA_TIPO_NUM
+} traza_tipo_t;
+#undef TRAZA_TIPO_ENUM
+
+typedef struct {
+    uint32_t ciclos;         // CCOUNT del núcleo
+    uint32_t dato;
+    uint16_t tipo;           // traza_tipo_t
+    uint16_t arg;
+} traza_evento_t;
+
+typedef struct {
+    char magic[4];           // "PTR1"
+    uint8_t nucleos;
+    uint8_t tareas;          // traza_tarea_t que siguen
+    uint8_t uris;            // traza_uri_t que siguen
+    uint8_t reservado;
+    uint32_t eventos;        // TRAZA_EVENTOS (máximo por núcleo)
+} traza_cabecera_t;
+
+typedef struct {
+    uint32_t handle;
+    char nombre[16];         // configMAX_TASK_NAME_LEN
+} traza_tarea_t;
+
+typedef struct {
+    char metodo[8];
+    char uri[24];
+} traza_uri_t;
+
+#if TRAZA_HABILITADA
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+
+typedef struct {
+    uint32_t escritos;       // Total desde el arranque; el índice es escritos % TRAZA_EVENTOS
+    traza_evento_t eventos[TRAZA_EVENTOS];
+} traza_anillo_t;
+
+extern traza_anillo_t traza_anillos[portNUM_PROCESSORS];
+
+// Apuntar un evento (tareas e interrupciones, cualquier núcleo). Siempre en línea: se
+// llama también desde IRAM con la caché de la flash deshabilitada.
+FORCE_INLINE_ATTR void traza(traza_tipo_t tipo, uint16_t arg, uint32_t dato) {
+    UBaseType_t mascara = portSET_INTERRUPT_MASK_FROM_ISR();
+    traza_anillo_t *a = &traza_anillos[xPortGetCoreID()];
+    uint32_t i = a->escritos;
+    traza_evento_t *e = &a->eventos[i & (TRAZA_EVENTOS - 1)];
+    e->ciclos = esp_cpu_get_cycle_count();
+    e->dato = dato;
+    e->tipo = tipo;
+    e->arg = arg;
+    // El volcado (otro núcleo) solo lee eventos ya completos
+    __atomic_store_n(&a->escritos, i + 1, __ATOMIC_RELEASE);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mascara);
+}
+
+// Sincronía en el núcleo actual (tras cambiar la frecuencia de la CPU)
+void traza_sincronizar(void);
+#else
+#define traza(tipo, arg, dato) ((void)0)
+#define traza_sincronizar() ((void)0)
+#endif
+
+// Sincronías periódicas en cada núcleo
+void traza_init(void);
+
+// Índice para TRAZA_HTTP_* de una URI (al registrarla); 0xFFFF si no caben más
+uint16_t traza_uri_alta(const char *uri, httpd_method_t metodo);
+
+// GET /api/traza
+esp_err_t traza_registrar(httpd_handle_t server);
+
+#endif // TRAZA_H
@@ -0,0 +1,12 @@
+// Se incluye por delante en los fuentes de FreeRTOS (CMakeLists.txt): en cada cambio de
+// contexto, con la tarea nueva ya elegida, apunta un TRAZA_TAREA en la traza (traza.h).
+#ifndef TRAZA_FREERTOS_H
+#define TRAZA_FREERTOS_H
+
+#ifndef __ASSEMBLER__
+void traza_cambio_tarea(void);
+
+#define traceTASK_SWITCHED_IN() traza_cambio_tarea()
+#endif
+
+#endif // TRAZA_FREERTOS_H
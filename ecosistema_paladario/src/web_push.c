@@ -0,0 +1,249 @@
+#include "web_push.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "energia.h"
+#include "tareas.h"
+
+static const char *TAG = "WEB_PUSH";
+
+typedef struct {
+    int fd;                  // -1 = hueco libre
+    bool resync;             // Enviar el estado completo antes que la cola
+    uint8_t cabeza;
+    uint8_t pendientes;
+    int64_t bloqueado_us;    // Desde cuándo el socket no admite más datos (0 = escribible)
+    uint16_t lon[WEB_PUSH_COLA];
+    char cola[WEB_PUSH_COLA][WEB_PUSH_MSG_MAX];
+} cliente_t;
+
+static httpd_handle_t servidor = NULL;
+static TaskHandle_t push_handle = NULL;
+static SemaphoreHandle_t mutex = NULL;
+static cliente_t clientes[WEB_PUSH_MAX_CLIENTES];
+static telemetria_estado_t ultimo;   // Referencia de los deltas y base del estado completo
+static bool hay_ultimo = false;
+
+static void liberar(cliente_t *c) {
+    c->fd = -1;
+    c->pendientes = 0;
+    c->resync = false;
+    c->bloqueado_us = 0;
+}
+
+// Alta tras el handshake. Reutiliza el hueco si el descriptor ya estaba (socket reciclado).
+static bool alta(int fd) {
+    cliente_t *libre = NULL;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (int i = 0; i < WEB_PUSH_MAX_CLIENTES; i++) {
+        cliente_t *c = &clientes[i];
+        if (c->fd >= 0 && c->fd != fd && httpd_ws_get_fd_info(servidor, c->fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+            liberar(c);  // Cerrado sin que la tarea de envío se enterase aún
+        }
+        if (c->fd == fd || (c->fd < 0 && libre == NULL)) {
+            libre = c;
+        }
+    }
+    if (libre != NULL) {
+        liberar(libre);
+        libre->fd = fd;
+        libre->resync = true;  // Lo primero que recibe es el estado completo
+    }
+    xSemaphoreGive(mutex);
+    return libre != NULL;
+}
+
+// El handler se llama una vez tras el handshake (GET) y luego por cada trama recibida
+static esp_err_t ws_handler(httpd_req_t *req) {
+    if (req->method == HTTP_GET) {
+        int fd = httpd_req_to_sockfd(req);
+        if (!alta(fd)) {
+            ESP_LOGW(TAG, "Máximo de %d clientes alcanzado, se rechaza fd %d", WEB_PUSH_MAX_CLIENTES, fd);
+            return ESP_FAIL;  // httpd cierra la sesión
+        }
+        ESP_LOGI(TAG, "Cliente conectado (fd %d)", fd);
+        xTaskNotifyGive(push_handle);
+        return ESP_OK;
+    }
+
+    // El canal es solo de bajada: leer y descartar lo que envíe el navegador
+    uint8_t buf[64];
+    httpd_ws_frame_t frame = {0};
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK || frame.len == 0) {
+        return err;
+    }
+    if (frame.len > sizeof(buf)) {
+        return ESP_FAIL;
+    }
+    frame.payload = buf;
+    return httpd_ws_recv_frame(req, &frame, frame.len);
+}
+
+void web_push_estado(const telemetria_estado_t *e) {
+    if (mutex == NULL) {
+        return;
+    }
+    char delta[WEB_PUSH_MSG_MAX];
+    bool encolado = false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int n = hay_ultimo ? telemetria_json_delta(&ultimo, e, delta, sizeof(delta)) : 0;
+    ultimo = *e;
+    hay_ultimo = true;
+    if (n > 2 && n < (int)sizeof(delta)) {
+        for (int i = 0; i < WEB_PUSH_MAX_CLIENTES; i++) {
+            cliente_t *c = &clientes[i];
+            if (c->fd < 0 || c->resync) {
+                continue;  // Sin cliente, o ya recibirá el estado completo
+            }
+            if (c->pendientes == WEB_PUSH_COLA) {
+                // Cola llena: los deltas se sustituyen por un único estado completo
+                c->pendientes = 0;
+                c->resync = true;
+            } else {
+                int pos = (c->cabeza + c->pendientes) % WEB_PUSH_COLA;
+                memcpy(c->cola[pos], delta, n);
+                c->lon[pos] = n;
+                c->pendientes++;
+            }
+            encolado = true;
+        }
+    }
+    xSemaphoreGive(mutex);
+
+    if (encolado) {
+        xTaskNotifyGive(push_handle);
+    }
+}
+
+// lwIP marca el socket escribible mientras el búfer de envío tiene más de
+// TCP_SNDLOWAT libres, muy por encima de una trama: el envío no se bloquea
+static bool escribible(int fd) {
+    fd_set w;
+    FD_ZERO(&w);
+    FD_SET(fd, &w);
+    struct timeval cero = { 0, 0 };
+    return select(fd + 1, NULL, &w, NULL, &cero) > 0;
+}
+
+// Envía como mucho una trama por cliente y vuelta; true si queda algo pendiente
+static bool vuelta_envio(bool *enviado) {
+    bool quedan = false;
+    char msg[WEB_PUSH_MSG_MAX];
+
+    for (int i = 0; i < WEB_PUSH_MAX_CLIENTES; i++) {
+        cliente_t *c = &clientes[i];
+
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        int fd = c->fd;
+        if (fd < 0 || (!c->resync && c->pendientes == 0)) {
+            xSemaphoreGive(mutex);
+            continue;
+        }
+        if (httpd_ws_get_fd_info(servidor, fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+            ESP_LOGI(TAG, "Cliente desconectado (fd %d)", fd);
+            liberar(c);
+            xSemaphoreGive(mutex);
+            continue;
+        }
+        bool completo = c->resync;
+        int n;
+        if (completo) {
+            n = telemetria_json(&ultimo, msg, sizeof(msg));
+        } else {
+            n = c->lon[c->cabeza];
+            memcpy(msg, c->cola[c->cabeza], n);
+        }
+        xSemaphoreGive(mutex);
+
+        if (!escribible(fd)) {
+            // El cliente no vacía su socket: esperar sin frenar a los demás
+            int64_t ahora = esp_timer_get_time();
+            xSemaphoreTake(mutex, portMAX_DELAY);
+            if (c->fd == fd) {
+                if (c->bloqueado_us == 0) {
+                    c->bloqueado_us = ahora;
+                } else if (ahora - c->bloqueado_us > (int64_t)WEB_PUSH_ESPERA_MS * 1000) {
+                    ESP_LOGW(TAG, "Cliente fd %d bloqueado más de %d ms, se cierra", fd, WEB_PUSH_ESPERA_MS);
+                    liberar(c);
+                    httpd_sess_trigger_close(servidor, fd);
+                    fd = -1;
+                }
+            }
+            xSemaphoreGive(mutex);
+            quedan |= fd >= 0;
+            continue;
+        }
+
+        httpd_ws_frame_t frame = {
+            .type = HTTPD_WS_TYPE_TEXT,
+            .payload = (uint8_t *)msg,
+            .len = n,
+            .final = true,
+        };
+        esp_err_t err = httpd_ws_send_frame_async(servidor, fd, &frame);
+
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        if (c->fd == fd) {
+            if (err != ESP_OK) {
+                ESP_LOGW(TAG, "Error enviando a fd %d: %s", fd, esp_err_to_name(err));
+                liberar(c);
+                httpd_sess_trigger_close(servidor, fd);
+            } else {
+                c->bloqueado_us = 0;
+                if (completo) {
+                    c->resync = false;
+                } else {
+                    c->cabeza = (c->cabeza + 1) % WEB_PUSH_COLA;
+                    c->pendientes--;
+                }
+                *enviado = true;
+                quedan |= c->resync || c->pendientes > 0;
+            }
+        }
+        xSemaphoreGive(mutex);
+    }
+    return quedan;
+}
+
+// Tarea de envío: toda la E/S de WebSocket fuera del publicador y de httpd
+static void task_push(void *pvParameter) {
+    TickType_t espera = portMAX_DELAY;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, espera);
+        bool enviado = false;
+        bool quedan = vuelta_envio(&enviado);
+        // Si se avanzó, otra vuelta enseguida; si todo está bloqueado, reintentar en 100ms
+        espera = !quedan ? portMAX_DELAY : (enviado ? 0 : pdMS_TO_TICKS(100));
+    }
+}
+
+esp_err_t web_push_init(httpd_handle_t server) {
+    if (mutex == NULL) {
+        mutex = xSemaphoreCreateMutex();
+        if (mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        for (int i = 0; i < WEB_PUSH_MAX_CLIENTES; i++) {
+            liberar(&clientes[i]);
+        }
+        push_handle = tarea_crear(TAREA_WEB_PUSH, task_push, NULL);
+        if (push_handle == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    servidor = server;
+
+    httpd_uri_t ws = {
+        .uri = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_handler,
+        .is_websocket = true,
+    };
+    return energia_registrar_uri(server, &ws);
+}
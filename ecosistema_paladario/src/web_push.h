@@ -0,0 +1,22 @@
+// Estado en vivo para la interfaz web por WebSocket (/ws) sobre el servidor httpd.
+// Cada cliente tiene su propia cola acotada de deltas JSON: un navegador lento
+// solo se retrasa a sí mismo y, si se desborda, recibe después el estado completo.
+#ifndef WEB_PUSH_H
+#define WEB_PUSH_H
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "telemetria.h"
+
+#define WEB_PUSH_MAX_CLIENTES 4     // Deja sockets libres para el resto de peticiones
+#define WEB_PUSH_COLA         4     // Deltas pendientes por cliente
+#define WEB_PUSH_MSG_MAX      192
+#define WEB_PUSH_ESPERA_MS    5000  // Cliente sin vaciar su socket durante más tiempo -> se cierra
+
+// Registrar /ws en el servidor y arrancar la tarea de envío
+esp_err_t web_push_init(httpd_handle_t server);
+
+// Nuevo estado: encola para cada cliente solo lo que cambió. No bloquea por la red.
+void web_push_estado(const telemetria_estado_t *e);
+
+#endif // WEB_PUSH_H
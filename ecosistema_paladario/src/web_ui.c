@@ -0,0 +1,133 @@
+// Generado por web/gen_web_ui.py a partir de web/index.html. No editar.
+#include "web_ui.h"
+
+// 4421 bytes sin comprimir
+const uint8_t web_ui_index_gz[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x9d, 0x58, 0xdd, 0x6a, 0x23, 0xc9,
+    0x15, 0xbe, 0x37, 0xf8, 0x1d, 0x6a, 0x3c, 0xbb, 0x94, 0x3a, 0x96, 0x5a, 0x92, 0xe5, 0x71, 0x76,
+    0x5a, 0x6a, 0x0f, 0x5e, 0x8f, 0x9c, 0xdd, 0xb0, 0x63, 0x9b, 0xd8, 0x21, 0x04, 0x63, 0x42, 0xa9,
+    0xab, 0x5a, 0xaa, 0x75, 0xab, 0xab, 0xa9, 0x2a, 0x49, 0xd6, 0x34, 0xba, 0x0b, 0xb9, 0x48, 0x02,
+    0x0b, 0x49, 0x20, 0x97, 0x21, 0x10, 0x02, 0xb9, 0x0b, 0xe4, 0x26, 0x90, 0x8b, 0x40, 0xf6, 0x4d,
+    0xf6, 0x05, 0x92, 0x47, 0xc8, 0xa9, 0xaa, 0xfe, 0x93, 0xec, 0xcd, 0x84, 0x1d, 0x83, 0xdd, 0x5d,
+    0x75, 0xea, 0xfc, 0x9f, 0xef, 0xab, 0x9e, 0xd1, 0x8b, 0xb7, 0x57, 0xe7, 0xb7, 0x3f, 0xbd, 0x1e,
+    0xa3, 0x99, 0x9e, 0x27, 0xa7, 0xa3, 0xe2, 0x37, 0x23, 0xf4, 0x74, 0x7f, 0x6f, 0x34, 0x67, 0x9a,
+    0xa0, 0x68, 0x46, 0xa4, 0x62, 0x3a, 0xc4, 0x3f, 0xbe, 0xbd, 0xe8, 0x7c, 0x82, 0xab, 0xf5, 0x94,
+    0xcc, 0x59, 0x88, 0x97, 0x9c, 0xad, 0x32, 0x21, 0x35, 0x46, 0x91, 0x48, 0x35, 0x4b, 0x41, 0x6e,
+    0xc5, 0xa9, 0x9e, 0x85, 0x94, 0x2d, 0x79, 0xc4, 0x3a, 0xf6, 0xa5, 0x8d, 0x78, 0xca, 0x35, 0x27,
+    0x49, 0x47, 0x45, 0x24, 0x61, 0x61, 0xdf, 0x6a, 0xd1, 0x5c, 0x27, 0xec, 0xf4, 0x9a, 0x24, 0x84,
+    0x12, 0xc9, 0x05, 0x3a, 0x07, 0x05, 0x52, 0x24, 0xa3, 0xae, 0xdb, 0x00, 0x09, 0xa5, 0xd7, 0xf6,
+    0x61, 0x22, 0xe8, 0x3a, 0x8f, 0x61, 0xbb, 0x13, 0x93, 0x39, 0x4f, 0xd6, 0xc1, 0x99, 0x04, 0x65,
+    0xc3, 0x39, 0x91, 0x53, 0x9e, 0x06, 0xbd, 0x61, 0x46, 0x28, 0xe5, 0xe9, 0x34, 0x38, 0xea, 0x65,
+    0x8f, 0xc3, 0x09, 0x89, 0x1e, 0xa6, 0x52, 0x2c, 0x52, 0x1a, 0xbc, 0x8c, 0x7b, 0xe6, 0x67, 0xb3,
+    0xbf, 0xe7, 0x1b, 0xef, 0x08, 0x4f, 0x99, 0xcc, 0xe7, 0xe4, 0xd1, 0x79, 0x15, 0x9c, 0xf4, 0x8c,
+    0x7c, 0xa9, 0x05, 0x91, 0x85, 0x16, 0xcd, 0xd3, 0xab, 0x19, 0xd7, 0x6c, 0x47, 0xb7, 0x90, 0x94,
+    0xc9, 0x8e, 0x24, 0x94, 0x2f, 0x54, 0xd0, 0x77, 0x4b, 0x8f, 0x1d, 0x35, 0x23, 0x54, 0xac, 0x40,
+    0xc5, 0x51, 0xf6, 0x88, 0xcc, 0x2a, 0x92, 0xd3, 0x09, 0x69, 0xf5, 0xda, 0xf6, 0xc7, 0xef, 0x7b,
+    0xe0, 0xc1, 0xac, 0x9f, 0x47, 0x22, 0x11, 0x32, 0x78, 0x39, 0x18, 0x0c, 0x86, 0x9a, 0x3d, 0xea,
+    0x0e, 0x49, 0xf8, 0x34, 0x0d, 0x22, 0x48, 0x1a, 0x93, 0x85, 0x1b, 0x9d, 0x89, 0xd0, 0x5a, 0xcc,
+    0x83, 0x01, 0x28, 0xb1, 0x6e, 0x13, 0x49, 0xf3, 0xad, 0x88, 0x5e, 0x9b, 0x9f, 0xca, 0xab, 0xfe,
+    0xab, 0x3a, 0x02, 0xf3, 0x8c, 0x7a, 0x3b, 0x3e, 0x7e, 0x52, 0x7b, 0x9d, 0xb0, 0x58, 0x07, 0xc7,
+    0x20, 0xa3, 0x44, 0xc2, 0x29, 0x7a, 0x79, 0x7c, 0x7e, 0x76, 0xf1, 0xca, 0x26, 0x47, 0x69, 0xa2,
+    0x17, 0xca, 0x65, 0x58, 0xf1, 0xf7, 0x2c, 0x38, 0x02, 0xb1, 0xa1, 0x7d, 0x5d, 0x31, 0x3e, 0x9d,
+    0xe9, 0x60, 0x22, 0x12, 0x5a, 0xd9, 0x31, 0x01, 0xda, 0x73, 0x22, 0x2d, 0x63, 0xaa, 0x75, 0x89,
+    0x38, 0x2e, 0x17, 0xd9, 0xf7, 0x8f, 0xa3, 0x41, 0x04, 0x8b, 0x93, 0x05, 0x04, 0x95, 0xe6, 0x2e,
+    0xeb, 0xfd, 0x5e, 0xef, 0xe3, 0x6d, 0xff, 0x6b, 0xbb, 0xfd, 0xda, 0xdd, 0x20, 0x15, 0x29, 0xdb,
+    0x09, 0xc6, 0x08, 0x47, 0x0b, 0xa9, 0x40, 0x79, 0x26, 0x78, 0x23, 0x6d, 0x81, 0x0b, 0x5d, 0x4b,
+    0x92, 0x2a, 0x68, 0x34, 0x01, 0xe5, 0xf4, 0x07, 0xaa, 0xb2, 0x1c, 0x50, 0xae, 0xc8, 0x24, 0x61,
+    0x34, 0x17, 0x19, 0x89, 0xb8, 0x5e, 0xc3, 0xf6, 0x89, 0x71, 0x76, 0xa2, 0xd3, 0x0e, 0x38, 0xd6,
+    0x4c, 0xb0, 0x8b, 0x64, 0xe8, 0x42, 0xb0, 0x2d, 0x50, 0x0b, 0x06, 0x33, 0xb1, 0x84, 0x0e, 0xda,
+    0x12, 0x7f, 0x45, 0x7a, 0xc7, 0xaf, 0x2b, 0x11, 0x08, 0xbe, 0xb9, 0xeb, 0x32, 0xf0, 0xac, 0xb2,
+    0x38, 0x7e, 0x46, 0x5b, 0xd4, 0x1b, 0xbc, 0x3e, 0x9a, 0x54, 0x32, 0x9a, 0x6c, 0xed, 0x1e, 0xf5,
+    0x5f, 0x9f, 0x5c, 0x0c, 0x76, 0xb5, 0xf1, 0x34, 0x16, 0xf9, 0xd3, 0x7e, 0x2a, 0x6a, 0x70, 0x72,
+    0x72, 0x52, 0xb6, 0x96, 0x16, 0x99, 0xeb, 0xe2, 0x46, 0xbe, 0x8f, 0x6d, 0x9b, 0x8d, 0xba, 0xe5,
+    0xa4, 0x8d, 0xba, 0x76, 0xf6, 0x47, 0x66, 0xe2, 0xcc, 0x2b, 0xe5, 0x4b, 0x14, 0x25, 0x44, 0xa9,
+    0x10, 0x57, 0x13, 0x64, 0x87, 0x77, 0xd6, 0x3f, 0xfd, 0xcf, 0x1f, 0x7e, 0xfd, 0x4f, 0xf4, 0xcc,
+    0xf8, 0xc2, 0x56, 0x71, 0x92, 0xd3, 0x10, 0x93, 0x48, 0x2f, 0x60, 0x3a, 0x24, 0x53, 0xf8, 0x74,
+    0xd4, 0x85, 0xd5, 0x5d, 0xb5, 0xd0, 0xe1, 0x4e, 0xe3, 0x11, 0x68, 0xfc, 0xed, 0x2f, 0xd1, 0x0d,
+    0x4b, 0x95, 0x11, 0x07, 0x45, 0x47, 0x66, 0x3d, 0x33, 0x86, 0xfe, 0xf8, 0xef, 0xbf, 0x7f, 0x85,
+    0x6e, 0xd9, 0x3c, 0x63, 0x12, 0x5a, 0x55, 0x92, 0x00, 0x01, 0x38, 0x48, 0x91, 0x4e, 0xad, 0x0d,
+    0x5d, 0x6f, 0xe0, 0xd3, 0x4e, 0xc7, 0x84, 0x63, 0xf6, 0xc0, 0x5e, 0x56, 0x6a, 0xf8, 0xcd, 0x9f,
+    0xd1, 0x67, 0x8b, 0x39, 0xa3, 0x84, 0x6e, 0x1f, 0x9d, 0xb9, 0xc5, 0xe7, 0x8e, 0x7d, 0xd0, 0xd9,
+    0xdf, 0xfd, 0x1c, 0x9d, 0x99, 0xe8, 0x12, 0xfe, 0x1e, 0xba, 0xea, 0xeb, 0xbf, 0xa5, 0xe8, 0xea,
+    0xf6, 0xac, 0x74, 0x9b, 0xa7, 0xd9, 0x42, 0x23, 0xbd, 0xce, 0x00, 0x24, 0x63, 0x9e, 0x30, 0x6c,
+    0xcd, 0xc5, 0x5c, 0xce, 0x57, 0x44, 0xc2, 0x1b, 0x89, 0x22, 0x96, 0x01, 0x5a, 0xfa, 0x13, 0x9e,
+    0x62, 0x64, 0xf3, 0x5f, 0x40, 0xe7, 0xce, 0x84, 0x34, 0x30, 0xca, 0x4d, 0x9e, 0x75, 0xc0, 0x35,
+    0x76, 0xe9, 0x57, 0xd1, 0x2d, 0xce, 0x86, 0x5a, 0x4c, 0x38, 0x14, 0x09, 0x92, 0xf9, 0x27, 0x74,
+    0x63, 0x9e, 0xd1, 0x45, 0x61, 0x75, 0xd4, 0x75, 0xc7, 0x6c, 0x52, 0xac, 0xac, 0x39, 0xf4, 0x3f,
+    0xe2, 0x35, 0xbd, 0x85, 0x5d, 0x0a, 0x6f, 0xb8, 0x82, 0x34, 0x13, 0x34, 0xbe, 0xb9, 0x1e, 0x1c,
+    0x35, 0xca, 0xbe, 0xec, 0xfb, 0xbd, 0x2a, 0xcf, 0x23, 0x82, 0x66, 0x92, 0xc5, 0x21, 0x7e, 0x89,
+    0xeb, 0xe2, 0x9b, 0xf4, 0x80, 0x3f, 0xdf, 0xfc, 0xe2, 0x1f, 0x75, 0xba, 0xe4, 0xa8, 0x4b, 0x76,
+    0xed, 0x96, 0x7f, 0x55, 0x24, 0x79, 0xa6, 0xe1, 0xa9, 0xdb, 0x45, 0x5f, 0x10, 0x85, 0x34, 0x91,
+    0x5f, 0x02, 0xe1, 0x28, 0xa4, 0x98, 0x21, 0x19, 0x28, 0xd2, 0x62, 0xcd, 0x52, 0xb4, 0x48, 0x09,
+    0x5a, 0xb2, 0xf7, 0x66, 0x09, 0x75, 0x49, 0xc6, 0xbb, 0x75, 0xa7, 0x0d, 0x11, 0x65, 0x2a, 0x5b,
+    0x7c, 0xfd, 0x17, 0x65, 0xb0, 0x4e, 0x98, 0x83, 0x19, 0xc0, 0x05, 0x71, 0x72, 0x06, 0xed, 0xd8,
+    0xfe, 0xde, 0x92, 0x48, 0xf4, 0x51, 0x18, 0x2f, 0xd2, 0xc8, 0x00, 0x46, 0x8b, 0x53, 0x2f, 0x97,
+    0x0c, 0x5a, 0x28, 0x45, 0x54, 0x44, 0xd0, 0x15, 0xa9, 0xf6, 0xa7, 0x4c, 0x8f, 0x13, 0x66, 0x1e,
+    0x3f, 0x5d, 0x7f, 0x4e, 0x8d, 0xc8, 0xa6, 0x6d, 0xb8, 0x2f, 0xbc, 0xbb, 0x6f, 0x2b, 0x1d, 0xe6,
+    0x9b, 0xa1, 0x75, 0xf2, 0x1d, 0x7b, 0x0f, 0xf9, 0x42, 0x2c, 0xa9, 0x4e, 0x0a, 0xd4, 0x8a, 0xc4,
+    0x3c, 0x4b, 0x18, 0x3c, 0x09, 0x70, 0x26, 0xd1, 0xc4, 0x43, 0xe0, 0x33, 0x88, 0x30, 0x30, 0x4f,
+    0x05, 0x4a, 0x04, 0x30, 0x21, 0x5a, 0x23, 0xc9, 0xac, 0x67, 0xfb, 0x7b, 0xa5, 0x23, 0xce, 0x53,
+    0xd9, 0x02, 0x77, 0xf6, 0xf7, 0x10, 0x8a, 0x85, 0x6c, 0x19, 0x4f, 0x1f, 0x80, 0x42, 0x11, 0xf5,
+    0x94, 0xbe, 0x7b, 0xb8, 0x0f, 0x29, 0xfc, 0x1a, 0x9a, 0x5d, 0xb3, 0xa3, 0x42, 0xa5, 0xed, 0x8b,
+    0xf1, 0xcc, 0x07, 0xf9, 0x31, 0x89, 0x66, 0xad, 0x2a, 0x2e, 0xe2, 0xf4, 0x38, 0x59, 0x91, 0x86,
+    0xea, 0x8e, 0xf8, 0x9c, 0xde, 0x87, 0x61, 0x88, 0xaf, 0x2e, 0x71, 0x9b, 0x85, 0x1f, 0xb5, 0xb0,
+    0xd2, 0x3f, 0xc3, 0x87, 0x66, 0xd9, 0x1b, 0x3a, 0x59, 0xe6, 0xdb, 0x06, 0xb8, 0xb4, 0x14, 0xef,
+    0xd8, 0x01, 0xe1, 0xc3, 0x96, 0x48, 0xdf, 0x60, 0x91, 0xe2, 0x00, 0x03, 0x7a, 0xe1, 0x5a, 0xd6,
+    0x80, 0xcf, 0x79, 0xc1, 0xfe, 0x20, 0xd2, 0x02, 0x2f, 0xde, 0xe0, 0x6f, 0x7e, 0xff, 0x15, 0x1a,
+    0x5f, 0x9e, 0x8f, 0x2f, 0xdf, 0x7e, 0xfe, 0xf6, 0x0c, 0x8e, 0x34, 0xdf, 0xaf, 0xb0, 0x17, 0x94,
+    0x52, 0xbf, 0x42, 0x67, 0xd7, 0x67, 0x3f, 0x38, 0x2b, 0x64, 0xca, 0xb7, 0xab, 0x42, 0xfd, 0xc6,
+    0xfd, 0x01, 0x1f, 0x9b, 0x33, 0xee, 0x6d, 0x99, 0x54, 0x7e, 0x63, 0xef, 0x45, 0x18, 0x02, 0x56,
+    0xb2, 0x18, 0x80, 0x8a, 0xbe, 0xd9, 0xda, 0xf1, 0xb5, 0xb8, 0xe0, 0x8f, 0x8c, 0xb6, 0xfa, 0xde,
+    0x21, 0xfe, 0xd7, 0x5f, 0xcf, 0xc1, 0x5e, 0xa7, 0x83, 0x4b, 0xf5, 0x25, 0x0e, 0xec, 0xaa, 0x2e,
+    0xd6, 0x77, 0xd4, 0x16, 0xab, 0x5b, 0x2a, 0x3f, 0xae, 0x14, 0x6e, 0x9a, 0xd5, 0x64, 0x94, 0xcb,
+    0xd6, 0x42, 0x26, 0x6d, 0x91, 0x69, 0xe5, 0x6a, 0x51, 0xb4, 0x59, 0xcc, 0x34, 0x14, 0xaa, 0xda,
+    0xf2, 0xf5, 0x8c, 0xa5, 0x75, 0xdd, 0xa4, 0x97, 0xf3, 0xb8, 0xf5, 0x42, 0xfa, 0xe2, 0xc1, 0xd3,
+    0x33, 0x29, 0x56, 0x48, 0x16, 0x3c, 0x3d, 0x2c, 0xce, 0x4b, 0xff, 0x4b, 0x05, 0x82, 0x9e, 0xcd,
+    0x51, 0xd3, 0xa6, 0x6b, 0xb1, 0x96, 0x97, 0x3b, 0xe3, 0xb8, 0xee, 0x7a, 0x5c, 0x58, 0x71, 0x3d,
+    0xe6, 0xc1, 0xf5, 0x42, 0x37, 0x7b, 0xc5, 0xcb, 0x37, 0x5e, 0x53, 0xd1, 0x9c, 0xa4, 0x30, 0xe4,
+    0xd0, 0xf7, 0x6d, 0x91, 0xb6, 0x01, 0x63, 0x0a, 0xff, 0xcd, 0xd3, 0xd3, 0x46, 0x9b, 0x78, 0xf9,
+    0xc4, 0x2f, 0x89, 0x36, 0x84, 0x21, 0x65, 0x45, 0xf1, 0x9a, 0x5e, 0xd8, 0x19, 0xd5, 0x42, 0xe2,
+    0x76, 0x0e, 0xed, 0x3a, 0x13, 0x34, 0xc0, 0xd7, 0x57, 0x37, 0xb7, 0xb8, 0x6d, 0x68, 0x87, 0x49,
+    0x15, 0xe4, 0xb8, 0xc8, 0x7d, 0xe7, 0x16, 0xa0, 0x13, 0x52, 0x4a, 0xb2, 0x2c, 0xe1, 0xe0, 0x27,
+    0x98, 0xe8, 0x9a, 0x78, 0xf1, 0xa6, 0xed, 0xfa, 0xce, 0xfc, 0x33, 0x34, 0x15, 0xfc, 0xf0, 0xe6,
+    0xea, 0x12, 0x52, 0x23, 0x01, 0x2d, 0x79, 0xbc, 0x6e, 0xe5, 0x9c, 0x06, 0xd6, 0xe3, 0x40, 0xa4,
+    0x10, 0x8e, 0xe7, 0xa4, 0x3f, 0x18, 0x77, 0x53, 0xac, 0xb1, 0xf1, 0xff, 0xc4, 0x1a, 0x93, 0x44,
+    0xb1, 0x4d, 0x55, 0x87, 0x27, 0xf1, 0x3a, 0xf6, 0xdb, 0x2d, 0xf0, 0xdc, 0x25, 0xd3, 0xe2, 0xc9,
+    0xbc, 0x9a, 0xe6, 0xc8, 0xcc, 0x63, 0xf3, 0x94, 0x1b, 0xed, 0x0f, 0xcc, 0x35, 0x0d, 0x2b, 0xcc,
+    0x8a, 0x24, 0x83, 0x42, 0x17, 0xb0, 0xd5, 0xc2, 0x80, 0xa9, 0xd5, 0xa4, 0xd2, 0xe6, 0x54, 0x5b,
+    0x2a, 0xab, 0x36, 0x78, 0x0a, 0xc4, 0xfe, 0xd9, 0xed, 0xbb, 0x2f, 0x42, 0x6c, 0xb8, 0xcd, 0x92,
+    0x58, 0x83, 0x08, 0x0e, 0x0a, 0x0c, 0x80, 0xb9, 0x3f, 0x30, 0xc0, 0x7e, 0x50, 0x21, 0xc6, 0x21,
+    0x3e, 0x28, 0x68, 0x1d, 0x1f, 0x96, 0x75, 0xc1, 0xdb, 0xec, 0x74, 0xe0, 0x2e, 0x4f, 0x07, 0xa7,
+    0x6e, 0xfc, 0xc7, 0x3f, 0xaa, 0x68, 0xe8, 0x39, 0x39, 0xb0, 0x70, 0x6a, 0x31, 0xa0, 0x16, 0xab,
+    0xdd, 0x04, 0xfa, 0x54, 0xfa, 0x7c, 0xc6, 0x13, 0xba, 0x35, 0xa6, 0x30, 0xdb, 0xc3, 0x3a, 0x19,
+    0x93, 0x90, 0x36, 0x90, 0x5b, 0x7d, 0xba, 0xbe, 0x25, 0x53, 0x13, 0x73, 0x0b, 0x3b, 0x7d, 0x55,
+    0x3e, 0xac, 0x30, 0xd4, 0x37, 0xbc, 0x9b, 0xdc, 0xf5, 0xee, 0xdb, 0x93, 0xbb, 0xfe, 0xfd, 0x7d,
+    0xb1, 0x65, 0x16, 0xe0, 0x7a, 0x1b, 0x41, 0xeb, 0x3d, 0x84, 0x8d, 0x76, 0x28, 0x26, 0xc2, 0x44,
+    0xde, 0x36, 0x2d, 0xee, 0xa6, 0x62, 0x53, 0x9d, 0xea, 0x7f, 0xf0, 0x94, 0x6d, 0x96, 0xed, 0x63,
+    0x91, 0x0f, 0x4d, 0xce, 0x52, 0x6a, 0x03, 0x6b, 0xd1, 0x2d, 0xe4, 0x2b, 0x67, 0xd9, 0xbe, 0x00,
+    0xd5, 0xb1, 0xc8, 0x90, 0x83, 0xed, 0x34, 0xcf, 0xb1, 0xcf, 0xd8, 0x11, 0x0a, 0xb0, 0xcb, 0x92,
+    0x2f, 0x45, 0x60, 0x38, 0x46, 0x31, 0xb9, 0xe4, 0xd0, 0x3f, 0x6e, 0x80, 0x1b, 0xac, 0x53, 0x91,
+    0x12, 0x70, 0x4f, 0xa9, 0x0c, 0x48, 0x28, 0x59, 0xb0, 0xa9, 0x70, 0x54, 0x69, 0xb9, 0x4a, 0x39,
+    0x76, 0x94, 0x8c, 0xdb, 0xfc, 0x8a, 0x10, 0x6e, 0x24, 0xbd, 0x61, 0x03, 0x18, 0x6a, 0x47, 0xf2,
+    0xb2, 0x71, 0x57, 0x2a, 0x4c, 0xd9, 0x0a, 0xfd, 0x84, 0x4d, 0x6e, 0x44, 0xf4, 0xc0, 0xa0, 0xf5,
+    0x56, 0x2a, 0xe8, 0x76, 0xf1, 0xa1, 0x61, 0x3a, 0x73, 0xc8, 0x9f, 0x09, 0xa5, 0x0f, 0x71, 0x77,
+    0x55, 0x36, 0xf5, 0x4a, 0x41, 0xae, 0x04, 0x04, 0xde, 0x4c, 0xd5, 0xb6, 0xcd, 0x4d, 0x2d, 0x38,
+    0x67, 0x4a, 0x91, 0x29, 0xab, 0x65, 0xd9, 0xd2, 0xcb, 0xb5, 0x5c, 0xe7, 0x05, 0x5f, 0x5a, 0x14,
+    0xc8, 0xcc, 0xa7, 0x2a, 0xec, 0xf8, 0x94, 0x00, 0xe3, 0x7a, 0x1b, 0x37, 0xe7, 0x0c, 0xe6, 0xbb,
+    0xa1, 0x29, 0x4a, 0x84, 0x62, 0x4d, 0x9b, 0xae, 0x0a, 0xf0, 0x8d, 0x7b, 0xcb, 0xe7, 0x4c, 0x2c,
+    0x74, 0xab, 0x0c, 0xaf, 0x5d, 0x79, 0x53, 0xb6, 0x4c, 0xed, 0xde, 0x3b, 0xa2, 0x67, 0xfe, 0x9c,
+    0x03, 0x50, 0x97, 0x4b, 0xdf, 0x3b, 0x6a, 0x0f, 0xc0, 0xe7, 0x5e, 0x51, 0x3f, 0x07, 0x06, 0xe5,
+    0x34, 0xbb, 0x4b, 0x90, 0xf7, 0xb4, 0x3b, 0x4c, 0x18, 0xe0, 0x70, 0x26, 0xd9, 0x12, 0x94, 0xbc,
+    0x65, 0x31, 0x59, 0x24, 0x1a, 0x0a, 0x5c, 0x16, 0xde, 0xe8, 0x31, 0x14, 0x6d, 0x2f, 0x75, 0xde,
+    0x73, 0xdd, 0x55, 0x56, 0x20, 0x36, 0xd0, 0x51, 0x5d, 0x30, 0x3d, 0xdf, 0xdc, 0x3a, 0x15, 0xf4,
+    0xb1, 0x75, 0xc7, 0x70, 0x49, 0xec, 0x39, 0xe6, 0x28, 0x39, 0xcf, 0x5c, 0xfe, 0xb6, 0xf9, 0x0e,
+    0x9b, 0xfb, 0x22, 0x74, 0xa2, 0x00, 0xb6, 0x8f, 0x7d, 0xf3, 0x85, 0x7f, 0x88, 0x7d, 0xdf, 0x77,
+    0x03, 0xe8, 0xf8, 0x0a, 0x77, 0x17, 0x19, 0x35, 0x54, 0xf2, 0x9d, 0x10, 0x5c, 0x44, 0x9a, 0xc1,
+    0xb7, 0x87, 0x06, 0x90, 0x9a, 0x03, 0x92, 0x5b, 0xfc, 0x8e, 0xbf, 0x05, 0x7c, 0x65, 0x75, 0x21,
+    0x93, 0xd6, 0xc9, 0x96, 0xf7, 0x2d, 0x82, 0xda, 0xcb, 0x9f, 0x8d, 0x46, 0x57, 0xf2, 0x4f, 0xf0,
+    0xfe, 0xf9, 0xe8, 0xc7, 0x52, 0xc2, 0xd0, 0x50, 0x7b, 0xcd, 0x64, 0x8f, 0xe6, 0x46, 0x8f, 0x1d,
+    0xa8, 0x0f, 0xed, 0x37, 0x52, 0x79, 0x2f, 0x05, 0x60, 0x32, 0x9f, 0x47, 0x00, 0x92, 0xe6, 0x7f,
+    0x4b, 0xf6, 0xf7, 0xfe, 0x0b, 0x2f, 0x4e, 0x31, 0xdd, 0x45, 0x11, 0x00, 0x00,
+};
+const size_t web_ui_index_gz_len = sizeof(web_ui_index_gz);
+const char web_ui_etag[] = "\"c3e6a5b0d1e58ddf\"";
@@ -0,0 +1,12 @@
+// Interfaz web embebida: web/index.html comprimido con gzip (ver web/gen_web_ui.py)
+#ifndef WEB_UI_H
+#define WEB_UI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+extern const uint8_t web_ui_index_gz[];
+extern const size_t web_ui_index_gz_len;
+extern const char web_ui_etag[];   // Con comillas, listo para la cabecera ETag
+
+#endif // WEB_UI_H
@@ -0,0 +1,151 @@
+#include "wifi_conexion.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+static const char *TAG = "WIFI";
+
+// Último punto de acceso con el que hubo asociación (en NVS, "wifi"/"ap")
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t canal;           // 0 = ninguno guardado
+} ap_guardado_t;
+
+// Solo la tarea de eventos
+static wifi_config_t config;
+static ap_guardado_t ap;
+static bool con_canal = false;   // La configuración aplicada apunta al AP guardado
+static bool con_ip = false;
+static uint32_t fallos = 0;      // Intentos fallidos seguidos
+static int64_t caida_us = 0;     // Desde cuándo no hay IP
+static esp_timer_handle_t reintento;
+
+static wifi_metricas_t metricas;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void apuntar(wifi_config_t *cfg, bool usar_canal) {
+    if (usar_canal) {
+        cfg->sta.bssid_set = true;
+        memcpy(cfg->sta.bssid, ap.bssid, sizeof(ap.bssid));
+        cfg->sta.channel = ap.canal;
+        cfg->sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        cfg->sta.bssid_set = false;
+        cfg->sta.channel = 0;
+        cfg->sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    }
+    con_canal = usar_canal;
+}
+
+static void conectar(void *arg) {
+    esp_wifi_connect();
+}
+
+void wifi_conexion_init(wifi_config_t *cfg) {
+    nvs_handle_t h;
+    if (nvs_open("wifi", NVS_READONLY, &h) == ESP_OK) {
+        size_t len = sizeof(ap);
+        if (nvs_get_blob(h, "ap", &ap, &len) != ESP_OK || len != sizeof(ap)) {
+            memset(&ap, 0, sizeof(ap));
+        }
+        nvs_close(h);
+    }
+    apuntar(cfg, ap.canal != 0);
+    config = *cfg;
+
+    esp_timer_create_args_t args = {
+        .callback = conectar,
+        .name = "wifi_reintento",
+    };
+    esp_timer_create(&args, &reintento);
+    caida_us = esp_timer_get_time();
+    if (ap.canal) {
+        ESP_LOGI(TAG, "Conexión rápida a " MACSTR " en el canal %u", MAC2STR(ap.bssid), ap.canal);
+    }
+}
+
+void wifi_conexion_iniciada(void) {
+    esp_wifi_connect();
+}
+
+void wifi_conexion_asociada(const wifi_event_sta_connected_t *ev) {
+    if (con_canal) {
+        portENTER_CRITICAL(&lock);
+        metricas.rapidas++;
+        portEXIT_CRITICAL(&lock);
+    }
+    if (ev->channel == ap.canal && memcmp(ev->bssid, ap.bssid, sizeof(ap.bssid)) == 0) {
+        return;
+    }
+    memcpy(ap.bssid, ev->bssid, sizeof(ap.bssid));
+    ap.canal = ev->channel;
+    nvs_handle_t h;
+    if (nvs_open("wifi", NVS_READWRITE, &h) == ESP_OK) {
+        nvs_set_blob(h, "ap", &ap, sizeof(ap));
+        nvs_commit(h);
+        nvs_close(h);
+    }
+    ESP_LOGI(TAG, "Punto de acceso nuevo: " MACSTR " en el canal %u", MAC2STR(ap.bssid), ap.canal);
+}
+
+void wifi_conexion_perdida(const wifi_event_sta_disconnected_t *ev) {
+    if (con_ip) {
+        con_ip = false;
+        caida_us = esp_timer_get_time();
+        portENTER_CRITICAL(&lock);
+        metricas.caidas++;
+        portEXIT_CRITICAL(&lock);
+    } else {
+        fallos++;
+        portENTER_CRITICAL(&lock);
+        metricas.intentos++;
+        portEXIT_CRITICAL(&lock);
+    }
+
+    // Canal guardado salvo uno de cada WIFI_ESCANEO_CADA intentos (por si el router ha cambiado)
+    bool usar_canal = ap.canal != 0 && (fallos % WIFI_ESCANEO_CADA) != WIFI_ESCANEO_CADA - 1;
+    if (usar_canal != con_canal) {
+        apuntar(&config, usar_canal);
+        esp_wifi_set_config(WIFI_IF_STA, &config);
+    }
+
+    // Primer reintento inmediato; después espera exponencial con azar ("equal jitter")
+    if (fallos == 0) {
+        ESP_LOGI(TAG, "Desconectado (motivo %u), reintentando...", ev->reason);
+        esp_wifi_connect();
+        return;
+    }
+    uint32_t espera = fallos > 16 ? WIFI_ESPERA_MAX_MS : (uint32_t)WIFI_ESPERA_MIN_MS << (fallos - 1);
+    if (espera > WIFI_ESPERA_MAX_MS) {
+        espera = WIFI_ESPERA_MAX_MS;
+    }
+    espera = espera / 2 + esp_random() % (espera / 2 + 1);
+    ESP_LOGI(TAG, "Intento %lu fallido (motivo %u, %s), siguiente en %lu ms", (unsigned long)fallos,
+             ev->reason, con_canal ? "canal guardado" : "barrido", (unsigned long)espera);
+    esp_timer_stop(reintento);
+    esp_timer_start_once(reintento, espera * 1000ULL);
+}
+
+void wifi_conexion_ip(void) {
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - caida_us) / 1000);
+    portENTER_CRITICAL(&lock);
+    metricas.conexiones++;
+    metricas.ultima_ms = ms;
+    if (ms > metricas.max_ms) {
+        metricas.max_ms = ms;
+    }
+    portEXIT_CRITICAL(&lock);
+    ESP_LOGI(TAG, "Con IP en %lu ms (%lu intentos fallidos)", (unsigned long)ms, (unsigned long)fallos);
+    fallos = 0;
+    con_ip = true;
+}
+
+void wifi_conexion_metricas(wifi_metricas_t *m) {
+    portENTER_CRITICAL(&lock);
+    *m = metricas;
+    portEXIT_CRITICAL(&lock);
+}
@@ -0,0 +1,51 @@
+// Conexión WiFi rápida y reconexión con espera exponencial.
+// El BSSID y el canal del último punto de acceso con el que se conectó se guardan en NVS:
+// al arrancar (y tras un corte) se conecta directamente a ese canal, sin barrer los 13.
+// Si el router cambia de canal, cada WIFI_ESCANEO_CADA intentos se hace un barrido
+// completo, y al asociarse se guarda el punto de acceso nuevo. La IP es fija (main.c),
+// así que tampoco hay que esperar a DHCP.
+// Tras cada desconexión el siguiente intento espera 0, WIFI_ESPERA_MIN_MS, el doble...
+// hasta WIFI_ESPERA_MAX_MS, con un azar de hasta la mitad para no saturar al router
+// cuando vuelve (ni sincronizarse con otros equipos que también reintentan).
+// Todo se llama desde el manejador de eventos WiFi de main.c.
+#ifndef WIFI_CONEXION_H
+#define WIFI_CONEXION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_wifi.h"
+#include "wifi_config.h"
+
+// Valores por defecto; se pueden redefinir en wifi_config.h
+#ifndef WIFI_ESPERA_MIN_MS
+#define WIFI_ESPERA_MIN_MS 250        // Espera tras el segundo fallo seguido
+#endif
+#ifndef WIFI_ESPERA_MAX_MS
+#define WIFI_ESPERA_MAX_MS 4000       // Tope: un router que vuelve se encuentra en 1-2 s de media
+#endif
+#ifndef WIFI_ESCANEO_CADA
+#define WIFI_ESCANEO_CADA 4           // Cada N intentos fallidos, barrido completo de canales
+#endif
+
+typedef struct {
+    uint32_t conexiones;         // Veces que se ha obtenido IP
+    uint32_t caidas;             // Desconexiones tras haber tenido IP
+    uint32_t intentos;           // Intentos de conexión fallidos en total
+    uint32_t rapidas;            // Conexiones con el canal guardado (sin barrido)
+    uint32_t ultima_ms;          // De la caída (o el arranque) a tener IP, la última vez
+    uint32_t max_ms;             // El peor caso
+} wifi_metricas_t;
+
+// Completar la configuración STA con el punto de acceso guardado (NVS ya inicializada,
+// antes de esp_wifi_set_config)
+void wifi_conexion_init(wifi_config_t *cfg);
+
+// Eventos del manejador de main.c
+void wifi_conexion_iniciada(void);                                      // WIFI_EVENT_STA_START
+void wifi_conexion_asociada(const wifi_event_sta_connected_t *ev);      // WIFI_EVENT_STA_CONNECTED
+void wifi_conexion_perdida(const wifi_event_sta_disconnected_t *ev);    // WIFI_EVENT_STA_DISCONNECTED
+void wifi_conexion_ip(void);                                            // IP_EVENT_STA_GOT_IP
+
+void wifi_conexion_metricas(wifi_metricas_t *m);
+
+#endif // WIFI_CONEXION_H
@@ -21,4 +21,29 @@
 #define MQTT_BASE_TOPIC "paladario"
 #define MQTT_DISCOVERY_PREFIX "homeassistant"
 
+// Telemetría (opcional, valores por defecto en telemetria.h)
+// #define TELEMETRIA_DEADBAND_TEMP 0.2f   // °C de cambio para republicar
+// #define TELEMETRIA_DEADBAND_HUM 1.0f    // % de cambio para republicar
+// #define TELEMETRIA_HEARTBEAT_S 300      // Latido: republicar cada N segundos
+// #define MQTT_TELEMETRIA_LEGACY 1        // Publicar también los tópicos por entidad
+
+// Control de clima (opcional, valores por defecto en control_clima.h)
+// #define CLIMA_TEMP_OBJETIVO 24.0f       // °C, consigna de la calefacción
+// #define CLIMA_TEMP_MAX 28.0f            // °C, por encima se ventila
+// #define CLIMA_HUM_MAX 90.0f             // %, por encima se ventila
+// #define CLIMA_VENTANA_S 120             // Ventana de tiempo proporcional de la calefacción
+// #define CLIMA_MIN_ON_S 20               // Tiempos mínimos de los relés
+// #define CLIMA_MIN_OFF_S 20
+// #define CLIMA_OVERRIDE_S 3600           // Una orden manual dura esto antes de volver al automático
+
+// Riego (opcional, valores por defecto en riego.h; los límites se cambian también por /api/riego)
+// #define RIEGO_ZONA_HORARIA "CET-1CEST,M3.5.0,M10.5.0/3"   // POSIX TZ de las ventanas
+// #define RIEGO_NTP_SERVIDOR "pool.ntp.org"
+// #define RIEGO_LLUVIA_MAX_S 60           // Límites iniciales (sin configuración en NVS)
+// #define RIEGO_LLUVIA_ENFRIAMIENTO_S 300
+// #define RIEGO_LLUVIA_CICLO_PCT 10
+// #define RIEGO_CASCADA_MAX_S 1800
+// #define RIEGO_CASCADA_ENFRIAMIENTO_S 300
+// #define RIEGO_CASCADA_CICLO_PCT 75
+
 #endif // WIFI_CONFIG_H
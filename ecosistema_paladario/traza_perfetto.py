@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""Convierte la traza de eventos del Paladario (GET /api/traza, formato de src/traza.h)
+a JSON de Chrome/Perfetto: abrir el resultado en https://ui.perfetto.dev o chrome://tracing.
+
+Pistas: "CPU" con qué tarea ocupa cada núcleo, "Tareas" con las lecturas del DHT22 y las
+peticiones web como intervalos (y los eventos de MQTT y los GPIO como marcas) en la tarea
+que los apuntó, y un contador por GPIO de relé.
+
+Los ciclos de cada núcleo se pasan a µs desde la última sincronía de ese núcleo (hora de
+esp_timer y MHz del momento), así que el eje es el tiempo desde el arranque del ESP32.
+
+    python traza_perfetto.py 192.168.1.150 [-o traza.json] [--guardar traza.bin]
+    python traza_perfetto.py -f traza.bin [-o traza.json]
+"""
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = b'PTR1'
+CABECERA = struct.Struct('<4sBBBBI')
+TAREA = struct.Struct('<I16s')
+URI = struct.Struct('<8s24s')
+EVENTO = struct.Struct('<IIHH')
+
+# traza_tipo_t, en el orden de TRAZA_TIPOS
+(SINCRONIA, TAREA_ENTRA, DHT_INICIO, DHT_FIN, MQTT, MQTT_PUBLICA,
+ HTTP_INICIO, HTTP_FIN, GPIO) = range(9)
+
+# esp_mqtt_event_id_t
+EVENTOS_MQTT = {0: 'error', 1: 'conectado', 2: 'desconectado', 3: 'suscrito',
+                4: 'desuscrito', 5: 'publicado', 6: 'datos', 7: 'antes_de_conectar',
+                8: 'borrado'}
+
+PID_CPU = 1
+PID_TAREAS = 2
+
+
+def _texto(b):
+    return b.split(b'\0', 1)[0].decode('utf-8', 'replace')
+
+
+def _con_signo(v):
+    return v - (1 << 32) if v & 0x80000000 else v
+
+
+def leer(datos):
+    """Cabecera, tareas {handle: nombre}, URIs y la lista de eventos de cada núcleo"""
+    magic, nucleos, n_tareas, n_uris, _, _ = CABECERA.unpack_from(datos, 0)
+    if magic != MAGIC:
+        raise ValueError('No es una traza del Paladario (falta "PTR1")')
+    p = CABECERA.size
+    tareas = {}
+    for _ in range(n_tareas):
+        handle, nombre = TAREA.unpack_from(datos, p)
+        tareas[handle] = _texto(nombre)
+        p += TAREA.size
+    uris = []
+    for _ in range(n_uris):
+        metodo, uri = URI.unpack_from(datos, p)
+        uris.append(f'{_texto(metodo)} {_texto(uri)}')
+        p += URI.size
+    eventos = []
+    for _ in range(nucleos):
+        (n,) = struct.unpack_from('<I', datos, p)
+        p += 4
+        eventos.append([EVENTO.unpack_from(datos, p + i * EVENTO.size) for i in range(n)])
+        p += n * EVENTO.size
+    return tareas, uris, eventos
+
+
+def tiempos(eventos):
+    """µs de cada evento de un núcleo. CCOUNT (32 bits) da la vuelta en ~18 s a 240 MHz;
+    entre sincronías hay como mucho TRAZA_SINCRONIA_MS de CPU despierta."""
+    ciclos = []
+    total = 0
+    anterior = None
+    for c, _, _, _ in eventos:
+        if anterior is not None:
+            total += (c - anterior) & 0xFFFFFFFF
+        anterior = c
+        ciclos.append(total)
+
+    sincronias = [(i, dato, arg) for i, (_, dato, tipo, arg) in enumerate(eventos) if tipo == SINCRONIA]
+    if not sincronias:
+        return None
+    # Lo anterior a la primera sincronía se cuenta hacia atrás desde ella
+    i, us, mhz = sincronias[0]
+    ancla = (ciclos[i], us, mhz)
+    us_total = us
+    us_anterior = us
+    siguiente = 0
+    resultado = []
+    for i in range(len(eventos)):
+        if siguiente < len(sincronias) and sincronias[siguiente][0] == i:
+            _, us, mhz = sincronias[siguiente]
+            us_total += (us - us_anterior) & 0xFFFFFFFF
+            us_anterior = us
+            ancla = (ciclos[i], us_total, mhz or 1)
+            siguiente += 1
+        c0, us0, f = ancla
+        resultado.append(us0 + (ciclos[i] - c0) / f)
+    return resultado
+
+
+def convertir(tareas, uris, eventos):
+    salida = []
+
+    def meta(pid, tid, nombre):
+        salida.append({'ph': 'M', 'name': 'thread_name', 'pid': pid, 'tid': tid, 'args': {'name': nombre}})
+
+    salida.append({'ph': 'M', 'name': 'process_name', 'pid': PID_CPU, 'args': {'name': 'CPU'}})
+    salida.append({'ph': 'M', 'name': 'process_name', 'pid': PID_TAREAS, 'args': {'name': 'Tareas'}})
+    vistas = set()
+
+    def nombre_tarea(handle):
+        return tareas.get(handle, f'0x{handle:08x}')
+
+    for nucleo, evs in enumerate(eventos):
+        ts = tiempos(evs)
+        if ts is None:
+            print(f'CPU{nucleo}: sin sincronías, se omite ({len(evs)} eventos)', file=sys.stderr)
+            continue
+        meta(PID_CPU, nucleo, f'CPU{nucleo}')
+        actual = None          # Tarea en ejecución (handle)
+        desde = None           # Desde cuándo
+        for (_, dato, tipo, arg), t in zip(evs, ts):
+            if tipo == SINCRONIA:
+                continue
+            if tipo == TAREA_ENTRA:
+                if actual is not None:
+                    salida.append({'ph': 'X', 'name': nombre_tarea(actual), 'pid': PID_CPU,
+                                   'tid': nucleo, 'ts': desde, 'dur': t - desde})
+                actual, desde = dato, t
+                continue
+            # El resto va en la pista de la tarea que lo apuntó (0 si aún no se sabe)
+            tid = actual if actual is not None else 0
+            if tid not in vistas:
+                vistas.add(tid)
+                meta(PID_TAREAS, tid, nombre_tarea(tid) if actual is not None else '?')
+            comun = {'pid': PID_TAREAS, 'tid': tid, 'ts': t}
+            if tipo == DHT_INICIO:
+                salida.append({**comun, 'ph': 'B', 'name': 'dht11_read', 'args': {'gpio': arg}})
+            elif tipo == DHT_FIN:
+                salida.append({**comun, 'ph': 'E', 'args': {'err': _con_signo(dato)}})
+            elif tipo == HTTP_INICIO:
+                nombre = uris[arg] if arg < len(uris) else f'uri {arg}'
+                salida.append({**comun, 'ph': 'B', 'name': nombre})
+            elif tipo == HTTP_FIN:
+                salida.append({**comun, 'ph': 'E', 'args': {'err': _con_signo(dato)}})
+            elif tipo == MQTT:
+                evento = EVENTOS_MQTT.get(arg, str(arg))
+                salida.append({**comun, 'ph': 'i', 's': 't', 'name': f'mqtt {evento}',
+                               'args': {'msg_id': _con_signo(dato)}})
+            elif tipo == MQTT_PUBLICA:
+                salida.append({**comun, 'ph': 'i', 's': 't', 'name': 'mqtt publish',
+                               'args': {'qos': arg, 'msg_id': _con_signo(dato)}})
+            elif tipo == GPIO:
+                salida.append({**comun, 'ph': 'i', 's': 't', 'name': f'GPIO{arg}={dato}'})
+                salida.append({'ph': 'C', 'name': f'GPIO{arg}', 'pid': PID_CPU, 'ts': t,
+                               'args': {'nivel': dato}})
+        if actual is not None and ts:
+            salida.append({'ph': 'X', 'name': nombre_tarea(actual), 'pid': PID_CPU,
+                           'tid': nucleo, 'ts': desde, 'dur': ts[-1] - desde})
+    return {'traceEvents': salida, 'displayTimeUnit': 'ns'}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('ip', nargs='?', help='IP del ESP32')
+    parser.add_argument('-f', '--fichero', help='Traza ya descargada (en vez de la IP)')
+    parser.add_argument('-o', '--salida', default='traza.json')
+    parser.add_argument('--guardar', help='Guardar también la traza binaria')
+    args = parser.parse_args()
+
+    if args.fichero:
+        with open(args.fichero, 'rb') as f:
+            datos = f.read()
+    elif args.ip:
+        import requests
+        r = requests.get(f'http://{args.ip}/api/traza', timeout=10)
+        r.raise_for_status()
+        datos = r.content
+    else:
+        parser.error('Falta la IP o -f')
+    if args.guardar:
+        with open(args.guardar, 'wb') as f:
+            f.write(datos)
+
+    tareas, uris, eventos = leer(datos)
+    traza = convertir(tareas, uris, eventos)
+    with open(args.salida, 'w') as f:
+        json.dump(traza, f)
+    print(f'{sum(len(e) for e in eventos)} eventos de {len(eventos)} núcleos -> {args.salida}')
+
+
+if __name__ == "__main__":
+    main()
@@ -1,46 +1,138 @@
 #!/usr/bin/env python3
+import io
 import sys
+import argparse
+import time
+import zlib
+import hashlib
+import tempfile
 import requests
 from pathlib import Path
+import ota_delta
 
-def upload_firmware(ip, firmware_path):
+CHUNK = 16 * 1024
+VENTANA_BITS = 12  # Debe coincidir con OTA_VENTANA_BITS del firmware (ventana de 4 KB)
+
+def sha256_archivo(path):
+    h = hashlib.sha256()
+    with open(path, 'rb') as f:
+        for bloque in iter(lambda: f.read(CHUNK), b''):
+            h.update(bloque)
+    return h.hexdigest()
+
+def comprimir_archivo(f, destino):
+    """Comprime `f` en formato zlib con ventana de 4 KB, por partes, hacia `destino`.
+    Devuelve el tamaño comprimido y deja `destino` al principio."""
+    z = zlib.compressobj(9, zlib.DEFLATED, VENTANA_BITS, 9)
+    for bloque in iter(lambda: f.read(CHUNK), b''):
+        destino.write(z.compress(bloque))
+    destino.write(z.flush())
+    total = destino.tell()
+    destino.seek(0)
+    return total
+
+class LectorConProgreso:
+    """Envuelve el archivo para que requests lo envíe por partes (con Content-Length)
+    sin cargarlo entero en memoria, mostrando el progreso a medida que sale."""
+
+    def __init__(self, f, total):
+        self.f = f
+        self.total = total
+        self.enviado = 0
+        self.t0 = time.monotonic()
+
+    def __len__(self):
+        return self.total
+
+    def read(self, n=-1):
+        bloque = self.f.read(CHUNK if n is None or n < 0 else min(n, CHUNK))
+        self.enviado += len(bloque)
+        dt = max(time.monotonic() - self.t0, 1e-3)
+        pct = 100 * self.enviado // self.total if self.total else 100
+        print(f"\r  {pct:3d}% {self.enviado // 1024}/{self.total // 1024} KB "
+              f"({self.enviado / 1024 / dt:.0f} KB/s)", end='', flush=True)
+        return bloque
+
+def preparar_delta(ip, base_path, firmware_path):
+    """Parche contra base_path, comprobando antes que es la imagen que ejecuta el ESP32."""
+    base = Path(base_path).read_bytes()
+    sha_base = ota_delta.sha256_imagen(base)
+    info = requests.get(f"http://{ip}/update", timeout=10).json()
+    if info.get('sha256') != sha_base:
+        raise ValueError(f"{base_path} no es la imagen en ejecución "
+                         f"({info.get('particion')} {info.get('version')}, SHA-256 {info.get('sha256')})")
+    nuevo = Path(firmware_path).read_bytes()
+    parche = ota_delta.crear_parche(base, nuevo)
+    if ota_delta.aplicar_parche(base, parche) != nuevo:
+        raise ValueError("el parche no reproduce la imagen nueva")
+    print(f"Parche delta contra {info.get('version')}: {len(parche)} bytes sin comprimir")
+    return sha_base, parche
+
+def upload_firmware(ip, firmware_path, comprimir=False, base_path=None):
     url = f"http://{ip}/update"
-    
+
     print(f"Subiendo firmware a {url}...")
     print(f"Archivo: {firmware_path}")
-    
+
     try:
-        with open(firmware_path, 'rb') as f:
-            firmware_data = f.read()
-            
-        headers = {'Content-Type': 'application/octet-stream'}
-        response = requests.post(url, data=firmware_data, headers=headers, timeout=60)
-        
+        tamano = Path(firmware_path).stat().st_size
+        digest = sha256_archivo(firmware_path)
+        print(f"Tamaño: {tamano} bytes, SHA-256: {digest}")
+
+        headers = {
+            'Content-Type': 'application/octet-stream',
+            'X-OTA-SHA256': digest,  # De la imagen sin comprimir; el ESP32 lo comprueba antes de cambiar de imagen
+        }
+        if base_path:
+            # El parche son sobre todo diferencias a cero: siempre se envía comprimido
+            sha_base, parche = preparar_delta(ip, base_path, firmware_path)
+            headers['X-OTA-Base-SHA256'] = sha_base
+            comprimir = True
+
+        with tempfile.TemporaryFile() as tmp:
+            if comprimir:
+                with (io.BytesIO(parche) if base_path else open(firmware_path, 'rb')) as origen:
+                    total = comprimir_archivo(origen, tmp)
+                print(f"Enviando: {total} bytes ({100 * total / tamano:.1f}% de la imagen)")
+                headers['Content-Encoding'] = 'deflate'
+                f = tmp
+            else:
+                total = tamano
+                f = open(firmware_path, 'rb')
+            with f:
+                # timeout = (conexión, espera de respuesta tras enviar la imagen)
+                response = requests.post(url, data=LectorConProgreso(f, total),
+                                         headers=headers, timeout=(10, 60))
+        print()
+
         if response.status_code == 200:
             print("✓ Firmware subido exitosamente!")
+            print(response.text)
             print("El ESP32 se reiniciará en unos segundos...")
             return 0
         else:
             print(f"✗ Error: {response.status_code}")
             print(response.text)
             return 1
-            
+
     except FileNotFoundError:
         print(f"✗ Error: No se encontró el archivo {firmware_path}")
         return 1
     except requests.exceptions.RequestException as e:
-        print(f"✗ Error de conexión: {e}")
+        print(f"\n✗ Error de conexión: {e}")
         return 1
     except Exception as e:
-        print(f"✗ Error: {e}")
+        print(f"\n✗ Error: {e}")
         return 1
 
 if __name__ == "__main__":
-    if len(sys.argv) < 3:
-        print("Uso: python upload_ota.py <IP> <ruta_firmware.bin>")
-        sys.exit(1)
-    
-    ip = sys.argv[1]
-    firmware_path = sys.argv[2]
-    
-    sys.exit(upload_firmware(ip, firmware_path))
+    parser = argparse.ArgumentParser(description="Actualiza el firmware del ESP32 por HTTP (POST /update)")
+    parser.add_argument('ip')
+    parser.add_argument('firmware', help="ruta del firmware.bin nuevo")
+    parser.add_argument('--deflate', action='store_true',
+                        help="enviar la imagen comprimida (el ESP32 la descomprime al vuelo)")
+    parser.add_argument('--delta', metavar='BASE_BIN',
+                        help="enviar solo un parche contra BASE_BIN, que debe ser la imagen en ejecución")
+    args = parser.parse_args()
+
+    sys.exit(upload_firmware(args.ip, args.firmware, comprimir=args.deflate, base_path=args.delta))
@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+"""Genera src/web_ui.c con la interfaz web comprimida (gzip) y su ETag.
+
+Ejecutar tras modificar web/index.html:
+    python web/gen_web_ui.py
+
+El resultado se versiona para que la compilación no dependa de Python.
+"""
+import gzip
+import hashlib
+from pathlib import Path
+
+RAIZ = Path(__file__).resolve().parent.parent
+ORIGEN = RAIZ / "web" / "index.html"
+DESTINO = RAIZ / "src" / "web_ui.c"
+
+
+def main():
+    html = ORIGEN.read_bytes()
+    # mtime=0: salida determinista, el ETag solo cambia si cambia el contenido
+    gz = gzip.compress(html, compresslevel=9, mtime=0)
+    etag = hashlib.sha256(html).hexdigest()[:16]
+
+    lineas = []
+    for i in range(0, len(gz), 16):
+        lineas.append("    " + " ".join(f"0x{b:02x}," for b in gz[i:i + 16]))
+
+    DESTINO.write_text(
+        "// Generado por web/gen_web_ui.py a partir de web/index.html. No editar.\n"
+        '#include "web_ui.h"\n'
+        "\n"
+        f"// {len(html)} bytes sin comprimir\n"
+        "const uint8_t web_ui_index_gz[] = {\n"
+        + "\n".join(lineas) + "\n"
+        "};\n"
+        "const size_t web_ui_index_gz_len = sizeof(web_ui_index_gz);\n"
+        f'const char web_ui_etag[] = "\\"{etag}\\"";\n',
+        encoding="utf-8",
+        newline="\r\n",
+    )
+    print(f"{DESTINO.relative_to(RAIZ)}: {len(html)} -> {len(gz)} bytes, ETag {etag}")
+
+
+if __name__ == "__main__":
+    main()